@@ -1,3 +1,4 @@
+#include <IEngine.h>
 #include <Windows.h>
 
 #include <dbghelp.h>
@@ -10,6 +11,9 @@ LPCWSTR g_szAppName = L"direct-3d-playground";
 
 LONG WINAPI ExceptionFilter(EXCEPTION_POINTERS* ExceptionInfo)
 {
+    // First, while the heap may still be usable; the dump itself does not allocate
+    IEngine::DumpFlightRecorder();
+
     HANDLE process = GetCurrentProcess();
 
     SymInitialize(process, NULL, TRUE);
@@ -0,0 +1,57 @@
+// Helpers the benches share: best-of-N timing and a test camera frustum
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Culling.h"
+
+namespace bench
+{
+
+// Fastest of `iterations` runs of fn, in the unit of `Period`
+template <typename Period, typename Fn>
+double Best(int iterations, Fn&& fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::duration<double, Period>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+template <typename Fn>
+double BestUs(int iterations, Fn&& fn)
+{
+    return Best<std::micro>(iterations, fn);
+}
+
+template <typename Fn>
+double BestMs(int iterations, Fn&& fn)
+{
+    return Best<std::milli>(iterations, fn);
+}
+
+// XMMatrixPerspectiveFovLH with the camera looking down +z from `back` units
+// behind the origin
+inline canvas::Frustum MakeFrustum(float fovY, float aspect, float nearZ, float farZ, float back = 0.0f)
+{
+    float h = 1.0f / std::tan(fovY * 0.5f);
+    float w = h / aspect;
+    float range = farZ / (farZ - nearZ);
+
+    float m[4][4] = {
+        {w, 0.0f, 0.0f, 0.0f},
+        {0.0f, h, 0.0f, 0.0f},
+        {0.0f, 0.0f, range, 1.0f},
+        {0.0f, 0.0f, -range * nearZ + range * back, back},
+    };
+    return canvas::FrustumFromMatrix(m);
+}
+
+} // namespace bench
@@ -0,0 +1,130 @@
+// Builds a Bvh over random spheres, culls them against a perspective frustum through
+// the tree and linearly with CullSpheres, then lets 1% of them drift for a while and
+// times the refits. Checks the tree always returns the same set as the linear cull.
+//
+// usage: bvhbench [objects=10000,100000,1000000] [iterations=10]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Bvh.h"
+
+using namespace bench;
+using namespace canvas;
+
+namespace
+{
+
+bool SameSet(std::vector<uint32_t> a, size_t aCount, std::vector<uint32_t> b, size_t bCount)
+{
+    a.resize(aCount);
+    b.resize(bCount);
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+bool Run(size_t count, int iterations)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+    std::vector<float> x(count), y(count), z(count), radius(count);
+    for (size_t i = 0; i < count; i++) {
+        x[i] = position(rng);
+        y[i] = position(rng);
+        z[i] = position(rng);
+        radius[i] = size(rng);
+    }
+
+    SphereBoundsSoA spheres{x.data(), y.data(), z.data(), radius.data(), count};
+    Frustum frustum = MakeFrustum(0.785398f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    std::vector<uint32_t> linear(count), tree(count);
+
+    Bvh bvh;
+    double buildUs = BestUs(std::max(1, iterations / 5), [&] { bvh.Build(spheres); });
+
+    size_t linearCount = 0, treeCount = 0;
+    double linearUs = BestUs(iterations, [&] { linearCount = CullSpheres(frustum, spheres, linear.data()); });
+    double treeUs = BestUs(iterations, [&] { treeCount = bvh.Cull(frustum, spheres, tree.data()); });
+    bool ok = SameSet(linear, linearCount, tree, treeCount);
+
+    // 1% drift every frame, a different 1% each time
+    constexpr int Frames = 60;
+    size_t movedCount = std::max<size_t>(1, count / 100);
+    std::vector<uint32_t> moved(movedCount);
+    double refitUs = 0.0;
+
+    for (int frame = 0; frame < Frames; frame++) {
+        for (uint32_t& i : moved) {
+            i = static_cast<uint32_t>(rng() % count);
+            x[i] += step(rng);
+            y[i] += step(rng);
+            z[i] += step(rng);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bvh.Refit(spheres, moved);
+        refitUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    linearCount = CullSpheres(frustum, spheres, linear.data());
+    treeCount = bvh.Cull(frustum, spheres, tree.data());
+    ok = ok && SameSet(linear, linearCount, tree, treeCount);
+
+    std::vector<uint32_t> all(count);
+    for (size_t i = 0; i < count; i++)
+        all[i] = static_cast<uint32_t>(i);
+    double sweepUs = BestUs(iterations, [&] { bvh.Refit(spheres, all); });
+
+    printf(
+        "%8zu %7zu %9.0f %10.1f %10.1f %6.1fx %10.1f %10.1f %8.2f  %s\n",
+        count,
+        linearCount,
+        buildUs,
+        linearUs,
+        treeUs,
+        linearUs / treeUs,
+        refitUs / Frames,
+        sweepUs,
+        bvh.Cost() / bvh.BuiltCost(),
+        ok ? "ok" : "MISMATCH"
+    );
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts = {10000, 100000, 1000000};
+    if (argc > 1) counts = {std::max<size_t>(1, std::strtoull(argv[1], nullptr, 10))};
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+    if (iterations <= 0) iterations = 1;
+
+    printf(
+        "%8s %7s %9s %10s %10s %7s %10s %10s %8s\n",
+        "objects",
+        "visible",
+        "build us",
+        "linear us",
+        "bvh us",
+        "speedup",
+        "refit1% us",
+        "refit us",
+        "quality"
+    );
+
+    bool ok = true;
+    for (size_t count : counts)
+        ok = Run(count, iterations) && ok;
+
+    return ok ? 0 : 1;
+}
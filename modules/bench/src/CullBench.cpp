@@ -0,0 +1,105 @@
+// Culls random spheres and AABBs against a perspective frustum on one core and
+// reports ns per object for every path the CPU supports.
+//
+// usage: cullbench [objects=1000000] [iterations=20]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Culling.h"
+
+using namespace bench;
+using namespace canvas;
+
+namespace
+{
+
+const char* PathName(CullPath path)
+{
+    switch (path) {
+    case CullPath::SCALAR:
+        return "scalar";
+    case CullPath::SSE:
+        return "sse";
+    case CullPath::AVX2:
+        return "avx2";
+    default:
+        return "auto";
+    }
+}
+
+template <typename Fn>
+double BestNsPerObject(size_t objects, int iterations, Fn&& fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        best = std::min(best, elapsed.count() / static_cast<double>(objects));
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    if (count == 0) count = 1;
+    if (iterations <= 0) iterations = 1;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    std::vector<float> x(count), y(count), z(count), radius(count);
+    std::vector<float> ex(count), ey(count), ez(count);
+
+    for (size_t i = 0; i < count; i++) {
+        x[i] = position(rng);
+        y[i] = position(rng);
+        z[i] = position(rng);
+        radius[i] = size(rng);
+        ex[i] = size(rng);
+        ey[i] = size(rng);
+        ez[i] = size(rng);
+    }
+
+    SphereBoundsSoA spheres{x.data(), y.data(), z.data(), radius.data(), count};
+    AabbBoundsSoA boxes{x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), count};
+
+    Frustum frustum = MakeFrustum(0.785398f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    std::vector<uint32_t> visible(count);
+
+    std::vector<CullPath> paths = {CullPath::SCALAR};
+    if (BestCullPath() != CullPath::SCALAR) paths.push_back(CullPath::SSE);
+    if (BestCullPath() == CullPath::AVX2) paths.push_back(CullPath::AVX2);
+
+    printf("%zu objects, best of %d runs, best path %s\n", count, iterations, PathName(BestCullPath()));
+    printf("%-8s %-7s %12s %10s\n", "bounds", "path", "ns/object", "visible");
+
+    for (CullPath path : paths) {
+        size_t n = 0;
+        double ns = BestNsPerObject(count, iterations, [&] {
+            n = CullSpheres(frustum, spheres, visible.data(), path);
+        });
+        printf("%-8s %-7s %12.3f %10zu\n", "sphere", PathName(path), ns, n);
+    }
+
+    for (CullPath path : paths) {
+        size_t n = 0;
+        double ns = BestNsPerObject(count, iterations, [&] {
+            n = CullAabbs(frustum, boxes, visible.data(), path);
+        });
+        printf("%-8s %-7s %12.3f %10zu\n", "aabb", PathName(path), ns, n);
+    }
+
+    return 0;
+}
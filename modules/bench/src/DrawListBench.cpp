@@ -0,0 +1,344 @@
+// Steady-state CPU cost of producing a frame's draw packets for static objects:
+// the old per-frame rebuild (copy mesh views, push_back into a fresh vector) against
+// the retained DrawList patched on visibility changes. Both paths cull and write
+// per-draw constants the same way, only the list handling differs.
+//
+// usage: drawlistbench [objects=10000] [frames=2000] [static|pan]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Culling.h"
+#include "DrawList.h"
+#include "SceneStorage.h"
+
+using namespace canvas;
+
+// Counts heap allocations made while a frame is timed
+static size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+
+// Same shape and size as the D3D12 types in DrawItem.h / Scene.h
+struct BufferView
+{
+    uint64_t location;
+    uint32_t size;
+    uint32_t strideOrFormat;
+};
+
+struct SubmeshRange
+{
+    uint32_t indexCount;
+    uint32_t startIndex;
+    int32_t baseVertex;
+    uint32_t topology;
+};
+
+struct MeshViews
+{
+    BufferView vbv;
+    BufferView ibv;
+    std::vector<SubmeshRange> parts;
+};
+
+struct DrawItem
+{
+    uint32_t psoType;
+    uint32_t topology;
+    uint32_t countPerInstance;
+    uint32_t instanceCount;
+    BufferView vbv;
+    BufferView ibv;
+    uint64_t srv;
+    uint64_t vsCB;
+    uint64_t psCB;
+};
+
+struct alignas(256) ShaderConstants
+{
+    Matrix4 model;
+    Matrix4 modelRotated;
+    Matrix4 viewProjection;
+    float time;
+};
+
+constexpr uint32_t MeshCount = 16;
+constexpr size_t RingSize = 16384;
+
+struct Fixture
+{
+    SceneStorage storage;
+    std::unordered_map<uint32_t, MeshViews> meshes;
+    std::vector<ShaderConstants> ring = std::vector<ShaderConstants>(RingSize);
+    size_t ringOffset = 0;
+    std::vector<uint32_t> visible;
+
+    uint64_t WritePerDrawCB(const ShaderConstants& constants)
+    {
+        size_t slot = ringOffset++ % RingSize;
+        ring[slot] = constants;
+        return 0x10000 + slot * sizeof(ShaderConstants);
+    }
+};
+
+// Returns by value like ResourceHolder::GetMeshViews used to
+MeshViews GetMeshViewsCopy(Fixture& f, uint32_t mesh)
+{
+    auto resource = f.meshes.at(mesh);
+    return resource;
+}
+
+DrawItem MakeDrawItem(const MeshViews& views, const SubmeshRange& submesh, uint32_t pso)
+{
+    DrawItem di{};
+    di.vbv = views.vbv;
+    di.ibv = views.ibv;
+    di.topology = submesh.topology;
+    di.countPerInstance = submesh.indexCount;
+    di.psoType = pso;
+    di.instanceCount = 1;
+    return di;
+}
+
+// Camera at the origin turned `yaw` radians around y, XMMatrixPerspectiveFovLH projection
+Frustum MakeFrustum(float yaw)
+{
+    float h = 1.0f / std::tan(0.785398f * 0.5f);
+    float w = h / (16.0f / 9.0f);
+    float nearZ = 0.1f, farZ = 1000.0f;
+    float range = farZ / (farZ - nearZ);
+
+    float c = std::cos(yaw), s = std::sin(yaw);
+    // view = inverse rotation, then projection
+    float m[4][4] = {
+        {c * w, 0.0f, s * range, s},
+        {0.0f, h, 0.0f, 0.0f},
+        {-s * w, 0.0f, c * range, c},
+        {0.0f, 0.0f, -range * nearZ, 0.0f},
+    };
+    return FrustumFromMatrix(m);
+}
+
+ShaderConstants Constants(const Matrix4& world)
+{
+    ShaderConstants constants{};
+    constants.model = world;
+    constants.modelRotated = world;
+    return constants;
+}
+
+// MARK: - Rebuild
+
+size_t RebuildFrame(Fixture& f, const Frustum& frustum, std::vector<DrawItem>& out)
+{
+    std::vector<DrawItem> drawItems;
+
+    f.visible.resize(f.storage.Size());
+    size_t visibleCount = CullSpheres(frustum, f.storage.Bounds(), f.visible.data());
+
+    for (size_t v = 0; v < visibleCount; v++) {
+        uint32_t i = f.visible[v];
+        auto views = GetMeshViewsCopy(f, f.storage.Meshes()[i]);
+        uint64_t cb = f.WritePerDrawCB(Constants(f.storage.World()[i]));
+
+        for (auto submesh : views.parts) {
+            DrawItem di = MakeDrawItem(views, submesh, f.storage.Psos()[i]);
+            di.vsCB = cb;
+            drawItems.push_back(di);
+        }
+    }
+
+    out = std::move(drawItems);
+    return out.size();
+}
+
+// MARK: - Retained
+
+struct Retained
+{
+    DrawList<DrawItem> list;
+    std::vector<DrawList<DrawItem>::Handle> handles;
+    std::vector<uint32_t> wasVisible;
+};
+
+void SetDrawsVisible(Fixture& f, Retained& r, uint32_t i, bool visible)
+{
+    const DrawRange& range = f.storage.Draws()[i];
+    f.storage.Flags()[i] ^= ENTITY_VISIBLE;
+    for (uint32_t k = 0; k < range.count; k++) {
+        r.list.SetVisible(r.handles[range.first + k], visible);
+    }
+}
+
+// Mirrors Scene::MakeDrawItems
+size_t RetainedFrame(Fixture& f, Retained& r, const Frustum& frustum)
+{
+    for (uint32_t slot : f.storage.DirtySlots()) {
+        uint32_t i = f.storage.IndexOfSlot(slot);
+        const MeshViews& views = f.meshes.at(f.storage.Meshes()[i]);
+        bool visible = f.storage.Flags()[i] & ENTITY_VISIBLE;
+
+        f.storage.Draws()[i] = {static_cast<uint32_t>(r.handles.size()), static_cast<uint32_t>(views.parts.size())};
+        for (const auto& submesh : views.parts) {
+            r.handles.push_back(r.list.Add(MakeDrawItem(views, submesh, f.storage.Psos()[i]), slot, visible));
+        }
+    }
+    f.storage.ClearDirty();
+
+    f.visible.resize(f.storage.Size());
+    size_t visibleCount = CullSpheres(frustum, f.storage.Bounds(), f.visible.data());
+
+    size_t a = 0, b = 0;
+    while (a < r.wasVisible.size() || b < visibleCount) {
+        if (b == visibleCount || (a < r.wasVisible.size() && r.wasVisible[a] < f.visible[b])) {
+            SetDrawsVisible(f, r, r.wasVisible[a++], false);
+        }
+        else if (a == r.wasVisible.size() || f.visible[b] < r.wasVisible[a]) {
+            SetDrawsVisible(f, r, f.visible[b++], true);
+        }
+        else {
+            a++;
+            b++;
+        }
+    }
+
+    f.visible.resize(visibleCount);
+    std::swap(f.visible, r.wasVisible);
+
+    auto packets = r.list.Visible();
+    auto owners = r.list.VisibleOwners();
+    for (size_t p = 0; p < packets.size(); p++) {
+        uint32_t i = f.storage.IndexOfSlot(owners[p]);
+        packets[p].vsCB = f.WritePerDrawCB(Constants(f.storage.World()[i]));
+    }
+
+    return packets.size();
+}
+
+struct Result
+{
+    double meanUs;
+    double p99Us;
+    double allocationsPerFrame;
+    size_t draws;
+};
+
+template <typename Fn>
+Result Run(int frames, bool pan, Fn&& frame)
+{
+    std::vector<double> times;
+    times.reserve(frames);
+    size_t draws = 0;
+    size_t allocations = 0;
+
+    for (int n = -50; n < frames; n++) {
+        Frustum frustum = MakeFrustum(pan ? 0.002f * static_cast<float>(n) : 0.0f);
+
+        size_t before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        draws = frame(frustum);
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        // Warm-up frames fill caches and the retained list
+        if (n < 0) continue;
+        allocations += g_allocations - before;
+        times.push_back(elapsed.count());
+    }
+
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for (double t : times)
+        sum += t;
+
+    return {
+        sum / static_cast<double>(times.size()),
+        times[std::min(times.size() - 1, times.size() * 99 / 100)],
+        static_cast<double>(allocations) / static_cast<double>(frames),
+        draws,
+    };
+}
+
+void Populate(Fixture& f, size_t objects)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+
+    for (uint32_t mesh = 1; mesh <= MeshCount; mesh++) {
+        MeshViews views{};
+        views.vbv = {mesh * 0x1000ull, 4096, 24};
+        views.ibv = {mesh * 0x1000ull + 0x800, 2048, 57};
+        views.parts.push_back({36, 0, 0, 4});
+        f.meshes[mesh] = views;
+    }
+
+    for (size_t i = 0; i < objects; i++) {
+        EntityDesc desc;
+        desc.position[0] = position(rng);
+        desc.position[1] = position(rng);
+        desc.position[2] = position(rng);
+        desc.radius = size(rng);
+        desc.mesh = 1 + static_cast<uint32_t>(i % MeshCount);
+        f.storage.Create(desc);
+    }
+    f.storage.UpdateTransforms();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 2000;
+    bool pan = argc > 3 && std::string(argv[3]) == "pan";
+    if (frames <= 0) frames = 1;
+
+    Fixture rebuildFixture;
+    Fixture retainedFixture;
+    Populate(rebuildFixture, objects);
+    Populate(retainedFixture, objects);
+
+    std::vector<DrawItem> rebuilt;
+    Result rebuild = Run(frames, pan, [&](const Frustum& frustum) {
+        return RebuildFrame(rebuildFixture, frustum, rebuilt);
+    });
+
+    Retained retained;
+    Result patched = Run(frames, pan, [&](const Frustum& frustum) {
+        return RetainedFrame(retainedFixture, retained, frustum);
+    });
+
+    printf("%zu static objects, %d frames, camera %s\n", objects, frames, pan ? "panning" : "still");
+    printf("%-9s %10s %10s %12s %8s\n", "list", "mean us", "p99 us", "allocs/frame", "draws");
+    printf("%-9s %10.2f %10.2f %12.1f %8zu\n", "rebuild", rebuild.meanUs, rebuild.p99Us, rebuild.allocationsPerFrame, rebuild.draws);
+    printf("%-9s %10.2f %10.2f %12.1f %8zu\n", "retained", patched.meanUs, patched.p99Us, patched.allocationsPerFrame, patched.draws);
+
+    return 0;
+}
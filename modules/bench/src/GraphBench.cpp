@@ -0,0 +1,345 @@
+// Compiles a deferred frame (G-buffer, shadow cascades resolved one at a time, SSAO,
+// lighting, bloom, tonemap, UI and a debug view nothing reads) and a batch of random graphs with
+// RenderGraph, then replays each compiled graph against the declared accesses:
+// every access finds its resource in the declared state, imports end in their final
+// state, transients alive at the same time never share memory and every transient
+// that takes memory over gets an aliasing barrier first. Times Compile and compares
+// barriers and memory with a plain one-transition-per-change, one-allocation-per-
+// texture frame.
+//
+// usage: graphbench [randomGraphs=1000] [iterations=1000]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "RenderGraph.h"
+
+using namespace bench;
+using namespace canvas;
+
+namespace
+{
+
+constexpr uint64_t Alignment = 65536;
+
+struct Declared
+{
+    GraphPass pass;
+    GraphResource resource;
+    uint32_t state;
+    bool write;
+};
+
+// Declares through the graph and keeps a copy to check the compiled result against
+struct Builder
+{
+    RenderGraph& graph;
+    std::vector<Declared> accesses = {};
+    std::vector<uint32_t> finalState = {}; // imports only
+
+    GraphResource Import(const char* name, uint32_t initial, uint32_t final)
+    {
+        GraphResource r = graph.Import(name, initial, final);
+        finalState.resize(r + 1, 0);
+        finalState[r] = final;
+        return r;
+    }
+
+    GraphResource Texture(const char* name, uint32_t width, uint32_t height, uint32_t bytesPerPixel, TextureUsage usage = TextureUsage::RENDER_TARGET)
+    {
+        TransientDesc desc;
+        desc.width = width;
+        desc.height = height;
+        desc.usage = usage;
+        desc.size = (uint64_t(width) * height * bytesPerPixel + Alignment - 1) / Alignment * Alignment;
+        desc.alignment = Alignment;
+
+        GraphResource r = graph.CreateTransient(name, desc);
+        finalState.resize(r + 1, 0);
+        return r;
+    }
+
+    void Read(GraphPass pass, GraphResource r, uint32_t state)
+    {
+        graph.Read(pass, r, state);
+        accesses.push_back({pass, r, state, false});
+    }
+
+    void Write(GraphPass pass, GraphResource r, uint32_t state)
+    {
+        graph.Write(pass, r, state);
+        accesses.push_back({pass, r, state, true});
+    }
+};
+
+// MARK: - Frames
+
+void DeferredFrame(Builder& b)
+{
+    constexpr uint32_t W = 1920, H = 1080;
+    RenderGraph& g = b.graph;
+
+    GraphResource backBuffer = b.Import("Back buffer", RESOURCE_STATE_COMMON, RESOURCE_STATE_COMMON);
+
+    GraphResource albedo = b.Texture("Albedo", W, H, 4);
+    GraphResource normals = b.Texture("Normals", W, H, 8);
+    GraphResource depth = b.Texture("Depth", W, H, 4, TextureUsage::DEPTH_STENCIL);
+    GraphPass gbuffer = g.AddPass("G-buffer");
+    b.Write(gbuffer, albedo, RESOURCE_STATE_RENDER_TARGET);
+    b.Write(gbuffer, normals, RESOURCE_STATE_RENDER_TARGET);
+    b.Write(gbuffer, depth, RESOURCE_STATE_DEPTH_WRITE);
+
+    // Each cascade is resolved into a screen-space mask before the next one renders
+    static const char* cascadeNames[] = {"Shadow 0", "Shadow 1", "Shadow 2", "Shadow 3"};
+    GraphResource mask = b.Texture("Shadow mask", W, H, 1);
+    for (int c = 0; c < 4; c++) {
+        GraphResource cascade = b.Texture(cascadeNames[c], 2048, 2048, 4, TextureUsage::DEPTH_STENCIL);
+        GraphPass pass = g.AddPass(cascadeNames[c]);
+        b.Write(pass, cascade, RESOURCE_STATE_DEPTH_WRITE);
+
+        GraphPass resolve = g.AddPass("Shadow resolve");
+        b.Read(resolve, cascade, RESOURCE_STATE_SHADER_READ);
+        b.Read(resolve, depth, RESOURCE_STATE_SHADER_READ);
+        b.Write(resolve, mask, RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    GraphResource ao = b.Texture("SSAO", W, H, 1);
+    GraphPass ssao = g.AddPass("SSAO");
+    b.Read(ssao, depth, RESOURCE_STATE_SHADER_READ);
+    b.Read(ssao, normals, RESOURCE_STATE_SHADER_READ);
+    b.Write(ssao, ao, RESOURCE_STATE_UNORDERED_ACCESS);
+
+    GraphPass ssaoBlur = g.AddPass("SSAO blur");
+    b.Write(ssaoBlur, ao, RESOURCE_STATE_UNORDERED_ACCESS);
+
+    GraphResource hdr = b.Texture("HDR", W, H, 8);
+    GraphPass lighting = g.AddPass("Lighting");
+    b.Read(lighting, albedo, RESOURCE_STATE_SHADER_READ);
+    b.Read(lighting, normals, RESOURCE_STATE_SHADER_READ);
+    b.Read(lighting, depth, RESOURCE_STATE_SHADER_READ);
+    b.Read(lighting, ao, RESOURCE_STATE_SHADER_READ);
+    b.Read(lighting, mask, RESOURCE_STATE_SHADER_READ);
+    b.Write(lighting, hdr, RESOURCE_STATE_RENDER_TARGET);
+
+    GraphPass transparent = g.AddPass("Transparent");
+    b.Read(transparent, depth, RESOURCE_STATE_DEPTH_READ);
+    b.Write(transparent, hdr, RESOURCE_STATE_RENDER_TARGET);
+
+    static const char* bloomNames[] = {"Bloom 1", "Bloom 2", "Bloom 3", "Bloom 4", "Bloom 5"};
+    GraphResource bloom[5];
+    GraphResource source = hdr;
+    for (int i = 0; i < 5; i++) {
+        bloom[i] = b.Texture(bloomNames[i], W >> (i + 1), H >> (i + 1), 8);
+        GraphPass down = g.AddPass(bloomNames[i]);
+        b.Read(down, source, RESOURCE_STATE_SHADER_READ);
+        b.Write(down, bloom[i], RESOURCE_STATE_RENDER_TARGET);
+        source = bloom[i];
+    }
+    for (int i = 3; i >= 0; i--) {
+        GraphPass up = g.AddPass("Bloom up");
+        b.Read(up, bloom[i + 1], RESOURCE_STATE_SHADER_READ);
+        b.Write(up, bloom[i], RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    GraphPass tonemap = g.AddPass("Tonemap");
+    b.Read(tonemap, hdr, RESOURCE_STATE_SHADER_READ);
+    b.Read(tonemap, bloom[0], RESOURCE_STATE_SHADER_READ);
+    b.Write(tonemap, backBuffer, RESOURCE_STATE_RENDER_TARGET);
+
+    GraphPass ui = g.AddPass("UI");
+    b.Write(ui, backBuffer, RESOURCE_STATE_RENDER_TARGET);
+
+    GraphResource debug = b.Texture("Debug", W, H, 4);
+    GraphPass debugView = g.AddPass("Debug view");
+    b.Read(debugView, normals, RESOURCE_STATE_SHADER_READ);
+    b.Write(debugView, debug, RESOURCE_STATE_RENDER_TARGET);
+}
+
+// Passes touch random earlier-written resources; the last one writes the import
+void RandomFrame(Builder& b, std::mt19937& rng, uint32_t passes, uint32_t textures)
+{
+    static const uint32_t writes[] = {RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_DEPTH_WRITE, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_DEST};
+    static const uint32_t reads[] = {RESOURCE_STATE_SHADER_READ, RESOURCE_STATE_DEPTH_READ, RESOURCE_STATE_COPY_SOURCE};
+
+    GraphResource output = b.Import("Output", RESOURCE_STATE_COMMON, RESOURCE_STATE_COMMON);
+    std::vector<GraphResource> written;
+    std::vector<GraphResource> all;
+    for (uint32_t t = 0; t < textures; t++) {
+        uint32_t side = 64u << (rng() % 6);
+        all.push_back(b.Texture("Random", side, side, 1 + rng() % 8));
+    }
+
+    for (uint32_t p = 0; p < passes; p++) {
+        GraphPass pass = b.graph.AddPass("Random", rng() % 16 == 0);
+        std::vector<GraphResource> touched;
+
+        for (uint32_t k = rng() % 4; k > 0 && !written.empty(); k--) {
+            GraphResource r = written[rng() % written.size()];
+            if (std::find(touched.begin(), touched.end(), r) != touched.end()) continue;
+            b.Read(pass, r, reads[rng() % 3]);
+            // Sometimes twice, in another read state
+            if (rng() % 4 == 0) b.Read(pass, r, reads[rng() % 3]);
+            touched.push_back(r);
+        }
+
+        for (uint32_t k = 1 + rng() % 2; k > 0; k--) {
+            GraphResource r = p + 1 == passes ? output : all[rng() % all.size()];
+            if (std::find(touched.begin(), touched.end(), r) != touched.end()) continue;
+            b.Write(pass, r, writes[rng() % 4]);
+            touched.push_back(r);
+            if (r != output) written.push_back(r);
+        }
+    }
+}
+
+// MARK: - Checks
+
+struct Check
+{
+    bool ok = true;
+    uint32_t naiveTransitions = 0;
+};
+
+Check Validate(const Builder& b)
+{
+    const RenderGraph& g = b.graph;
+    Check check;
+    bool& ok = check.ok;
+
+    std::vector<uint32_t> state(g.ResourceCount());
+    std::vector<uint32_t> naive(g.ResourceCount());
+    for (GraphResource r = 0; r < state.size(); r++) {
+        state[r] = g.IsTransient(r) ? g.HomeState(r) : RESOURCE_STATE_COMMON;
+        naive[r] = state[r];
+    }
+
+    auto apply = [&](std::span<const GraphBarrier> barriers) {
+        for (const GraphBarrier& barrier : barriers) {
+            if (barrier.type != BarrierType::TRANSITION) continue;
+            ok = ok && state[barrier.resource] == barrier.before;
+            state[barrier.resource] = barrier.after;
+        }
+    };
+
+    // Kept passes run in declaration order
+    GraphPass previous = 0;
+    bool first = true;
+    for (const CompiledPass& compiled : g.Order()) {
+        ok = ok && (first || compiled.pass > previous);
+        previous = compiled.pass;
+        first = false;
+
+        auto barriers = g.Barriers(compiled);
+        apply(barriers);
+
+        for (const Declared& access : b.accesses) {
+            if (access.pass != compiled.pass) continue;
+
+            uint32_t current = state[access.resource];
+            ok = ok && (access.write ? current == access.state : (current & access.state) == access.state);
+
+            if (naive[access.resource] != access.state) {
+                check.naiveTransitions++;
+                naive[access.resource] = access.state;
+            }
+
+            // A transient used for the first time first takes over its memory
+            if (g.IsTransient(access.resource) && g.FirstUse(access.resource) == &compiled - g.Order().data()) {
+                bool shares = false;
+                for (GraphResource o = 0; o < g.ResourceCount(); o++) {
+                    if (o == access.resource || !g.IsTransient(o) || g.FirstUse(o) > g.LastUse(o)) continue;
+                    shares = shares || (g.HeapOffset(o) < g.HeapOffset(access.resource) + g.Desc(access.resource).size &&
+                                        g.HeapOffset(access.resource) < g.HeapOffset(o) + g.Desc(o).size);
+                }
+                bool aliased = std::any_of(barriers.begin(), barriers.end(), [&](const GraphBarrier& barrier) {
+                    return barrier.type == BarrierType::ALIASING && barrier.resource == access.resource;
+                });
+                ok = ok && shares == aliased;
+            }
+        }
+    }
+
+    apply(g.FinalBarriers());
+    for (GraphResource r = 0; r < state.size(); r++) {
+        bool used = g.FirstUse(r) <= g.LastUse(r);
+        if (!g.IsTransient(r)) {
+            ok = ok && state[r] == b.finalState[r];
+            if (naive[r] != b.finalState[r]) check.naiveTransitions++;
+        }
+        else if (used) {
+            if (naive[r] != g.HomeState(r)) check.naiveTransitions++;
+            ok = ok && state[r] == g.HomeState(r) && g.HeapOffset(r) % g.Desc(r).alignment == 0 &&
+                 g.HeapOffset(r) + g.Desc(r).size <= g.Stats().heapSize;
+        }
+    }
+
+    // Alive at the same time means disjoint memory
+    for (GraphResource a = 0; a < g.ResourceCount(); a++) {
+        for (GraphResource c = a + 1; c < g.ResourceCount(); c++) {
+            if (!g.IsTransient(a) || !g.IsTransient(c)) continue;
+            if (g.FirstUse(a) > g.LastUse(a) || g.FirstUse(c) > g.LastUse(c)) continue;
+            if (g.LastUse(a) < g.FirstUse(c) || g.LastUse(c) < g.FirstUse(a)) continue;
+
+            bool disjoint = g.HeapOffset(a) + g.Desc(a).size <= g.HeapOffset(c) || g.HeapOffset(c) + g.Desc(c).size <= g.HeapOffset(a);
+            ok = ok && disjoint;
+        }
+    }
+
+    return check;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int randomGraphs = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (iterations <= 0) iterations = 1;
+
+    RenderGraph graph;
+    Builder frame{graph};
+    DeferredFrame(frame);
+    graph.Compile();
+
+    Check check = Validate(frame);
+    const RenderGraphStats& stats = graph.Stats();
+    printf("deferred frame: %u passes kept, %u culled\n", stats.passes, stats.culled);
+    printf("barriers: %u transitions (%u with one per state change), %u aliasing, %u uav, in %u batches\n",
+           stats.transitions, check.naiveTransitions, stats.aliasing, stats.uav, stats.batches);
+    printf("transient memory: %.1f MB aliased, %.1f MB side by side\n", stats.heapSize / 1048576.0, stats.transientSize / 1048576.0);
+
+    // Declaring and compiling, as every frame does
+    double compileUs = BestUs(iterations, [&] {
+        graph.Reset();
+        Builder again{graph};
+        DeferredFrame(again);
+        graph.Compile();
+    });
+    printf("declare + compile %.2f us\n", compileUs);
+
+    bool ok = check.ok;
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+
+    std::mt19937 rng(25);
+    int failures = 0;
+    uint64_t heap = 0, sideBySide = 0;
+    for (int i = 0; i < randomGraphs; i++) {
+        graph.Reset();
+        Builder random{graph};
+        RandomFrame(random, rng, 8 + rng() % 40, 4 + rng() % 24);
+        graph.Compile();
+
+        failures += !Validate(random).ok;
+        heap += graph.Stats().heapSize;
+        sideBySide += graph.Stats().transientSize;
+    }
+    printf("\n%d random graphs: %d failed, memory aliased to %.0f%%\n", randomGraphs, failures, sideBySide ? 100.0 * heap / sideBySide : 0.0);
+
+    ok = ok && failures == 0;
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Builds a random transform tree, moves a fraction of its nodes per frame and times
+// TransformHierarchy::Update against recomputing every world matrix, checking both
+// give the same result.
+//
+// usage: hierarchybench [nodes=100000] [frames=20]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "TransformHierarchy.h"
+
+using namespace canvas;
+
+namespace
+{
+
+Matrix4 RandomLocal(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+
+    float a = angle(rng);
+    float c = std::cos(a), s = std::sin(a);
+    return {{
+        {c, s, 0.0f, 0.0f},
+        {-s, c, 0.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {offset(rng), offset(rng), offset(rng), 1.0f},
+    }};
+}
+
+Matrix4 Multiply(const Matrix4& a, const Matrix4& b)
+{
+    Matrix4 out;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            out.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+        }
+    }
+    return out;
+}
+
+// Plain tree the reference walks; parents always precede their children
+struct Tree
+{
+    std::vector<uint32_t> parent; // UINT32_MAX for roots
+    std::vector<Matrix4> local;
+    std::vector<Matrix4> world;
+
+    void Recompute()
+    {
+        for (size_t i = 0; i < parent.size(); i++) {
+            world[i] = parent[i] == UINT32_MAX ? local[i] : Multiply(local[i], world[parent[i]]);
+        }
+    }
+};
+
+float MaxError(const Tree& tree, const TransformHierarchy& hierarchy, const std::vector<TransformHierarchy::Node>& nodes)
+{
+    float error = 0.0f;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Matrix4& a = hierarchy.World(nodes[i]);
+        const Matrix4& b = tree.world[i];
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                error = std::max(error, std::fabs(a.m[r][c] - b.m[r][c]));
+            }
+        }
+    }
+    return error;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 20;
+    if (count == 0) count = 1;
+    if (frames <= 0) frames = 1;
+
+    std::mt19937 rng(7);
+
+    // 1% roots, everything else under a random earlier node no deeper than MaxDepth
+    constexpr uint32_t MaxDepth = 6;
+
+    Tree tree;
+    tree.parent.resize(count);
+    tree.local.resize(count);
+    tree.world.resize(count);
+
+    TransformHierarchy hierarchy;
+    std::vector<TransformHierarchy::Node> nodes(count);
+    std::vector<uint32_t> depth(count, 0);
+
+    for (size_t i = 0; i < count; i++) {
+        bool root = i == 0 || rng() % 100 == 0;
+        if (root) {
+            tree.parent[i] = UINT32_MAX;
+        }
+        else {
+            uint32_t parent = static_cast<uint32_t>(rng() % i);
+            while (depth[parent] >= MaxDepth)
+                parent = tree.parent[parent];
+            tree.parent[i] = parent;
+            depth[i] = depth[parent] + 1;
+        }
+        tree.local[i] = RandomLocal(rng);
+        nodes[i] = hierarchy.Add(root ? TransformHierarchy::None : nodes[tree.parent[i]], tree.local[i], uint32_t(i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    hierarchy.Update();
+    double layoutUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    tree.Recompute();
+    float error = MaxError(tree, hierarchy, nodes);
+
+    printf("%zu nodes, %zu levels, first Update (layout + all) %.0f us\n", count, hierarchy.Depth(), layoutUs);
+    printf("%8s %9s %12s %12s %8s\n", "moved", "changed", "incr us", "full us", "speedup");
+
+    bool ok = error < 1e-3f;
+    for (double fraction : {0.001, 0.01, 0.1, 1.0}) {
+        size_t moved = std::max<size_t>(1, static_cast<size_t>(count * fraction));
+        double incremental = 0.0, full = 0.0;
+        size_t changed = 0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            for (size_t k = 0; k < moved; k++) {
+                size_t i = moved == count ? k : rng() % count;
+                tree.local[i] = RandomLocal(rng);
+                hierarchy.SetLocal(nodes[i], tree.local[i]);
+            }
+
+            start = std::chrono::steady_clock::now();
+            hierarchy.Update();
+            incremental += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            changed += hierarchy.Changed().size();
+
+            start = std::chrono::steady_clock::now();
+            tree.Recompute();
+            full += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        error = MaxError(tree, hierarchy, nodes);
+        ok = ok && error < 1e-3f;
+
+        printf(
+            "%8zu %9zu %12.1f %12.1f %7.1fx\n",
+            moved,
+            changed / frames,
+            incremental / frames,
+            full / frames,
+            full / incremental
+        );
+    }
+
+    printf("max error %g: %s\n", error, ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Batches visible cubes the way Scene::MakeDrawItems does: a few meshes and parts,
+// random depths, one instanced draw per part and pipeline, split at the instance
+// limit. Checks every batch holds one kind of draw front to back and that the
+// packed instance data matches the world matrices.
+//
+// usage: instancebench [instances=100000] [maxInstances=16384] [iterations=20]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "InstanceBatcher.h"
+
+using namespace bench;
+using namespace canvas;
+
+namespace
+{
+
+constexpr uint32_t Pipelines = 2;
+constexpr uint32_t Meshes = 3;
+constexpr uint32_t Submeshes = 2;
+
+// Same layout as BatchKey in Scene.cpp
+uint64_t Key(uint32_t pipeline, uint32_t mesh, uint32_t submesh, float depth)
+{
+    return uint64_t(pipeline) << 56 | uint64_t(mesh) << 32 | uint64_t(submesh) << 24 | SortKey::QuantizeDepth(depth);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    uint32_t maxInstances = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : InstanceBatcher::DefaultMaxInstances;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+    if (iterations <= 0) iterations = 1;
+
+    std::mt19937 rng(22);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<uint64_t> keys(count);
+    std::vector<uint32_t> identity(count);
+    std::vector<float> depth(count);
+    std::vector<Matrix4> world(count);
+    std::vector<InstanceStyle> styles(count);
+
+    for (size_t i = 0; i < count; i++) {
+        // Mostly one mesh, like the floor
+        uint32_t pipeline = unit(rng) < 0.01f ? 1 : 0;
+        uint32_t mesh = unit(rng) < 0.9f ? 0 : 1 + rng() % (Meshes - 1);
+        uint32_t submesh = rng() % Submeshes;
+        depth[i] = 0.1f + unit(rng) * 100.0f;
+
+        keys[i] = Key(pipeline, mesh, submesh, depth[i]);
+        identity[i] = (pipeline * Meshes + mesh) * Submeshes + submesh;
+
+        float scale = 0.5f + unit(rng);
+        world[i] = {{
+            {scale, 0.0f, 0.0f, 0.0f},
+            {0.0f, scale, 0.0f, 0.0f},
+            {0.0f, 0.0f, scale, 0.0f},
+            {unit(rng) * 100.0f, unit(rng), unit(rng) * 100.0f, 1.0f},
+        }};
+        styles[i].colorScale[0] = unit(rng);
+    }
+
+    InstanceBatcher batcher;
+    batcher.SetMaxInstances(maxInstances);
+    double buildUs = BestUs(iterations, [&] { batcher.Build(keys.data(), count, SortKey::DepthBits); });
+
+    auto order = batcher.Order();
+    auto batches = batcher.Batches();
+
+    // Expected draws: each kind of draw cut into runs of at most maxInstances
+    std::vector<size_t> perIdentity(Pipelines * Meshes * Submeshes, 0);
+    for (uint32_t id : identity)
+        perIdentity[id]++;
+    size_t expectedDraws = 0;
+    for (size_t n : perIdentity)
+        expectedDraws += (n + maxInstances - 1) / maxInstances;
+
+    bool ok = batches.size() == expectedDraws && order.size() == count;
+    uint32_t next = 0;
+    for (const InstanceBatch& batch : batches) {
+        ok = ok && batch.firstInstance == next && batch.instanceCount <= maxInstances && order[batch.firstInstance] == batch.item;
+        for (uint32_t k = batch.firstInstance + 1; k < batch.firstInstance + batch.instanceCount; k++) {
+            ok = ok && identity[order[k]] == identity[batch.item] && SortKey::QuantizeDepth(depth[order[k - 1]]) <= SortKey::QuantizeDepth(depth[order[k]]);
+        }
+        next += batch.instanceCount;
+    }
+    ok = ok && next == count;
+
+    std::vector<uint32_t> entities(order.begin(), order.end());
+    std::vector<InstanceData> packed(count);
+    double packUs = BestUs(iterations, [&] { PackInstances(entities.data(), count, world.data(), styles.data(), packed.data()); });
+
+    for (size_t k = 0; k < count; k++) {
+        const Matrix4& m = world[entities[k]];
+        for (int c = 0; c < 3; c++)
+            for (int r = 0; r < 4; r++)
+                ok = ok && packed[k].world[c][r] == m.m[r][c];
+        ok = ok && packed[k].style.colorScale[0] == styles[entities[k]].colorScale[0];
+    }
+
+    printf("%zu instances, limit %u per draw\n", count, maxInstances);
+    printf("draws %zu (%.1f instances per draw)\n", batches.size(), double(count) / double(batches.size()));
+    printf("batch %.1f us, pack %.1f us (%.1f MB)\n", buildUs, packUs, count * sizeof(InstanceData) / 1e6);
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+
+    return ok ? 0 : 1;
+}
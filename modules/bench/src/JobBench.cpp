@@ -0,0 +1,227 @@
+// Checks the job system under contention (every index of a parallel-for visited
+// once, counters, jobs spawning jobs), then times engine workloads on the shared
+// system at 1, 2, 4 ... up to all of its threads: bulk transform updates in
+// SceneStorage, frustum culling in slices, BVH builds, and a parallel radix sort
+// with merges. Each result is checked against the single-threaded one.
+//
+// usage: jobbench [entities=200000] [iterations=10] [checkWorkers=3]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Bvh.h"
+#include "DrawSort.h"
+#include "JobSystem.h"
+#include "SceneStorage.h"
+
+using namespace bench;
+using namespace canvas;
+
+namespace
+{
+
+// MARK: - Checks
+
+bool CheckParallelFor(jobs::JobSystem& system)
+{
+    constexpr size_t Count = 1 << 22;
+    std::vector<uint8_t> hits(Count, 0);
+    std::atomic<uint64_t> ranges{0};
+
+    system.ParallelFor(Count, 256, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            hits[i]++;
+        ranges.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    bool ok = std::all_of(hits.begin(), hits.end(), [](uint8_t h) { return h == 1; });
+    printf("  parallel-for: %llu ranges, %s\n", (unsigned long long)ranges.load(), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+bool CheckCounters(jobs::JobSystem& system)
+{
+    // More jobs than a queue holds, so the full-deque path runs too
+    constexpr uint32_t Outer = 64;
+    constexpr uint32_t Inner = 256;
+    std::atomic<uint32_t> done{0};
+
+    jobs::Counter outer;
+    for (uint32_t i = 0; i < Outer; i++) {
+        system.Run(outer, [&system, &done] {
+            jobs::Counter inner;
+            for (uint32_t k = 0; k < Inner; k++) {
+                system.Run(inner, [&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+            system.Wait(inner);
+        });
+    }
+    system.Wait(outer);
+
+    bool ok = outer.Done() && done.load() == Outer * Inner;
+    printf("  nested jobs: %u of %u, %s\n", done.load(), Outer * Inner, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// MARK: - Workloads
+
+// CullSpheres over slices of the bounds, each slice writing its own part of `visible`
+size_t CullSliced(const Frustum& frustum, const SphereBoundsSoA& bounds, uint32_t* visible, std::vector<uint32_t>& counts, unsigned ways)
+{
+    constexpr size_t Slice = 8192;
+    size_t slices = (bounds.count + Slice - 1) / Slice;
+    counts.assign(slices, 0);
+
+    jobs::Shared().ParallelFor(slices, 1, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; s++) {
+            size_t begin = s * Slice;
+            SphereBoundsSoA slice{bounds.x + begin, bounds.y + begin, bounds.z + begin, bounds.radius + begin, std::min(Slice, bounds.count - begin)};
+            uint32_t* out = visible + begin;
+            size_t n = CullSpheres(frustum, slice, out);
+            for (size_t k = 0; k < n; k++)
+                out[k] += static_cast<uint32_t>(begin);
+            counts[s] = static_cast<uint32_t>(n);
+        }
+    }, ways);
+
+    // Compact the slices
+    size_t total = 0;
+    for (size_t s = 0; s < slices; s++) {
+        std::copy_n(visible + s * Slice, counts[s], visible + total);
+        total += counts[s];
+    }
+    return total;
+}
+
+// Sorted chunks, then rounds of pairwise merges
+void SortParallel(std::vector<SortItem>& items, std::vector<SortItem>& scratch, unsigned ways)
+{
+    size_t count = items.size();
+    size_t chunks = std::max<size_t>(1, ways == 0 ? jobs::Shared().ThreadCount() : ways);
+    size_t chunk = (count + chunks - 1) / chunks;
+
+    jobs::Shared().ParallelFor(chunks, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            size_t begin = std::min(c * chunk, count), end = std::min(begin + chunk, count);
+            RadixSort(items.data() + begin, scratch.data() + begin, end - begin);
+        }
+    }, ways);
+
+    auto byKey = [](const SortItem& a, const SortItem& b) { return a.key < b.key; };
+    for (size_t width = chunk; width < count; width *= 2) {
+        size_t pairs = (count + 2 * width - 1) / (2 * width);
+        jobs::Shared().ParallelFor(pairs, 1, [&](size_t first, size_t last) {
+            for (size_t p = first; p < last; p++) {
+                size_t begin = p * 2 * width;
+                size_t middle = std::min(begin + width, count), end = std::min(begin + 2 * width, count);
+                std::merge(items.begin() + begin, items.begin() + middle, items.begin() + middle, items.begin() + end, scratch.begin() + begin, byKey);
+            }
+        }, ways);
+        items.swap(scratch);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+    unsigned checkWorkers = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 3;
+    if (iterations <= 0) iterations = 1;
+
+    bool ok = true;
+
+    // A private system with more threads than this machine may have cores
+    {
+        jobs::JobSystem system(checkWorkers);
+        printf("checks on %u threads\n", system.ThreadCount());
+        ok = CheckParallelFor(system) && ok;
+        ok = CheckCounters(system) && ok;
+    }
+
+    jobs::JobSystem& shared = jobs::Shared();
+    printf("\n%zu entities, shared system of %u threads\n", count, shared.ThreadCount());
+
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> spread(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    SceneStorage storage;
+    std::vector<Entity> entities;
+    for (size_t i = 0; i < count; i++) {
+        EntityDesc desc;
+        desc.position[0] = spread(rng);
+        desc.position[1] = spread(rng) * 0.1f;
+        desc.position[2] = spread(rng);
+        desc.radius = 0.5f + unit(rng);
+        entities.push_back(storage.Create(desc));
+    }
+    storage.UpdateTransforms(1);
+
+    Frustum frustum = MakeFrustum(1.0f, 1.6f, 0.1f, 400.0f, 50.0f);
+    std::vector<uint32_t> visible(count), reference(count), counts;
+    std::vector<SortItem> sortInput(count), items(count), scratch(count);
+    for (size_t i = 0; i < count; i++)
+        sortInput[i] = {uint64_t(rng()) << 32 | rng(), static_cast<uint32_t>(i), 0};
+
+    std::vector<SortItem> sorted = sortInput;
+    RadixSort(sorted.data(), scratch.data(), count);
+
+    std::vector<unsigned> ways;
+    for (unsigned n = 1; n < shared.ThreadCount(); n *= 2)
+        ways.push_back(n);
+    ways.push_back(shared.ThreadCount());
+
+    printf("%7s %17s %17s %17s %17s\n", "threads", "transforms", "cull", "bvh build", "sort");
+
+    double base[4] = {};
+    for (unsigned n : ways) {
+        double transformMs = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            float t = static_cast<float>(it);
+            for (size_t i = 0; i < count; i++)
+                storage.SetPosition(entities[i], spread(rng), t, spread(rng));
+
+            auto start = std::chrono::steady_clock::now();
+            storage.UpdateTransforms(n);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            transformMs = it == 0 ? ms : std::min(transformMs, ms);
+        }
+
+        SphereBoundsSoA bounds = storage.Bounds();
+        size_t referenceVisible = CullSpheres(frustum, bounds, reference.data());
+
+        size_t visibleCount = 0;
+        double cullMs = BestMs(iterations, [&] { visibleCount = CullSliced(frustum, bounds, visible.data(), counts, n); });
+        ok = ok && visibleCount == referenceVisible && std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin());
+
+        Bvh bvh;
+        double bvhMs = BestMs(iterations, [&] { bvh.Build(bounds, n); });
+        size_t treeVisible = bvh.Cull(frustum, bounds, visible.data());
+        ok = ok && treeVisible == referenceVisible;
+
+        double sortMs = BestMs(iterations, [&] {
+            items = sortInput;
+            SortParallel(items, scratch, n);
+        });
+        ok = ok && std::equal(items.begin(), items.end(), sorted.begin(), [](const SortItem& a, const SortItem& b) { return a.key == b.key; });
+
+        double ms[4] = {transformMs, cullMs, bvhMs, sortMs};
+        if (n == 1) std::copy(ms, ms + 4, base);
+
+        printf("%7u", n);
+        for (int w = 0; w < 4; w++)
+            printf(" %8.2f ms %4.1fx", ms[w], base[w] / ms[w]);
+        printf("\n");
+    }
+
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Spreads objects with 4-level LOD chains over a field and runs LodSelector from a
+// camera walking through it. Checks the first pass against a plain per-object
+// projection, then counts level switches while the camera jitters back and forth
+// with and without hysteresis.
+//
+// usage: lodbench [objects=100000] [frames=120]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "LodSelector.h"
+
+using namespace canvas;
+
+namespace
+{
+
+// 1080 lines, 45 degree vertical field of view
+constexpr float PixelsPerUnit = 1080.0f * 0.5f / 0.414214f;
+
+LodChain MakeChain(float radius)
+{
+    LodChain chain;
+    chain.count = 4;
+    const uint32_t triangles[4] = {20000, 5000, 1200, 300};
+    for (uint32_t level = 0; level < 4; level++) {
+        chain.error[level] = level ? radius * 0.002f * float(1 << (2 * level)) : 0.0f;
+        chain.triangles[level] = triangles[level];
+    }
+    return chain;
+}
+
+// Coarsest level under the threshold, straight from the definition
+uint32_t Reference(const LodChain& chain, const LodView& view, float x, float y, float z, float radius, float threshold)
+{
+    float dx = x - view.eye[0], dy = y - view.eye[1], dz = z - view.eye[2];
+    float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - radius, 1e-4f);
+
+    uint32_t level = 0;
+    for (uint32_t k = 1; k < chain.count; k++) {
+        if (chain.error[k] * view.pixelsPerUnit / distance <= threshold) level = k;
+    }
+    return level;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 120;
+    if (frames <= 0) frames = 1;
+
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+
+    // Two mesh sizes; world scale 1 so the chain error is the world error
+    std::vector<LodChain> chains = {MakeChain(1.0f), MakeChain(4.0f)};
+    const LodChain* chainPointers[] = {&chains[0], &chains[1]};
+
+    std::vector<float> x(count), y(count), z(count), radius(count), localRadius(count);
+    std::vector<uint32_t> meshes(count), indices(count);
+    for (size_t i = 0; i < count; i++) {
+        x[i] = position(rng);
+        y[i] = position(rng) * 0.05f;
+        z[i] = position(rng);
+        meshes[i] = rng() & 1;
+        radius[i] = localRadius[i] = meshes[i] ? 4.0f : 1.0f;
+        indices[i] = static_cast<uint32_t>(i);
+    }
+
+    LodInputs inputs{{x.data(), y.data(), z.data(), radius.data(), count}, localRadius.data(), meshes.data(), chainPointers};
+    LodSelector selector;
+    LodSettings settings = selector.Settings();
+
+    // From scratch every object drops to the coarsest level that fits
+    std::vector<uint8_t> lods(count, 0);
+    LodView view{{0.0f, 2.0f, -400.0f}, PixelsPerUnit};
+    selector.SetSettings({settings.pixelThreshold, 0.0f});
+    selector.Select(view, inputs, indices.data(), count, lods.data());
+
+    size_t wrong = 0;
+    for (size_t i = 0; i < count; i++) {
+        wrong += lods[i] != Reference(chains[meshes[i]], view, x[i], y[i], z[i], radius[i], settings.pixelThreshold);
+    }
+
+    // Walk forward, keeping the best time per frame
+    selector.SetSettings(settings);
+    float bestMs = 1e30f;
+    LodStats last;
+    for (int frame = 0; frame < frames; frame++) {
+        view.eye[2] = -400.0f + 800.0f * frame / frames;
+        selector.Select(view, inputs, indices.data(), count, lods.data());
+        bestMs = std::min(bestMs, selector.Stats().selectMs);
+        last = selector.Stats();
+    }
+
+    // Hovering half a unit back and forth
+    auto switchesWhileHovering = [&](float hysteresis) {
+        selector.SetSettings({settings.pixelThreshold, hysteresis});
+        std::fill(lods.begin(), lods.end(), 0);
+
+        view.eye[2] = 0.0f;
+        selector.Select(view, inputs, indices.data(), count, lods.data());
+
+        size_t switches = 0;
+        for (int frame = 1; frame <= frames; frame++) {
+            view.eye[2] = frame & 1 ? 0.5f : 0.0f;
+            switches += selector.Select(view, inputs, indices.data(), count, lods.data());
+        }
+        return switches;
+    };
+    size_t popping = switchesWhileHovering(0.0f);
+    size_t damped = switchesWhileHovering(settings.hysteresis);
+
+    printf("%zu objects, threshold %.1f px\n", count, settings.pixelThreshold);
+    printf("select %.3f ms (%.1f ns/object)\n", bestMs, bestMs * 1e6 / double(count));
+    printf(
+        "last frame: triangles %llu of %llu, %.1f%% saved\n",
+        static_cast<unsigned long long>(last.trianglesDrawn),
+        static_cast<unsigned long long>(last.trianglesFull),
+        100.0 * double(last.TrianglesSaved()) / double(last.trianglesFull)
+    );
+    printf("switches over %d hovering frames: %zu without hysteresis, %zu with %.2f\n", frames, popping, damped, settings.hysteresis);
+    printf("levels differing from the reference %zu: %s\n", wrong, wrong == 0 ? "ok" : "MISMATCH");
+
+    return wrong == 0 ? 0 : 1;
+}
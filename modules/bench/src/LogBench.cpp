@@ -0,0 +1,512 @@
+// Measures what logging costs the calling thread and how far the writer falls behind.
+//
+// Backends:
+//   ring    - AsyncLogger::log, lock-free ring + batched sink
+//   stream  - std::ostream over AsyncBuf, the std::cout fallback path
+//   mutex   - the original mutex + std::queue<std::string> design, kept as a baseline;
+//             it syncs every line to disk as the original did, so its drain time
+//             is bound by the disk
+//
+// Load shapes per producer thread:
+//   flat    - log as fast as possible
+//   steady  - evenly spaced at `rate` lines per second
+//   bursty  - bursts of 256 back-to-back lines, same average rate
+//
+// Before that, the renderer's per-frame line is logged from one thread both ways:
+//   text    - logging::Log::Write, formatted into the AsyncLogger ring
+//   binary  - logging::BinaryLog::Write, the YANG_BLOG path
+// with ns per call and file bytes per record, and the binary file is checked against
+// what logdecode (next to this executable) renders back.
+//
+// usage: logbench [linesPerThread=100000] [maxThreads=hardware] [rate=200000] [block|drop]
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "AsyncBuf.h"
+#include "AsyncLogger.h"
+#include "BinaryLog.h"
+#include "Log.h"
+#include "LogFormat.h"
+#include "LogSink.h"
+
+namespace
+{
+
+enum class Load
+{
+    FLAT,
+    STEADY,
+    BURSTY
+};
+
+constexpr const char* LoadName(Load load)
+{
+    switch (load) {
+    case Load::FLAT:
+        return "flat";
+    case Load::STEADY:
+        return "steady";
+    case Load::BURSTY:
+        return "bursty";
+    default:
+        return "unknown";
+    }
+}
+
+constexpr size_t BurstLength = 256;
+
+// Common face of the loggers under test. Destroying a backend drains it.
+class Backend
+{
+public:
+    virtual ~Backend() = default;
+    virtual void Log(std::string_view text) = 0;
+    virtual size_t Pending() const = 0;
+    virtual uint64_t Dropped() const = 0;
+};
+
+class RingBackend final : public Backend
+{
+public:
+    explicit RingBackend(AsyncLogger::Config config) :
+        m_logger(config)
+    {
+    }
+
+    void Log(std::string_view text) override { m_logger.log(text); }
+    size_t Pending() const override { return m_logger.pending(); }
+    uint64_t Dropped() const override { return m_logger.dropped(); }
+
+private:
+    AsyncLogger m_logger;
+};
+
+class StreamBackend final : public Backend
+{
+public:
+    explicit StreamBackend(AsyncLogger::Config config) :
+        m_logger(config),
+        m_buf(m_logger),
+        m_out(&m_buf)
+    {
+    }
+
+    void Log(std::string_view text) override { m_out << text << '\n'; }
+    size_t Pending() const override { return m_logger.pending(); }
+    uint64_t Dropped() const override { return m_logger.dropped(); }
+
+private:
+    AsyncLogger m_logger;
+    AsyncBuf m_buf;
+    std::ostream m_out;
+};
+
+// The AsyncLogger this repo started with: a mutex-guarded std::queue of strings,
+// a notify per line and a formatted write per line, synced to disk. Only the Win32
+// write-through calls are swapped for a portable FileSink committed and synced
+// after every line.
+class MutexQueueBackend final : public Backend
+{
+public:
+    MutexQueueBackend() :
+        m_sink(std::filesystem::path("logs") / "baseline.log")
+    {
+        m_worker = std::thread([this] {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            for (;;) {
+                m_cv.wait(lk, [this] { return m_done || !m_queue.empty(); });
+                while (!m_queue.empty()) {
+                    std::ostringstream entry;
+                    entry << "[" << logging::Now() << "] "
+                          << AsyncLogger::levelToString(AsyncLogger::DEBUG) << ": "
+                          << std::move(m_queue.front()) << "\n";
+                    m_queue.pop();
+                    m_size.store(m_queue.size(), std::memory_order_relaxed);
+
+                    auto message = entry.str();
+
+                    lk.unlock();
+                    m_sink.Append(message);
+                    m_sink.Commit();
+                    m_sink.Sync();
+                    lk.lock();
+                }
+                if (m_done && m_queue.empty()) break;
+            }
+        });
+    }
+
+    ~MutexQueueBackend() override
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_done = true;
+        }
+        m_cv.notify_all();
+        m_worker.join();
+    }
+
+    void Log(std::string_view text) override
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_queue.emplace(text);
+        m_size.store(m_queue.size(), std::memory_order_relaxed);
+        m_cv.notify_one();
+    }
+
+    size_t Pending() const override { return m_size.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const override { return 0; }
+
+private:
+    logging::FileSink m_sink;
+    std::queue<std::string> m_queue;
+    std::atomic<size_t> m_size{0};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_worker;
+    bool m_done = false;
+};
+
+struct Scenario
+{
+    const char* backend;
+    Load load;
+    size_t threads;
+    size_t messageBytes;
+    size_t linesPerThread;
+    uint64_t rate; // lines per second per thread, ignored for Load::FLAT
+    AsyncLogger::OverflowPolicy overflow;
+};
+
+struct Result
+{
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+    double linesPerSecond = 0;
+    size_t maxPending = 0;
+    double drainMs = 0;
+    uint64_t dropped = 0;
+};
+
+std::unique_ptr<Backend> MakeBackend(const Scenario& scenario)
+{
+    AsyncLogger::Config config;
+    config.overflow = scenario.overflow;
+
+    if (strcmp(scenario.backend, "ring") == 0) return std::make_unique<RingBackend>(config);
+    if (strcmp(scenario.backend, "stream") == 0) return std::make_unique<StreamBackend>(config);
+    return std::make_unique<MutexQueueBackend>();
+}
+
+void WaitUntil(uint64_t deadline)
+{
+    while (logging::Now() < deadline)
+        std::this_thread::yield();
+}
+
+void Produce(Backend& backend, const Scenario& scenario, size_t thread, uint32_t* latencies)
+{
+    std::string text = "thread " + std::to_string(thread) + " ";
+    text.resize(std::max(text.size(), scenario.messageBytes), 'x');
+
+    uint64_t interval = scenario.rate ? 1000000000ull / scenario.rate : 0;
+    uint64_t start = logging::Now();
+
+    for (size_t i = 0; i < scenario.linesPerThread; i++) {
+        if (scenario.load == Load::STEADY)
+            WaitUntil(start + i * interval);
+        else if (scenario.load == Load::BURSTY && i % BurstLength == 0)
+            WaitUntil(start + i * interval);
+
+        uint64_t before = logging::Now();
+        backend.Log(text);
+        uint64_t elapsed = logging::Now() - before;
+
+        latencies[i] = static_cast<uint32_t>(std::min<uint64_t>(elapsed, UINT32_MAX));
+    }
+}
+
+Result Run(const Scenario& scenario)
+{
+    size_t total = scenario.threads * scenario.linesPerThread;
+    std::vector<uint32_t> latencies(total);
+
+    Result result;
+    std::atomic<bool> producing{true};
+
+    auto backend = MakeBackend(scenario);
+
+    // Samples the backlog while producers run
+    std::thread monitor([&] {
+        while (producing.load(std::memory_order_relaxed)) {
+            result.maxPending = std::max(result.maxPending, backend->Pending());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    uint64_t start = logging::Now();
+
+    std::vector<std::thread> producers;
+    for (size_t t = 0; t < scenario.threads; t++) {
+        producers.emplace_back([&, t] {
+            Produce(*backend, scenario, t, latencies.data() + t * scenario.linesPerThread);
+        });
+    }
+    for (auto& producer : producers)
+        producer.join();
+
+    producing = false;
+    monitor.join();
+
+    // Time the worker needs to catch up once the producers are done
+    uint64_t produced = logging::Now();
+    result.dropped = backend->Dropped();
+    backend.reset();
+    uint64_t drained = logging::Now();
+
+    result.drainMs = static_cast<double>(drained - produced) / 1e6;
+    result.linesPerSecond = static_cast<double>(total) / (static_cast<double>(drained - start) / 1e9);
+
+    auto percentile = [&](double p) {
+        size_t index = std::min(total - 1, static_cast<size_t>(p * static_cast<double>(total)));
+        std::nth_element(latencies.begin(), latencies.begin() + static_cast<ptrdiff_t>(index), latencies.end());
+        return static_cast<uint64_t>(latencies[index]);
+    };
+
+    result.p50 = percentile(0.50);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.max = *std::max_element(latencies.begin(), latencies.end());
+    return result;
+}
+
+// MARK: - Frame line
+
+// What Renderer::Render logs once per frame
+constexpr const char* FrameFormat = "frame {} total {} dt {} alpha {}";
+
+struct Frame
+{
+    uint64_t frameCount;
+    double totalTime;
+    double deltaTime;
+    double alpha;
+};
+
+Frame MakeFrame(uint64_t i)
+{
+    return {i, static_cast<double>(i) / 120.0, 1.0 / 120.0, static_cast<double>(i % 7) / 7.0};
+}
+
+// The line as logdecode renders it
+std::string DecodedText(const Frame& f)
+{
+    char text[128];
+    snprintf(
+        text, sizeof(text), "frame %llu total %g dt %g alpha %g",
+        static_cast<unsigned long long>(f.frameCount), f.totalTime, f.deltaTime, f.alpha
+    );
+    return text;
+}
+
+struct FrameResult
+{
+    double meanNs = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    double bytesPerRecord = 0;
+    uint64_t dropped = 0;
+};
+
+// Logs `count` frame lines from this thread; the ring holds all of them, so nothing
+// is dropped or blocked and the calls measure the producer side alone
+FrameResult RunFrames(bool binary, size_t count, const std::filesystem::path& path)
+{
+    std::vector<uint32_t> latencies(count);
+    size_t capacity = std::bit_ceil(count);
+    FrameResult result;
+
+    auto measure = [&](auto&& log) {
+        for (size_t i = 0; i < count; i++) {
+            Frame f = MakeFrame(i);
+
+            uint64_t before = logging::Now();
+            log(f);
+            latencies[i] = static_cast<uint32_t>(std::min<uint64_t>(logging::Now() - before, UINT32_MAX));
+        }
+    };
+
+    if (binary) {
+        logging::BinaryLog log(path, capacity);
+        static logging::BinarySite site{FrameFormat, AsyncLogger::DEBUG};
+        measure([&](const Frame& f) { log.Write(site, f.frameCount, f.totalTime, f.deltaTime, f.alpha); });
+        result.dropped = log.Dropped();
+    }
+    else {
+        AsyncLogger::Config config;
+        config.capacity = capacity;
+
+        AsyncLogger logger(config);
+        logging::Log::SetLogger(&logger);
+        measure([](const Frame& f) {
+            logging::Log::Write(
+                AsyncLogger::DEBUG, logging::Channel::GENERAL,
+                "frame ", f.frameCount, " total ", f.totalTime, " dt ", f.deltaTime, " alpha ", f.alpha
+            );
+        });
+        logging::Log::SetLogger(nullptr);
+        result.dropped = logger.dropped();
+    }
+
+    uint64_t sum = 0;
+    for (uint32_t latency : latencies)
+        sum += latency;
+    result.meanNs = static_cast<double>(sum) / static_cast<double>(count);
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = latencies[count / 2];
+    result.p99 = latencies[std::min(count - 1, count * 99 / 100)];
+    result.bytesPerRecord = static_cast<double>(std::filesystem::file_size(path)) / static_cast<double>(count);
+    return result;
+}
+
+// Renders `blog` with logdecode and compares every line with the frame it came from.
+// Timestamps are fixed width, so one thread's lines must also sort as text.
+bool CheckRoundTrip(const std::filesystem::path& logdecode, const std::filesystem::path& blog, size_t count)
+{
+    if (!std::filesystem::exists(logdecode)) {
+        printf("round trip: skipped, %s not found\n", logdecode.string().c_str());
+        return true;
+    }
+
+    auto decoded = std::filesystem::path(blog).replace_extension(".decoded.log");
+    std::string command;
+    for (const auto& arg : {logdecode, blog, decoded})
+        command.append("\"").append(arg.string()).append("\" ");
+    if (std::system(command.c_str()) != 0) {
+        printf("round trip: logdecode failed\n");
+        return false;
+    }
+
+    std::ifstream in(decoded);
+    std::string line, previousStamp;
+    size_t matched = 0, lines = 0;
+
+    for (; std::getline(in, line); lines++) {
+        std::string expected = ": " + DecodedText(MakeFrame(lines));
+        std::string stamp = line.substr(0, line.find(']') + 1);
+
+        if (lines < count && line.ends_with(expected) && stamp >= previousStamp)
+            matched++;
+        else if (lines - matched == 0)
+            printf("round trip: line %zu is \"%s\"\n", lines, line.c_str());
+
+        previousStamp = stamp;
+    }
+
+    printf("round trip: %zu of %zu records match logdecode's %zu lines\n", matched, count, lines);
+    return matched == count && lines == count;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t linesPerThread = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t maxThreads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    uint64_t rate = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200000;
+    auto overflow = argc > 4 && strcmp(argv[4], "drop") == 0
+        ? AsyncLogger::OverflowPolicy::DROP_NEWEST
+        : AsyncLogger::OverflowPolicy::BLOCK;
+
+    if (linesPerThread == 0) linesPerThread = 1;
+    if (maxThreads == 0) maxThreads = 1;
+
+    // Built next to this executable
+    auto self = std::filesystem::absolute(argv[0]);
+    auto logdecode = std::filesystem::path(self).replace_filename("logdecode").replace_extension(self.extension());
+
+    // The loggers write to ./logs, keep that out of the working tree
+    auto dir = std::filesystem::temp_directory_path() / "yangine_logbench";
+    std::filesystem::create_directories(dir / "logs");
+    std::filesystem::current_path(dir);
+
+    printf("%-7s %8s %8s %8s %8s %9s %9s\n", "frame", "records", "mean ns", "p50 ns", "p99 ns", "B/record", "dropped");
+
+    bool roundTrip = true;
+    for (bool binary : {false, true}) {
+        auto path = binary ? dir / "logs" / "frames.blog" : dir / "logs" / "engine.log";
+        FrameResult r = RunFrames(binary, linesPerThread, path);
+
+        printf(
+            "%-7s %8zu %8.1f %8llu %8llu %9.1f %9llu\n",
+            binary ? "binary" : "text", linesPerThread, r.meanNs,
+            static_cast<unsigned long long>(r.p50),
+            static_cast<unsigned long long>(r.p99),
+            r.bytesPerRecord,
+            static_cast<unsigned long long>(r.dropped)
+        );
+
+        if (binary) roundTrip = CheckRoundTrip(logdecode, path, linesPerThread);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    printf(
+        "%-7s %-7s %3s %5s %12s %8s %8s %8s %9s %9s %9s %9s\n",
+        "backend", "load", "thr", "bytes", "lines/s", "p50 ns", "p99 ns", "p99.9 ns", "max ns",
+        "max lag", "drain ms", "dropped"
+    );
+
+    for (const char* backend : {"ring", "stream", "mutex"}) {
+        for (Load load : {Load::FLAT, Load::STEADY, Load::BURSTY}) {
+            for (size_t threads : threadCounts) {
+                for (size_t bytes : {16, 64, 200}) {
+                    Scenario scenario{backend, load, threads, bytes, linesPerThread, rate, overflow};
+                    Result r = Run(scenario);
+
+                    printf(
+                        "%-7s %-7s %3zu %5zu %12.0f %8llu %8llu %8llu %9llu %9zu %9.2f %9llu\n",
+                        backend, LoadName(load), threads, bytes, r.linesPerSecond,
+                        static_cast<unsigned long long>(r.p50),
+                        static_cast<unsigned long long>(r.p99),
+                        static_cast<unsigned long long>(r.p999),
+                        static_cast<unsigned long long>(r.max),
+                        r.maxPending, r.drainMs,
+                        static_cast<unsigned long long>(r.dropped)
+                    );
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::remove_all(dir);
+    return roundTrip ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// Rasterizes a row of box-shaped buildings into an OcclusionCuller and tests random
+// spheres behind them. A plain per-pixel depth buffer of the same resolution checks
+// that nothing visible was culled and shows how much the tile masks give away.
+//
+// usage: occlusionbench [objects=100000] [occluders=64] [iterations=10]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "OcclusionCuller.h"
+
+using namespace canvas;
+
+namespace
+{
+
+constexpr uint32_t Width = OcclusionCuller::Width;
+constexpr uint32_t Height = OcclusionCuller::Height;
+
+// XMMatrixPerspectiveFovLH with the camera at the origin looking down +z
+Matrix4 MakeViewProjection(float fovY, float aspect, float nearZ, float farZ)
+{
+    float h = 1.0f / std::tan(fovY * 0.5f);
+    float w = h / aspect;
+    float range = farZ / (farZ - nearZ);
+
+    return {{
+        {w, 0.0f, 0.0f, 0.0f},
+        {0.0f, h, 0.0f, 0.0f},
+        {0.0f, 0.0f, range, 1.0f},
+        {0.0f, 0.0f, -range * nearZ, 0.0f},
+    }};
+}
+
+OccluderMesh MakeCube()
+{
+    OccluderMesh cube;
+    for (int corner = 0; corner < 8; corner++) {
+        cube.positions.push_back(corner & 1 ? 1.0f : -1.0f);
+        cube.positions.push_back(corner & 2 ? 1.0f : -1.0f);
+        cube.positions.push_back(corner & 4 ? 1.0f : -1.0f);
+    }
+    cube.indices = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+    return cube;
+}
+
+Matrix4 Placement(float x, float y, float z, float sx, float sy, float sz)
+{
+    return {{
+        {sx, 0.0f, 0.0f, 0.0f},
+        {0.0f, sy, 0.0f, 0.0f},
+        {0.0f, 0.0f, sz, 0.0f},
+        {x, y, z, 1.0f},
+    }};
+}
+
+struct Projected
+{
+    float x, y, z;
+    bool inFront;
+};
+
+Projected Project(const Matrix4& m, float x, float y, float z)
+{
+    float clip[4];
+    for (int c = 0; c < 4; c++)
+        clip[c] = x * m.m[0][c] + y * m.m[1][c] + z * m.m[2][c] + m.m[3][c];
+
+    float inverseW = 1.0f / clip[3];
+    return {
+        (clip[0] * inverseW * 0.5f + 0.5f) * Width,
+        (0.5f - clip[1] * inverseW * 0.5f) * Height,
+        clip[2] * inverseW,
+        clip[2] >= 0.0f,
+    };
+}
+
+// Exact nearest depth per pixel center
+struct ReferenceDepth
+{
+    std::vector<float> depth = std::vector<float>(Width * Height, 1.0f);
+
+    void Add(const OccluderMesh& mesh, const Matrix4& world, const Matrix4& viewProjection)
+    {
+        Matrix4 m;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                m.m[r][c] = world.m[r][0] * viewProjection.m[0][c] + world.m[r][1] * viewProjection.m[1][c] +
+                            world.m[r][2] * viewProjection.m[2][c] + world.m[r][3] * viewProjection.m[3][c];
+
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            Projected v[3];
+            for (int k = 0; k < 3; k++) {
+                const float* p = &mesh.positions[mesh.indices[i + k] * 3];
+                v[k] = Project(m, p[0], p[1], p[2]);
+            }
+            if (!v[0].inFront || !v[1].inFront || !v[2].inFront) continue;
+
+            float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+            if (std::fabs(area) < 1e-6f) continue;
+
+            for (uint32_t py = 0; py < Height; py++) {
+                for (uint32_t px = 0; px < Width; px++) {
+                    float x = px + 0.5f, y = py + 0.5f;
+                    float w0 = ((v[1].x - x) * (v[2].y - y) - (v[2].x - x) * (v[1].y - y)) / area;
+                    float w1 = ((v[2].x - x) * (v[0].y - y) - (v[0].x - x) * (v[2].y - y)) / area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                    float z = w0 * v[0].z + w1 * v[1].z + w2 * v[2].z;
+                    depth[py * Width + px] = std::min(depth[py * Width + px], z);
+                }
+            }
+        }
+    }
+
+    // Hidden behind the exact depth at every pixel center the box covers
+    bool Hidden(const Matrix4& viewProjection, const float (&min)[3], const float (&max)[3]) const
+    {
+        float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY, nearest = INFINITY;
+        for (int corner = 0; corner < 8; corner++) {
+            Projected p = Project(viewProjection, corner & 1 ? max[0] : min[0], corner & 2 ? max[1] : min[1], corner & 4 ? max[2] : min[2]);
+            if (!p.inFront) return false;
+            x0 = std::min(x0, p.x);
+            x1 = std::max(x1, p.x);
+            y0 = std::min(y0, p.y);
+            y1 = std::max(y1, p.y);
+            nearest = std::min(nearest, p.z);
+        }
+
+        int px0 = std::max(0, int(std::ceil(x0 - 0.5f))), px1 = std::min(int(Width) - 1, int(std::floor(x1 - 0.5f)));
+        int py0 = std::max(0, int(std::ceil(y0 - 0.5f))), py1 = std::min(int(Height) - 1, int(std::floor(y1 - 0.5f)));
+        if (px0 > px1 || py0 > py1) return false;
+
+        for (int py = py0; py <= py1; py++) {
+            for (int px = px0; px <= px1; px++) {
+                if (nearest <= depth[py * Width + px]) return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    int occluderCount = argc > 2 ? std::atoi(argv[2]) : 64;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+    if (iterations <= 0) iterations = 1;
+
+    std::mt19937 rng(3);
+    Matrix4 viewProjection = MakeViewProjection(0.785398f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    // Buildings in a band 40-80 units ahead, everything else behind or between them
+    std::uniform_real_distribution<float> buildingX(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> buildingZ(40.0f, 80.0f);
+    std::uniform_real_distribution<float> buildingSize(2.0f, 8.0f);
+
+    OccluderMesh cube = MakeCube();
+    std::vector<Matrix4> occluders;
+    for (int i = 0; i < occluderCount; i++) {
+        float height = buildingSize(rng) * 3.0f;
+        occluders.push_back(Placement(buildingX(rng), height - 10.0f, buildingZ(rng), buildingSize(rng), height, buildingSize(rng)));
+    }
+
+    std::uniform_real_distribution<float> objectX(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> objectY(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> objectZ(50.0f, 400.0f);
+    std::uniform_real_distribution<float> objectRadius(0.2f, 2.0f);
+
+    std::vector<float> x(count), y(count), z(count), radius(count);
+    for (size_t i = 0; i < count; i++) {
+        x[i] = objectX(rng);
+        y[i] = objectY(rng);
+        z[i] = objectZ(rng);
+        radius[i] = objectRadius(rng);
+    }
+    SphereBoundsSoA spheres{x.data(), y.data(), z.data(), radius.data(), count};
+
+    OcclusionCuller culler;
+    std::vector<uint32_t> indices(count);
+    size_t visible = 0;
+    OcclusionStats best;
+    best.rasterizeMs = best.testMs = 1e30f;
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        culler.Begin(viewProjection);
+        for (const Matrix4& world : occluders)
+            culler.AddOccluder(cube, world);
+        culler.Rasterize();
+
+        for (size_t i = 0; i < count; i++)
+            indices[i] = static_cast<uint32_t>(i);
+        visible = culler.Cull(spheres, indices.data(), count);
+
+        const OcclusionStats& stats = culler.Stats();
+        best.rasterizeMs = std::min(best.rasterizeMs, stats.rasterizeMs);
+        best.testMs = std::min(best.testMs, stats.testMs);
+        best.triangles = stats.triangles;
+        best.culled = stats.culled;
+    }
+
+    ReferenceDepth reference;
+    for (const Matrix4& world : occluders)
+        reference.Add(cube, world, viewProjection);
+
+    // Everything culled must be hidden in the exact buffer too
+    std::vector<uint8_t> kept(count, 0);
+    for (size_t k = 0; k < visible; k++)
+        kept[indices[k]] = 1;
+
+    size_t wrong = 0, hidden = 0;
+    for (size_t i = 0; i < count; i++) {
+        float min[3] = {x[i] - radius[i], y[i] - radius[i], z[i] - radius[i]};
+        float max[3] = {x[i] + radius[i], y[i] + radius[i], z[i] + radius[i]};
+        bool exact = reference.Hidden(viewProjection, min, max);
+        hidden += exact;
+        wrong += !kept[i] && !exact;
+    }
+
+    printf("%zu objects, %d occluders (%u triangles), %ux%u tiles of %ux%u\n", count, occluderCount, best.triangles, OcclusionCuller::TilesX, OcclusionCuller::TilesY, OcclusionCuller::TileWidth, OcclusionCuller::TileHeight);
+    printf("rasterize %.3f ms, test %.3f ms (%.1f ns/object)\n", best.rasterizeMs, best.testMs, best.testMs * 1e6 / double(count));
+    printf("culled %u, hidden in exact depth %zu (%.1f%% caught)\n", best.culled, hidden, hidden ? 100.0 * best.culled / hidden : 100.0);
+    printf("wrongly culled %zu: %s\n", wrong, wrong == 0 ? "ok" : "MISMATCH");
+
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Paces frames with timer::FramePacer at a few target rates, once with the default
+// spin margin and once sleeping all the way (clock_nanosleep on Linux, the waitable
+// timer on Windows), and prints how the wait split into sleeping and spinning and
+// how late frames were released. A simulated frame of `work` percent of the period
+// is spun before each Wait. No frame may be released before its deadline.
+//
+// usage: pacerbench [frames=120] [work=30]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "FramePacer.h"
+
+namespace
+{
+
+uint64_t Now()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+}
+
+void Work(uint64_t ns)
+{
+    uint64_t end = Now() + ns;
+    while (Now() < end) {
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 120;
+    int work = argc > 2 ? std::atoi(argv[2]) : 30;
+    if (frames <= 0) frames = 1;
+    if (work < 0 || work > 100) work = 30;
+
+    printf(
+        "%6s %9s %9s %9s %9s %9s %9s %9s %9s %6s\n",
+        "hz", "margin us", "rate", "slept ms", "spun ms", "slept %", "p50 us", "p99 us", "max us", "late"
+    );
+
+    bool ok = true;
+    for (uint64_t margin : {uint64_t(1000000), uint64_t(0)}) {
+        for (double hz : {60.0, 144.0, 240.0, 1000.0}) {
+            timer::FramePacer::Config config;
+            config.targetHz = hz;
+            config.spinMargin = margin;
+            timer::FramePacer pacer(config);
+
+            uint64_t period = static_cast<uint64_t>(1e9 / hz);
+            uint64_t start = Now();
+            for (int i = 0; i < frames; i++) {
+                Work(period * static_cast<uint64_t>(work) / 100);
+                pacer.Wait();
+            }
+            uint64_t elapsed = Now() - start;
+
+            // Each Wait releases no earlier than a period after the one before
+            ok = ok && pacer.GetFrameCount() == static_cast<uint64_t>(frames) && elapsed >= period * static_cast<uint64_t>(frames);
+
+            timer::FrameTimeSummary lateness = pacer.Lateness().Window();
+            uint64_t waited = pacer.GetSleptTime() + pacer.GetSpunTime();
+
+            printf(
+                "%6.0f %9llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %6llu\n",
+                hz, static_cast<unsigned long long>(margin / 1000),
+                frames / (elapsed / 1e9),
+                pacer.GetSleptTime() / 1e6,
+                pacer.GetSpunTime() / 1e6,
+                waited ? 100.0 * pacer.GetSleptTime() / waited : 0.0,
+                lateness.p50 / 1e3, lateness.p99 / 1e3, lateness.max / 1e3,
+                static_cast<unsigned long long>(lateness.overBudget)
+            );
+            fflush(stdout);
+        }
+    }
+
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+// Replays a frame of draws through CommandRecorder into a fake command list that
+// only counts what reaches it, once in submission order and once sorted by state,
+// and checks the filtering against the calls a plain list would have received.
+// Then splits the sorted frame over 1, 2, 4 and 8 fake lists with ParallelRecorder
+// and checks the lists, taken in order, hold every draw once and in order.
+//
+// usage: recorderbench [draws=10000] [pipelines=4] [meshes=64]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "CommandRecorder.h"
+#include "ParallelRecorder.h"
+
+using namespace canvas;
+
+namespace
+{
+
+struct BufferView
+{
+    uint64_t location;
+    uint32_t size;
+    uint32_t strideOrFormat;
+};
+
+struct FakeRootSignature
+{
+};
+
+struct FakePipelineState
+{
+};
+
+struct FakeDescriptorHeap
+{
+};
+
+// Counts the calls that would have reached the driver
+struct FakeCommandList
+{
+    uint32_t rootSignatures = 0;
+    uint32_t pipelineStates = 0;
+    uint32_t topologies = 0;
+    uint32_t vertexBuffers = 0;
+    uint32_t indexBuffers = 0;
+    uint32_t rootCbvs = 0;
+    uint32_t heaps = 0;
+    uint32_t draws = 0;
+
+    // Draws arrive with their index in the frame as the start instance
+    uint32_t firstDraw = UINT32_MAX;
+    uint32_t lastDraw = 0;
+    bool inOrder = true;
+
+    // What is bound, to check the recorder never leaves stale state behind
+    const FakePipelineState* pipelineState = nullptr;
+    uint64_t vertexBuffer = 0;
+    uint64_t rootCbv = 0;
+
+    void SetDescriptorHeaps(uint32_t, FakeDescriptorHeap* const*) { heaps++; }
+    void SetGraphicsRootSignature(FakeRootSignature*)
+    {
+        rootSignatures++;
+        rootCbv = 0;
+    }
+    void SetPipelineState(FakePipelineState* pso)
+    {
+        pipelineStates++;
+        pipelineState = pso;
+    }
+    void IASetPrimitiveTopology(int) { topologies++; }
+    void IASetVertexBuffers(uint32_t, uint32_t, const BufferView* views)
+    {
+        vertexBuffers++;
+        vertexBuffer = views[0].location;
+    }
+    void IASetIndexBuffer(const BufferView*) { indexBuffers++; }
+    void SetGraphicsRootConstantBufferView(uint32_t, uint64_t address)
+    {
+        rootCbvs++;
+        rootCbv = address;
+    }
+    void DrawInstanced(uint32_t, uint32_t, uint32_t, uint32_t) { draws++; }
+    void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t startInstance)
+    {
+        if (draws++ == 0) {
+            firstDraw = startInstance;
+        }
+        else {
+            inOrder = inOrder && startInstance == lastDraw + 1;
+        }
+        lastDraw = startInstance;
+    }
+
+    uint32_t StateCalls() const
+    {
+        return rootSignatures + pipelineStates + topologies + vertexBuffers + indexBuffers + rootCbvs + heaps;
+    }
+};
+
+struct FakeApi
+{
+    using CommandList = FakeCommandList;
+    using RootSignature = FakeRootSignature;
+    using PipelineState = FakePipelineState;
+    using DescriptorHeap = FakeDescriptorHeap;
+    using Topology = int;
+    using VertexBufferView = BufferView;
+    using IndexBufferView = BufferView;
+    using GpuAddress = uint64_t;
+};
+
+struct FakeDraw
+{
+    uint32_t pipeline;
+    uint32_t mesh;
+    uint64_t cb; // 0 = none, shared per mesh to give the filter something to skip
+};
+
+FakeRootSignature g_rootSignature;
+FakeDescriptorHeap g_heap;
+std::vector<FakePipelineState> g_pipelines;
+
+// Same call sequence as Renderer::Draw
+void Draw(CommandRecorder<FakeApi>& recorder, const FakeDraw& draw, uint32_t index, bool& ok)
+{
+    recorder.SetGraphicsRootSignature(&g_rootSignature);
+    recorder.SetPipelineState(&g_pipelines[draw.pipeline]);
+
+    FakeDescriptorHeap* heaps[] = {&g_heap};
+    recorder.SetDescriptorHeaps(1, heaps);
+
+    BufferView vbv{0x10000ull * (draw.mesh + 1), 4096, 24};
+    BufferView ibv{0x10000ull * (draw.mesh + 1) + 0x8000, 2048, 57};
+
+    recorder.IASetPrimitiveTopology(4);
+    recorder.IASetVertexBuffers(0, 1, &vbv);
+    if (draw.cb) recorder.SetGraphicsRootConstantBufferView(0, draw.cb);
+    recorder.IASetIndexBuffer(&ibv);
+    recorder.DrawIndexedInstanced(36, 1, 0, 0, index);
+
+    const FakeCommandList& list = *recorder.Get();
+    ok = ok && list.pipelineState == &g_pipelines[draw.pipeline] && list.vertexBuffer == vbv.location &&
+         (!draw.cb || list.rootCbv == draw.cb);
+}
+
+// Calls Draw makes on the recorder, excluding the draw itself
+size_t RequestedCalls(const std::vector<FakeDraw>& draws)
+{
+    size_t calls = 0;
+    for (const auto& draw : draws)
+        calls += draw.cb ? 7 : 6;
+    return calls;
+}
+
+struct Result
+{
+    FakeCommandList list;
+    RecorderCounters counters;
+    double nsPerDraw;
+    bool ok;
+};
+
+Result Replay(const std::vector<FakeDraw>& draws)
+{
+    FakeCommandList list;
+    CommandRecorder<FakeApi> recorder;
+    bool ok = true;
+
+    auto start = std::chrono::steady_clock::now();
+    recorder.Begin(&list);
+    for (size_t k = 0; k < draws.size(); k++)
+        Draw(recorder, draws[k], static_cast<uint32_t>(k), ok);
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+    // Everything the recorder saw is either issued or skipped, and issued calls
+    // are exactly what reached the list
+    const auto& counters = recorder.GetCounters();
+    ok = ok && counters.issued == list.StateCalls() && counters.issued + counters.skipped == RequestedCalls(draws) &&
+         counters.draws == draws.size() && list.draws == draws.size();
+
+    return {list, counters, elapsed.count() / static_cast<double>(draws.size()), ok};
+}
+
+struct ParallelResult
+{
+    uint32_t lists;
+    RecorderCounters counters;
+    double nsPerDraw;
+    bool ok;
+};
+
+ParallelResult ParallelReplay(const std::vector<FakeDraw>& draws, uint32_t maxLists)
+{
+    ParallelRecorder<FakeApi> recorder;
+    recorder.SetMinDrawsPerList(1);
+    std::vector<FakeCommandList> lists(ParallelRecorder<FakeApi>::MaxLists);
+    FakeCommandList* targets[ParallelRecorder<FakeApi>::MaxLists];
+    for (size_t i = 0; i < lists.size(); i++)
+        targets[i] = &lists[i];
+
+    std::atomic<bool> bound{true};
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t listCount = recorder.Split(draws.size(), maxLists);
+    recorder.Record(targets, [&](CommandRecorder<FakeApi>& list, size_t first, size_t last) {
+        bool ok = true;
+        for (size_t k = first; k < last; k++)
+            Draw(list, draws[k], static_cast<uint32_t>(k), ok);
+        if (!ok) bound = false;
+    });
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+    // Submitted in range order the lists replay the frame: each one in order and
+    // picking up where the previous one stopped, and each matches its recorder
+    bool ok = bound && listCount == recorder.Ranges().size();
+    uint32_t next = 0, issued = 0;
+    for (uint32_t i = 0; i < listCount; i++) {
+        const FakeCommandList& list = lists[i];
+        const RecordRange& range = recorder.Ranges()[i];
+        ok = ok && list.inOrder && list.draws == range.count && (list.draws == 0 || (list.firstDraw == next && range.first == next));
+        ok = ok && recorder.GetRecorder(i).GetCounters().issued == list.StateCalls();
+        next += list.draws;
+        issued += list.StateCalls();
+    }
+
+    const RecorderCounters counters = recorder.GetCounters();
+    ok = ok && next == draws.size() && counters.draws == draws.size() && counters.issued == issued &&
+         counters.issued + counters.skipped == RequestedCalls(draws);
+
+    return {listCount, counters, elapsed.count() / static_cast<double>(draws.size()), ok};
+}
+
+void Print(const char* name, const Result& r)
+{
+    printf(
+        "%-10s %7u %7u %6u %6u %6u %6u %6u %8.1f  %s\n",
+        name,
+        r.counters.issued,
+        r.counters.skipped,
+        r.list.rootSignatures,
+        r.list.pipelineStates,
+        r.list.vertexBuffers,
+        r.list.indexBuffers,
+        r.list.rootCbvs,
+        r.nsPerDraw,
+        r.ok ? "ok" : "MISMATCH"
+    );
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    uint32_t pipelines = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 4;
+    uint32_t meshes = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 64;
+    if (pipelines == 0) pipelines = 1;
+    if (meshes == 0) meshes = 1;
+
+    g_pipelines.resize(pipelines);
+
+    std::mt19937 rng(42);
+    std::vector<FakeDraw> draws(count);
+    for (auto& draw : draws) {
+        draw.pipeline = rng() % pipelines;
+        draw.mesh = rng() % meshes;
+        draw.cb = rng() % 4 ? 0x100000ull + 256ull * draw.mesh : 0;
+    }
+
+    std::vector<FakeDraw> sorted = draws;
+    std::sort(sorted.begin(), sorted.end(), [](const FakeDraw& a, const FakeDraw& b) {
+        return a.pipeline != b.pipeline ? a.pipeline < b.pipeline : a.mesh < b.mesh;
+    });
+
+    Result unsortedResult = Replay(draws);
+    Result sortedResult = Replay(sorted);
+
+    printf(
+        "%zu draws, %u pipelines, %u meshes, %zu state calls requested\n",
+        count,
+        pipelines,
+        meshes,
+        RequestedCalls(draws)
+    );
+    printf("%-10s %7s %7s %6s %6s %6s %6s %6s %8s\n", "order", "issued", "skipped", "rootsg", "pso", "vb", "ib", "cbv", "ns/draw");
+    Print("submitted", unsortedResult);
+    Print("sorted", sortedResult);
+
+    // Every list rebinds its first state, the cost of splitting
+    bool ok = unsortedResult.ok && sortedResult.ok;
+    printf("\nsorted, split over %u job threads\n", jobs::Shared().ThreadCount());
+    printf("%-10s %7s %7s %8s\n", "lists", "issued", "skipped", "ns/draw");
+    for (uint32_t maxLists = 1; maxLists <= ParallelRecorder<FakeApi>::MaxLists; maxLists *= 2) {
+        ParallelResult r = ParallelReplay(sorted, maxLists);
+        printf("%-10u %7u %7u %8.1f  %s\n", r.lists, r.counters.issued, r.counters.skipped, r.nsPerDraw, r.ok ? "ok" : "MISMATCH");
+        ok = ok && r.ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// Compares log sinks on the same stream of formatted lines:
+//   legacy  - the original AsyncLogger path: per line, the text and the newline as
+//             two writes, then a sync to disk (WriteFile x2 + FlushFileBuffers on a
+//             write-through handle; write x2 + fdatasync elsewhere)
+//   batched - logging::FileSink, one vectored write per batch
+//   mapped  - logging::MappedFileSink, memcpy into a mapped segment
+//
+// A sync per line makes legacy slow on real disks, so it writes only the first
+// `legacyLines` lines; rates are per line and per byte, so the rows compare.
+//
+// usage: sinkbench [lines=1000000] [lineBytes=96] [batch=64] [legacyLines=20000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LogSink.h"
+#include "MappedFileSink.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+struct Result
+{
+    const char* name;
+    double seconds;
+    uint64_t bytes;
+    size_t lines;
+};
+
+std::vector<std::string> MakeLines(size_t count, size_t lineBytes)
+{
+    std::vector<std::string> lines;
+    lines.reserve(count);
+
+    for (size_t i = 0; i < count; i++) {
+        std::string line = "[2025-01-01 00:00:00.000000] INFO [general]: frame " + std::to_string(i) + ' ';
+        line.resize(lineBytes > 1 ? lineBytes - 1 : 0, 'x');
+        line += '\n';
+        lines.push_back(std::move(line));
+    }
+
+    return lines;
+}
+
+// Two writes and a sync per line, as AsyncLogger did before the ring and the sinks
+class LegacyFile final
+{
+public:
+    explicit LegacyFile(const std::filesystem::path& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, nullptr);
+#else
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+
+    ~LegacyFile()
+    {
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+
+    void WriteLine(std::string_view line)
+    {
+        if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+        const char nl = '\n';
+
+#ifdef _WIN32
+        DWORD written = 0;
+        WriteFile(m_file, line.data(), static_cast<DWORD>(line.size()), &written, nullptr);
+        WriteFile(m_file, &nl, 1, &written, nullptr);
+        FlushFileBuffers(m_file);
+#else
+        [[maybe_unused]] ssize_t written = write(m_fd, line.data(), line.size());
+        written = write(m_fd, &nl, 1);
+        fdatasync(m_fd);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+template <typename Fn>
+Result Measure(const char* name, uint64_t bytes, size_t lines, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    return {name, elapsed.count(), bytes, lines};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t lineBytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 96;
+    size_t batch = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    size_t legacyLines = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 20000;
+    if (batch == 0) batch = 1;
+
+    auto lines = MakeLines(count, lineBytes);
+
+    uint64_t total = 0;
+    for (auto& line : lines)
+        total += line.size();
+
+    auto dir = std::filesystem::temp_directory_path() / "yangine_sinkbench";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::vector<Result> results;
+
+    legacyLines = std::min(legacyLines, lines.size());
+    uint64_t legacyBytes = 0;
+    for (size_t i = 0; i < legacyLines; i++)
+        legacyBytes += lines[i].size();
+
+    results.push_back(Measure("legacy", legacyBytes, legacyLines, [&] {
+        LegacyFile file(dir / "legacy.log");
+        for (size_t i = 0; i < legacyLines; i++)
+            file.WriteLine(lines[i]);
+    }));
+
+    results.push_back(Measure("batched", total, count, [&] {
+        logging::FileSink sink(dir / "batched.log");
+        for (size_t i = 0; i < lines.size(); i++) {
+            sink.Append(lines[i]);
+            if ((i + 1) % batch == 0) sink.Commit();
+        }
+        sink.Commit();
+    }));
+
+    results.push_back(Measure("mapped", total, count, [&] {
+        logging::MappedFileSink sink(dir / "mapped.log", {64 << 20, 64});
+        for (size_t i = 0; i < lines.size(); i++) {
+            sink.Append(lines[i]);
+            if ((i + 1) % batch == 0) sink.Commit();
+        }
+    }));
+
+    printf("%zu lines x %zu bytes, batch %zu; legacy syncs each of the first %zu\n", count, lineBytes, batch, legacyLines);
+    printf("%-8s %10s %10s %12s\n", "sink", "seconds", "MB/s", "ns/line");
+
+    for (auto& r : results) {
+        double mbps = static_cast<double>(r.bytes) / (1024.0 * 1024.0) / r.seconds;
+        double ns = r.seconds * 1e9 / static_cast<double>(r.lines ? r.lines : 1);
+        printf("%-8s %10.3f %10.1f %12.1f\n", r.name, r.seconds, mbps, ns);
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,283 @@
+// Drives GameTimer from a timer::VirtualClock the way a headless simulation would:
+// 600 frames of 16.667 ms against a 1/120 s step must run exactly 1200 steps, end
+// on the alpha the leftover ticks give and produce the same Tick sequence on every
+// run. Also times how fast the 600 frames step with nothing to wait for.
+//
+// Then checks timer::FrameTimeRecorder: every value falls inside the bucket
+// BucketIndex gives it and the bucket is at most 1/16 wide, Window() matches exact
+// percentiles and over-budget counts of synthetic frame times, and SinceReset()
+// reports the upper bound of the bucket the exact percentile falls in.
+//
+// usage: timerbench [iterations=100] [frames=5000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BenchUtil.h"
+#include "Clock.h"
+#include "FrameTimeRecorder.h"
+#include "GameTimer.h"
+
+using namespace bench;
+
+namespace
+{
+
+constexpr int Frames = 600;
+constexpr double Step = 1.0 / 120.0;
+constexpr std::chrono::microseconds FrameTime(16667);
+
+struct Run
+{
+    std::vector<timer::Tick> steps;  // as passed to the step callback
+    std::vector<timer::Tick> frames; // as returned by each Tick
+};
+
+bool Same(const timer::Tick& a, const timer::Tick& b)
+{
+    return a.totalTime == b.totalTime && a.deltaTime == b.deltaTime && a.frameCount == b.frameCount && a.alpha == b.alpha;
+}
+
+bool Same(const std::vector<timer::Tick>& a, const std::vector<timer::Tick>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!Same(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+Run Simulate()
+{
+    timer::VirtualClock clock;
+    GameTimer gameTimer(clock, Step);
+
+    Run run;
+    run.steps.reserve(Frames * 2);
+    run.frames.reserve(Frames);
+
+    for (int i = 0; i < Frames; i++) {
+        clock.Advance(FrameTime);
+        run.frames.push_back(gameTimer.Tick([&](const timer::Tick& step) { run.steps.push_back(step); }));
+    }
+    return run;
+}
+
+// MARK: - FrameTimeRecorder
+
+using timer::FrameTimeRecorder;
+
+constexpr uint64_t Budget = 16666667;
+
+// Inclusive range of values bucket `index` holds
+uint64_t BucketLowerBound(size_t index)
+{
+    return index == 0 ? 0 : FrameTimeRecorder::BucketUpperBound(index - 1) + 1;
+}
+
+bool InBucket(uint64_t value)
+{
+    size_t index = FrameTimeRecorder::BucketIndex(value);
+    if (index >= FrameTimeRecorder::BucketCount) return false;
+
+    uint64_t lower = BucketLowerBound(index);
+    uint64_t upper = FrameTimeRecorder::BucketUpperBound(index);
+    uint64_t width = upper - lower + 1;
+    return lower <= value && value <= upper && width <= std::max<uint64_t>(1, lower / FrameTimeRecorder::SubBuckets);
+}
+
+// Everything below 2^16, every bucket edge and a million random values
+bool CheckBuckets()
+{
+    bool ok = true;
+    for (uint64_t value = 0; value < (1 << 16); value++)
+        ok = ok && InBucket(value);
+
+    for (size_t i = 0; i < FrameTimeRecorder::BucketCount; i++) {
+        uint64_t lower = BucketLowerBound(i);
+        uint64_t upper = FrameTimeRecorder::BucketUpperBound(i);
+        ok = ok && FrameTimeRecorder::BucketIndex(lower) == i && FrameTimeRecorder::BucketIndex(upper) == i;
+    }
+    ok = ok && FrameTimeRecorder::BucketUpperBound(FrameTimeRecorder::BucketCount - 1) == UINT64_MAX;
+
+    std::mt19937_64 rng(11);
+    for (int i = 0; i < 1000000; i++)
+        ok = ok && InBucket(rng() >> (rng() % 64));
+
+    return ok;
+}
+
+// Mostly on budget with some jitter, one frame in ten late and one in a hundred a hitch
+std::vector<uint64_t> SyntheticFrames(size_t count)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint64_t> onTime(15000000, 17500000);
+    std::uniform_int_distribution<uint64_t> late(18000000, 34000000);
+    std::uniform_int_distribution<uint64_t> hitch(50000000, 120000000);
+
+    std::vector<uint64_t> frames(count);
+    for (uint64_t& frame : frames) {
+        uint32_t roll = rng() % 100;
+        frame = roll == 0 ? hitch(rng) : roll < 10 ? late(rng) : onTime(rng);
+    }
+    return frames;
+}
+
+// Same ranks as FrameTimeRecorder
+timer::FrameTimeSummary Exact(std::vector<uint64_t> frames)
+{
+    timer::FrameTimeSummary summary;
+    summary.count = frames.size();
+    if (frames.empty()) return summary;
+
+    std::sort(frames.begin(), frames.end());
+    auto rank = [&](uint64_t percent) { return frames[std::min<uint64_t>(frames.size() - 1, frames.size() * percent / 100)]; };
+
+    summary.p50 = rank(50);
+    summary.p90 = rank(90);
+    summary.p99 = rank(99);
+    summary.max = frames.back();
+    summary.overBudget = static_cast<uint64_t>(std::count_if(frames.begin(), frames.end(), [](uint64_t f) { return f > Budget; }));
+    return summary;
+}
+
+bool Equal(const timer::FrameTimeSummary& a, const timer::FrameTimeSummary& b)
+{
+    return a.count == b.count && a.p50 == b.p50 && a.p90 == b.p90 && a.p99 == b.p99 && a.max == b.max && a.overBudget == b.overBudget;
+}
+
+// Upper bound of the bucket the exact value falls in, capped at the max
+uint64_t Bucketed(uint64_t exact, uint64_t max)
+{
+    return std::min(FrameTimeRecorder::BucketUpperBound(FrameTimeRecorder::BucketIndex(exact)), max);
+}
+
+void PrintSummary(const char* name, const timer::FrameTimeSummary& s)
+{
+    printf(
+        "%-12s %6llu %9.3f %9.3f %9.3f %9.3f %6llu\n", name,
+        static_cast<unsigned long long>(s.count), s.p50 / 1e6, s.p90 / 1e6, s.p99 / 1e6, s.max / 1e6,
+        static_cast<unsigned long long>(s.overBudget)
+    );
+}
+
+bool CheckRecorder(size_t count)
+{
+    std::vector<uint64_t> frames = SyntheticFrames(count);
+
+    FrameTimeRecorder recorder(Budget);
+    for (uint64_t frame : frames)
+        recorder.Record(frame);
+
+    printf("%-12s %6s %9s %9s %9s %9s %6s\n", "frames", "count", "p50 ms", "p90 ms", "p99 ms", "max ms", "over");
+
+    bool ok = true;
+    for (size_t window : {size_t(1), size_t(7), size_t(100), size_t(1000), FrameTimeRecorder::SampleCount, size_t(4096)}) {
+        size_t n = std::min({window, FrameTimeRecorder::SampleCount, count});
+        timer::FrameTimeSummary recorded = recorder.Window(window);
+        timer::FrameTimeSummary exact = Exact({frames.end() - static_cast<ptrdiff_t>(n), frames.end()});
+
+        char name[32];
+        snprintf(name, sizeof(name), "window %zu", window);
+        PrintSummary(name, recorded);
+
+        if (!Equal(recorded, exact)) {
+            PrintSummary("  exact", exact);
+            ok = false;
+        }
+    }
+
+    // The histogram rounds each percentile up to its bucket's upper bound
+    timer::FrameTimeSummary all = recorder.SinceReset();
+    timer::FrameTimeSummary exact = Exact(frames);
+    PrintSummary("since reset", all);
+    PrintSummary("  exact", exact);
+
+    ok = ok && all.count == exact.count && all.max == exact.max && all.overBudget == exact.overBudget;
+    ok = ok && all.p50 == Bucketed(exact.p50, exact.max) && all.p90 == Bucketed(exact.p90, exact.max)
+         && all.p99 == Bucketed(exact.p99, exact.max);
+
+    // Reset clears the histogram but not the samples Window() reads
+    recorder.Reset();
+    std::vector<uint64_t> again(frames.begin(), frames.begin() + 100);
+    for (uint64_t frame : again)
+        recorder.Record(frame);
+    frames.insert(frames.end(), again.begin(), again.end());
+
+    timer::FrameTimeSummary afterReset = recorder.SinceReset();
+    timer::FrameTimeSummary exactAgain = Exact(again);
+    ok = ok && afterReset.count == 100 && afterReset.max == exactAgain.max && afterReset.overBudget == exactAgain.overBudget;
+    ok = ok && Equal(recorder.Window(200), Exact({frames.end() - 200, frames.end()}));
+    ok = ok && recorder.GetTotalCount() == count + 100;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    size_t recorded = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000;
+    if (iterations <= 0) iterations = 1;
+    if (recorded < 100) recorded = 100;
+
+    Run first = Simulate();
+    Run second = Simulate();
+
+    // What the fixed step should leave over, in StepTimer ticks
+    uint64_t step = DX::StepTimer::SecondsToTicks(Step);
+    uint64_t frame = static_cast<uint64_t>(FrameTime.count()) * DX::StepTimer::TicksPerSecond / 1000000;
+    uint64_t elapsed = frame * Frames;
+    double alpha = static_cast<double>(elapsed % step) / static_cast<double>(step);
+
+    bool steady = true;
+    for (size_t i = 0; i < first.steps.size(); i++) {
+        const timer::Tick& tick = first.steps[i];
+        steady = steady && tick.frameCount == i + 1 && tick.deltaTime == DX::StepTimer::TicksToSeconds(step)
+                 && tick.totalTime == DX::StepTimer::TicksToSeconds(step * (i + 1));
+    }
+
+    const timer::Tick& last = first.frames.back();
+    bool counted = first.steps.size() == 1200 && elapsed / step == 1200 && last.frameCount == 1200;
+    bool blended = last.alpha == alpha;
+    bool repeated = Same(first.steps, second.steps) && Same(first.frames, second.frames);
+
+    printf("%d frames of %lld us at a %.4f s step\n", Frames, static_cast<long long>(FrameTime.count()), Step);
+    printf("steps %zu (expected 1200), last frame %llu\n", first.steps.size(), static_cast<unsigned long long>(last.frameCount));
+    printf("alpha %.6f (expected %.6f)\n", last.alpha, alpha);
+    printf("every step one fixed step long: %s\n", steady ? "yes" : "no");
+    printf("second run identical: %s\n", repeated ? "yes" : "no");
+
+    double us = BestUs(iterations, [] { Simulate(); });
+    printf("%d frames stepped in %.1f us\n", Frames, us);
+
+    // GameTimer records the unclamped frame time against a budget of one step
+    timer::VirtualClock clock;
+    GameTimer gameTimer(clock, Step);
+    for (int i = 0; i < Frames; i++) {
+        clock.Advance(FrameTime);
+        gameTimer.Tick();
+    }
+    timer::FrameTimeSummary frameTimes = gameTimer.FrameTimes().Window(Frames);
+    bool recordedFrames = frameTimes.count == Frames && frameTimes.p50 == static_cast<uint64_t>(FrameTime.count()) * 1000
+                          && frameTimes.max == frameTimes.p50 && frameTimes.overBudget == Frames;
+    printf("frame times p50 %.3f ms, %llu of %d over the step\n", frameTimes.p50 / 1e6,
+           static_cast<unsigned long long>(frameTimes.overBudget), Frames);
+
+    bool ok = counted && blended && steady && repeated && recordedFrames;
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+
+    bool buckets = CheckBuckets();
+    printf("\nbuckets: every value inside its bucket, buckets at most 1/%u wide: %s\n",
+           FrameTimeRecorder::SubBuckets, buckets ? "yes" : "no");
+
+    bool percentiles = CheckRecorder(recorded);
+    ok = ok && buckets && percentiles;
+    printf("%s\n", buckets && percentiles ? "ok" : "MISMATCH");
+    return ok ? 0 : 1;
+}
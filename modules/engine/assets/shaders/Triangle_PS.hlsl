@@ -12,15 +12,6 @@ struct PixelInput
 
 float4 main(PixelInput input) : SV_TARGET
 {
-    float3 color = input.color;
-
-    switch (input.instanceID) {
-    case 1: break;
-    case 2: color.r = 1.0; break;
-    case 3: color.b = 1.0; break;
-    case 6: color.rgb = 1.0; break;
-    default: color.rb = 0.0; break;
-    }
-
-    return float4(color, 1.0);
+    // Tinted per instance in Triangle_VS
+    return float4(input.color, 1.0);
 }
\ No newline at end of file
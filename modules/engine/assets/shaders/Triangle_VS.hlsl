@@ -1,12 +1,22 @@
 cbuffer ShaderConstants : register(b0)
 {
-    float4x4 model;
-    float4x4 modelRotated;
     float4x4 viewProjection;
     float time;
     float3 padding;
 };
 
+// Mirrors canvas::InstanceData; the root SRV starts at the draw's first instance
+struct InstanceData
+{
+    float4 world[3]; // columns of the row-vector world matrix
+    float3 colorScale;
+    float distortion;
+    float3 colorBias;
+    float instancePadding;
+};
+
+StructuredBuffer<InstanceData> instances : register(t0);
+
 struct VertexInput
 {
     float3 position : POSITION;
@@ -22,13 +32,6 @@ struct VertexOutput
     nointerpolation uint instanceID : TEXCOORD2;
 };
 
-// Helper method to compute an orbiting offset around the Y axis
-float3 ComputeOrbitOffset(float radius, float speed, float t)
-{
-    float angle = t * speed;
-    return float3(cos(angle) * radius, 0.0, sin(angle) * radius);
-}
-
 // Calculate normal based on vertex ID (cube faces)
 float3 GetCubeNormal(uint vertexID)
 {
@@ -56,75 +59,25 @@ float3 Distort(float3 position, uint vertexID)
     return distorted;
 }
 
-float3 Shake(float3 position)
-{
-    float shakeInterval = 1.5;
-    float shakeDuration = 0.4;
-    
-    float cycleTime = fmod(time, shakeInterval);
-    
-    if (cycleTime > shakeDuration) {
-        return position;
-    }
-
-    float shakeIntensity = 0.15;
-    float shakeFreq = 150.0;
-    
-    float t = cycleTime / shakeDuration;
-    float envelope = sin(t * 3.14159) * (1.0 - t);
-    
-    float3 shake = float3(
-        sin(time * shakeFreq) * shakeIntensity * envelope,
-        sin(time * shakeFreq * 1.3) * shakeIntensity * envelope,
-        sin(time * shakeFreq * 0.7) * shakeIntensity * envelope
-    );
-    
-    return position + shake;
-}
-
 VertexOutput main(VertexInput input, uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
 {
     VertexOutput output;
+    InstanceData instance = instances[instanceID];
 
-    float4x4 transform = model;
-    float3 instanceOffset = float3(0.0, 0.0, 0.0);
-    float distance = 5.0;
-    float3 color = input.color;
-
-    switch (instanceID) {
-    case 3:
-        instanceOffset = float3(0.0, 0.0, 0.0);
-        transform = modelRotated;
-        break;
-
-    case 1:
-        instanceOffset = Shake(float3( distance, 0.0, 0.0));
-        color.r = 0.0;
-        color.b += 1.0 - fmod(time, 1.5) * 0.5 - 0.5;
-        break;
-
-    case 2: instanceOffset = Distort(float3( 0.0, 0.0, -distance), vertexID); break;
-    case 0: instanceOffset = float3( 0.0, 0.0, distance); break;
-    case 4: instanceOffset = float3( 0.0, -distance, 0.0); break;
-    case 5: instanceOffset = float3( 0.0, distance, 0.0); break;
-    case 6: instanceOffset = ComputeOrbitOffset(8.0, 2.0, time); break;
-    default: break;
-    }
-
-    // Apply instance offset to vertex position
-    float3 worldPos = input.position + instanceOffset;
-    float4 world = mul(float4(worldPos, 1.0), transform);
+    float3 position = lerp(input.position, Distort(input.position, vertexID), instance.distortion);
+    float4 local = float4(position, 1.0);
+    float4 world = float4(dot(instance.world[0], local), dot(instance.world[1], local), dot(instance.world[2], local), 1.0);
     output.position = mul(world, viewProjection);
-    
+
     // Output world position for lighting
     output.worldPos = world.xyz;
-    
+
     // Calculate and transform normal (assuming uniform scaling)
     float3 normal = GetCubeNormal(vertexID);
-    output.normal = mul(normal, (float3x3)transform);
-    
-    output.color = color;
+    output.normal = float3(dot(instance.world[0].xyz, normal), dot(instance.world[1].xyz, normal), dot(instance.world[2].xyz, normal));
+
+    output.color = input.color * instance.colorScale + instance.colorBias;
     output.instanceID = instanceID;
 
     return output;
-}
\ No newline at end of file
+}
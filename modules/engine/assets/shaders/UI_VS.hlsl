@@ -1,6 +1,5 @@
 cbuffer ShaderConstants : register(b0)
 {
-    float4x4 model;
     float4x4 viewProjection;
 };
 
@@ -14,4 +14,7 @@ int Run(Engine* app, HINSTANCE hInstance, int nCmdShow);
 
 // Utility function
 void ExitGame() noexcept;
+
+// Writes the flight recorder to logs/crash.flight; safe to call from a crash handler
+void DumpFlightRecorder() noexcept;
 } // namespace IEngine
@@ -3,6 +3,8 @@
 #include "canvas/Renderer.h"
 #include "common/AsyncBuf.h"
 #include "common/AsyncLogger.h"
+#include "common/JobSystem.h"
+#include "common/Log.h"
 #include "input/InputController.h"
 #include "pch.h"
 
@@ -11,6 +13,14 @@ using namespace canvas;
 using namespace input;
 using namespace DX;
 
+Engine::~Engine() noexcept
+{
+    // The window logs while it is destroyed, let that reach the logger first
+    m_windowManager.reset();
+
+    logging::Log::SetLogger(nullptr);
+}
+
 int Engine::Run(HINSTANCE hInstance, int nCmdShow)
 {
     if (!XMVerifyCPUSupport())
@@ -33,8 +43,21 @@ bool Engine::Initialize(HINSTANCE hInstance, int nCmdShow)
     m_buf = std::make_unique<AsyncBuf>(*m_logger);
     m_asyncOut = std::make_unique<std::ostream>(m_buf.get());
 
-    std::cout.rdbuf(m_asyncOut->rdbuf()); // <-- теперь cout пишет в очередь
-    std::cout.setf(std::ios::unitbuf);    // авто-flush на каждую запись
+    logging::Log::SetLogger(m_logger.get());
+
+    // Recent records and frames survive a crash in logs/crash.flight
+    logging::FlightRecorder::SetDumpPath("logs/crash.flight");
+    logging::FlightRecorder::InstallCrashHandler();
+
+    // Anything still writing to std::cout lands in the log line by line
+    std::cout.rdbuf(m_asyncOut->rdbuf());
+
+    // High-frequency diagnostics go to logs/engine.blog, see modules/logdecode
+    m_binaryLog = std::make_unique<logging::BinaryLog>();
+    logging::BinaryLog::SetCurrent(m_binaryLog.get());
+
+    // Workers start here so the main thread owns the job system and helps in waits
+    jobs::Shared();
 
     // Create dependencies
 
@@ -53,9 +76,11 @@ bool Engine::Initialize(HINSTANCE hInstance, int nCmdShow)
         m_deviceResources.get(),
         m_pipelineStore.get(),
         m_resourceHolder.get(),
-        m_scene.get()
+        m_scene.get(),
+        m_stateReducer.get()
     );
     m_windowManager = std::make_unique<WindowManager>();
+    m_framePacer = std::make_unique<timer::FramePacer>();
 
     // Initialize
 
@@ -71,6 +96,13 @@ bool Engine::Initialize(HINSTANCE hInstance, int nCmdShow)
     m_deviceResources->Initialize(hwnd, m_renderer.get());
     m_stateReducer->Initialize(hwnd, nCmdShow);
 
+    // Pace to the display only when presenting uncapped. With vsync Present already
+    // blocks on the vblank, and a second limiter at the same rate beats against it.
+    if (!m_deviceResources->IsTearingAllowed())
+        m_framePacer->SetTargetRate(0.0);
+    else if (auto hz = m_stateReducer->getRefreshRate(); hz > 0.0)
+        m_framePacer->SetTargetRate(hz);
+
 #ifdef _DEBUG
     m_deviceResources->HandleDeviceLost(); // restart the resources to trigger memory warnings
 #endif
@@ -86,10 +118,30 @@ int Engine::MessageLoop()
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
-        else {
+        else if (m_framePacer->Wait()) {
             m_windowManager->Idle();
+            ReportPacing();
         }
     }
 
     return static_cast<int>(msg.wParam);
 }
+
+void Engine::ReportPacing()
+{
+    constexpr uint64_t ReportEvery = 1024;
+    if (m_framePacer->GetFrameCount() % ReportEvery != 0) return;
+
+    auto lateness = m_framePacer->Lateness().Window(ReportEvery);
+
+    YANG_LOG(
+        INFO,
+        GENERAL,
+        "pacing ", m_framePacer->GetTargetRate(), " Hz",
+        " | slept ms: ", m_framePacer->GetSleptTime() / 1000000,
+        " | spun ms: ", m_framePacer->GetSpunTime() / 1000000,
+        " | late us p50: ", lateness.p50 / 1000,
+        " p99: ", lateness.p99 / 1000,
+        " max: ", lateness.max / 1000
+    );
+}
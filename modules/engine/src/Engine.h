@@ -7,6 +7,9 @@
 #include "canvas/Renderer.h"
 #include "canvas/ResourceHolder.h"
 #include "common/AsyncBuf.h"
+#include "common/BinaryLog.h"
+#include "common/FlightRecorder.h"
+#include "common/FramePacer.h"
 #include "device/DeviceResources.h"
 #include "input/InputController.h"
 #include "pipeline/Store.h"
@@ -22,17 +25,19 @@ public:
     Engine& operator=(const Engine&) = delete;
 
     Engine() noexcept = default;
-    ~Engine() noexcept = default;
+    ~Engine() noexcept;
 
     int Run(HINSTANCE hInstance, int nCmdShow);
 
 private:
     bool Initialize(HINSTANCE hInstance, int nCmdShow);
     int MessageLoop();
+    void ReportPacing();
 
     std::unique_ptr<AsyncLogger> m_logger;
     std::unique_ptr<AsyncBuf> m_buf;
     std::unique_ptr<std::ostream> m_asyncOut;
+    std::unique_ptr<logging::BinaryLog> m_binaryLog;
 
     std::unique_ptr<WindowManager> m_windowManager;
     std::unique_ptr<DX::DeviceResources> m_deviceResources;
@@ -42,4 +47,5 @@ private:
     std::unique_ptr<canvas::Renderer> m_renderer;
     std::unique_ptr<window::WindowStateReducer> m_stateReducer;
     std::unique_ptr<input::InputController> m_inputController;
+    std::unique_ptr<timer::FramePacer> m_framePacer;
 };
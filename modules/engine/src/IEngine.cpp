@@ -31,4 +31,9 @@ void ExitGame() noexcept
 {
     PostQuitMessage(0);
 }
+
+void DumpFlightRecorder() noexcept
+{
+    logging::FlightRecorder::Dump();
+}
 } // namespace IEngine
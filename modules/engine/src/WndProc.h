@@ -1,4 +1,5 @@
 #include "WindowManager.h"
+#include "common/Log.h"
 #include "pch.h"
 
 namespace App
@@ -11,12 +12,12 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         auto self = static_cast<WindowManager*>(create_struct->lpCreateParams);
         SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
 
-        std::cout << "WM_NCCREATE, attached WindowManager to HWND";
+        YANG_LOG(DEBUG, WINDOW, "WM_NCCREATE, attached WindowManager to HWND");
 
         return true;
     }
     case WM_DESTROY: {
-        std::cout << "WM_DESTROY -> PostQuitMessage(0)";
+        YANG_LOG(DEBUG, WINDOW, "WM_DESTROY -> PostQuitMessage(0)");
         PostQuitMessage(0);
         break;
     }
@@ -0,0 +1,498 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "../common/JobSystem.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_BVH_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace canvas;
+
+namespace
+{
+
+struct Box
+{
+    float min[3];
+    float max[3];
+};
+
+constexpr uint32_t Bins = 16;
+// Subtrees with fewer spheres are built in the job that reached them
+constexpr uint32_t ParallelThreshold = 4096;
+// Refit sweeps every node once more than 1 / RefitSweepRatio of the spheres moved
+constexpr size_t RefitSweepRatio = 8;
+// SAH weights of testing a child node against testing a sphere in a leaf
+constexpr double NodeCost = 1.0;
+constexpr double SphereCost = 1.0;
+
+Box EmptyBox() noexcept
+{
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    return {{inf, inf, inf}, {-inf, -inf, -inf}};
+}
+
+void Grow(Box& box, const Box& other) noexcept
+{
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = std::min(box.min[axis], other.min[axis]);
+        box.max[axis] = std::max(box.max[axis], other.max[axis]);
+    }
+}
+
+float Area(const Box& box) noexcept
+{
+    float dx = box.max[0] - box.min[0];
+    float dy = box.max[1] - box.min[1];
+    float dz = box.max[2] - box.min[2];
+    if (dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+Box SphereBox(const SphereBoundsSoA& b, uint32_t i) noexcept
+{
+    float r = b.radius[i];
+    return {{b.x[i] - r, b.y[i] - r, b.z[i] - r}, {b.x[i] + r, b.y[i] + r, b.z[i] + r}};
+}
+
+float Center(const SphereBoundsSoA& b, uint32_t i, int axis) noexcept
+{
+    return axis == 0 ? b.x[i] : axis == 1 ? b.y[i] : b.z[i];
+}
+
+bool SphereVisible(const Frustum& frustum, const SphereBoundsSoA& b, uint32_t i) noexcept
+{
+    for (const Plane& p : frustum.planes) {
+        if (p.a * b.x[i] + p.b * b.y[i] + p.c * b.z[i] + p.d + b.radius[i] < 0.0f) return false;
+    }
+    return true;
+}
+
+void SetSlot(BvhNode& node, uint32_t slot, const Box& box) noexcept
+{
+    node.minX[slot] = box.min[0];
+    node.minY[slot] = box.min[1];
+    node.minZ[slot] = box.min[2];
+    node.maxX[slot] = box.max[0];
+    node.maxY[slot] = box.max[1];
+    node.maxZ[slot] = box.max[2];
+}
+
+Box SlotBox(const BvhNode& node, uint32_t slot) noexcept
+{
+    return {{node.minX[slot], node.minY[slot], node.minZ[slot]}, {node.maxX[slot], node.maxY[slot], node.maxZ[slot]}};
+}
+
+double SlotWeight(const BvhNode& node, uint32_t slot) noexcept
+{
+    return node.child[slot] == Bvh::Leaf ? SphereCost * node.count[slot] : NodeCost;
+}
+
+// Top-down build into preallocated arrays; disjoint subtrees touch disjoint item
+// ranges and nodes, so they can go to different threads
+struct Builder
+{
+    const SphereBoundsSoA& bounds;
+    uint32_t* items;
+    BvhNode* nodes;
+    uint32_t* parent;
+    uint32_t* leafOf;
+    std::atomic<uint32_t> nodeCount{1};
+
+    Box RangeBox(uint32_t first, uint32_t count) const noexcept
+    {
+        Box box = EmptyBox();
+        for (uint32_t k = first; k < first + count; k++) {
+            Grow(box, SphereBox(bounds, items[k]));
+        }
+        return box;
+    }
+
+    // Partitions [first, first + count) at the cheapest of Bins planes per axis and
+    // returns where the second half starts
+    uint32_t Split(uint32_t first, uint32_t count) noexcept
+    {
+        uint32_t last = first + count;
+
+        Box centroids = EmptyBox();
+        for (uint32_t k = first; k < last; k++) {
+            uint32_t i = items[k];
+            Grow(centroids, {{bounds.x[i], bounds.y[i], bounds.z[i]}, {bounds.x[i], bounds.y[i], bounds.z[i]}});
+        }
+
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+        float bestCost = std::numeric_limits<float>::infinity();
+
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = centroids.max[axis] - centroids.min[axis];
+            if (!(extent > 0.0f)) continue;
+
+            float scale = Bins * (1.0f - 1e-5f) / extent;
+
+            Box binBox[Bins];
+            uint32_t binCount[Bins] = {};
+            for (Box& box : binBox)
+                box = EmptyBox();
+
+            for (uint32_t k = first; k < last; k++) {
+                uint32_t i = items[k];
+                uint32_t bin = std::min(Bins - 1, static_cast<uint32_t>((Center(bounds, i, axis) - centroids.min[axis]) * scale));
+                Grow(binBox[bin], SphereBox(bounds, i));
+                binCount[bin]++;
+            }
+
+            // Cost of splitting before bin b: right side swept first, left added on the way back
+            float rightArea[Bins];
+            uint32_t rightCount[Bins];
+            Box box = EmptyBox();
+            uint32_t n = 0;
+            for (uint32_t b = Bins - 1; b > 0; b--) {
+                Grow(box, binBox[b]);
+                n += binCount[b];
+                rightArea[b] = Area(box);
+                rightCount[b] = n;
+            }
+
+            box = EmptyBox();
+            n = 0;
+            for (uint32_t b = 1; b < Bins; b++) {
+                Grow(box, binBox[b - 1]);
+                n += binCount[b - 1];
+                if (n == 0 || rightCount[b] == 0) continue;
+
+                float cost = Area(box) * n + rightArea[b] * rightCount[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        if (bestAxis < 0) return first + count / 2; // every center in one spot
+
+        float minimum = centroids.min[bestAxis];
+        float scale = Bins * (1.0f - 1e-5f) / (centroids.max[bestAxis] - minimum);
+        uint32_t* middle = std::partition(items + first, items + last, [&](uint32_t i) {
+            return std::min(Bins - 1, static_cast<uint32_t>((Center(bounds, i, bestAxis) - minimum) * scale)) < bestBin;
+        });
+
+        return static_cast<uint32_t>(middle - items);
+    }
+
+    // Fills `node` with up to 4 children over [first, first + count), splitting the
+    // largest range until there are 4 or all fit in a leaf
+    void BuildNode(uint32_t node, uint32_t first, uint32_t count, unsigned spawnLevels)
+    {
+        uint32_t rangeFirst[4] = {first};
+        uint32_t rangeCount[4] = {count};
+        uint32_t ranges = 1;
+
+        while (ranges < 4) {
+            uint32_t largest = 4;
+            for (uint32_t r = 0; r < ranges; r++) {
+                if (rangeCount[r] > Bvh::MaxLeafSize && (largest == 4 || rangeCount[r] > rangeCount[largest])) largest = r;
+            }
+            if (largest == 4) break;
+
+            uint32_t middle = Split(rangeFirst[largest], rangeCount[largest]);
+            uint32_t end = rangeFirst[largest] + rangeCount[largest];
+
+            rangeFirst[ranges] = middle;
+            rangeCount[ranges] = end - middle;
+            rangeCount[largest] = middle - rangeFirst[largest];
+            ranges++;
+        }
+
+        BvhNode& out = nodes[node];
+        uint32_t children[4];
+        uint32_t childCount = 0;
+
+        for (uint32_t slot = 0; slot < 4; slot++) {
+            if (slot >= ranges) {
+                SetSlot(out, slot, {});
+                out.child[slot] = Bvh::Empty;
+                out.first[slot] = 0;
+                out.count[slot] = 0;
+                continue;
+            }
+
+            SetSlot(out, slot, RangeBox(rangeFirst[slot], rangeCount[slot]));
+            out.first[slot] = rangeFirst[slot];
+            out.count[slot] = rangeCount[slot];
+
+            if (rangeCount[slot] <= Bvh::MaxLeafSize) {
+                out.child[slot] = Bvh::Leaf;
+                for (uint32_t k = rangeFirst[slot]; k < rangeFirst[slot] + rangeCount[slot]; k++) {
+                    leafOf[items[k]] = node << 2 | slot;
+                }
+            }
+            else {
+                // Allocated after the parent, so children always have larger indices
+                uint32_t child = nodeCount.fetch_add(1, std::memory_order_relaxed);
+                out.child[slot] = child;
+                parent[child] = node << 2 | slot;
+                children[childCount++] = slot;
+            }
+        }
+
+        bool parallel = spawnLevels > 0 && count >= ParallelThreshold;
+        jobs::Counter spawned;
+
+        for (uint32_t c = 0; c < childCount; c++) {
+            uint32_t slot = children[c];
+            uint32_t child = out.child[slot];
+            uint32_t childFirst = out.first[slot];
+            uint32_t childItems = out.count[slot];
+
+            if (parallel && c + 1 < childCount) {
+                jobs::Shared().Run(spawned, [this, child, childFirst, childItems, spawnLevels] {
+                    BuildNode(child, childFirst, childItems, spawnLevels - 1);
+                });
+            }
+            else {
+                BuildNode(child, childFirst, childItems, parallel ? spawnLevels - 1 : 0);
+            }
+        }
+
+        // Helps with the queued subtrees, this one's or anyone's
+        jobs::Shared().Wait(spawned);
+    }
+};
+
+} // namespace
+
+void Bvh::Build(const SphereBoundsSoA& bounds, unsigned threads)
+{
+    if (threads == 0) threads = jobs::Shared().ThreadCount();
+
+    m_size = bounds.count;
+    m_items.clear();
+    m_unbounded.clear();
+    m_leafOf.assign(bounds.count, Empty);
+
+    for (uint32_t i = 0; i < bounds.count; i++) {
+        if (std::isfinite(bounds.radius[i])) {
+            m_items.push_back(i);
+        }
+        else {
+            m_unbounded.push_back(i);
+        }
+    }
+
+    // Every inner node splits its range at least in two, so there are fewer inner
+    // nodes than spheres
+    uint32_t itemCount = static_cast<uint32_t>(m_items.size());
+    m_nodes.resize(std::max(1u, itemCount));
+    m_parent.resize(m_nodes.size());
+    m_parent[0] = Empty;
+
+    // Each level fans out 4 ways
+    unsigned spawnLevels = 0;
+    for (unsigned width = 1; width < threads; width *= 4)
+        spawnLevels++;
+
+    Builder builder{bounds, m_items.data(), m_nodes.data(), m_parent.data(), m_leafOf.data()};
+    builder.BuildNode(0, 0, itemCount, spawnLevels);
+
+    m_nodes.resize(builder.nodeCount.load());
+    m_parent.resize(m_nodes.size());
+    m_dirty.assign(m_nodes.size(), 0);
+
+    m_cost = 0.0;
+    for (const BvhNode& node : m_nodes) {
+        for (uint32_t slot = 0; slot < 4; slot++) {
+            if (node.count[slot]) m_cost += Area(SlotBox(node, slot)) * SlotWeight(node, slot);
+        }
+    }
+
+    m_stale = false;
+    m_builtCost = 0.0f;
+    m_builtCost = Cost();
+}
+
+void Bvh::Refit(const SphereBoundsSoA& bounds, std::span<const uint32_t> changed)
+{
+    if (m_nodes.empty() || changed.empty()) return;
+
+    bool sweep = changed.size() * RefitSweepRatio >= m_items.size();
+
+    for (uint32_t i : changed) {
+        if (i >= m_leafOf.size()) {
+            m_stale = true;
+            continue;
+        }
+
+        uint32_t location = m_leafOf[i];
+        if ((location == Empty) == static_cast<bool>(std::isfinite(bounds.radius[i]))) m_stale = true;
+        if (location == Empty || sweep) continue;
+
+        // Marks the path up to the first node already on it
+        for (uint32_t node = location >> 2; !m_dirty[node];) {
+            m_dirty[node] = 1;
+            m_refitNodes.push_back(node);
+
+            if (m_parent[node] == Empty) break;
+            node = m_parent[node] >> 2;
+        }
+    }
+
+    // Children before parents
+    if (sweep) {
+        for (uint32_t node = static_cast<uint32_t>(m_nodes.size()); node-- > 0;)
+            RefitNode(node, bounds);
+        return;
+    }
+
+    std::sort(m_refitNodes.begin(), m_refitNodes.end(), std::greater<uint32_t>());
+    for (uint32_t node : m_refitNodes) {
+        RefitNode(node, bounds);
+        m_dirty[node] = 0;
+    }
+    m_refitNodes.clear();
+}
+
+bool Bvh::NeedsRebuild() const noexcept
+{
+    return m_stale || Cost() > m_builtCost * RebuildThreshold;
+}
+
+float Bvh::Cost() const noexcept
+{
+    if (m_nodes.empty()) return 0.0f;
+
+    Box root = EmptyBox();
+    for (uint32_t slot = 0; slot < 4; slot++) {
+        if (m_nodes[0].count[slot]) Grow(root, SlotBox(m_nodes[0], slot));
+    }
+
+    float area = Area(root);
+    return area > 0.0f ? static_cast<float>(m_cost / area) : 0.0f;
+}
+
+size_t Bvh::Cull(const Frustum& frustum, const SphereBoundsSoA& bounds, uint32_t* visible)
+{
+    size_t n = 0;
+
+    auto emitRange = [&](uint32_t first, uint32_t count) {
+        for (uint32_t k = first; k < first + count; k++)
+            visible[n++] = m_items[k];
+    };
+    auto testRange = [&](uint32_t first, uint32_t count) {
+        for (uint32_t k = first; k < first + count; k++) {
+            visible[n] = m_items[k];
+            n += SphereVisible(frustum, bounds, m_items[k]);
+        }
+    };
+
+    if (!m_items.empty()) {
+        m_stack.clear();
+        m_stack.push_back(0);
+    }
+
+    while (!m_stack.empty()) {
+        const BvhNode& node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+
+        // Per child: some plane has the whole box behind it, or every plane has it
+        // all in front. The corner farthest along the normal decides the first, the
+        // nearest one the second.
+        unsigned outside = 0;
+        unsigned inside = 0xF;
+
+#ifdef YANG_BVH_X86
+        __m128 out = _mm_setzero_ps();
+        __m128 in = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const Plane& p : frustum.planes) {
+            __m128 a = _mm_set1_ps(p.a), b = _mm_set1_ps(p.b), c = _mm_set1_ps(p.c), d = _mm_set1_ps(p.d);
+
+            auto distance = [&](const float* xs, const float* ys, const float* zs) {
+                __m128 xy = _mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(xs)), _mm_mul_ps(b, _mm_loadu_ps(ys)));
+                return _mm_add_ps(xy, _mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(zs)), d));
+            };
+
+            __m128 farthest = distance(p.a >= 0.0f ? node.maxX : node.minX, p.b >= 0.0f ? node.maxY : node.minY, p.c >= 0.0f ? node.maxZ : node.minZ);
+            __m128 nearest = distance(p.a >= 0.0f ? node.minX : node.maxX, p.b >= 0.0f ? node.minY : node.maxY, p.c >= 0.0f ? node.minZ : node.maxZ);
+
+            out = _mm_or_ps(out, _mm_cmplt_ps(farthest, _mm_setzero_ps()));
+            in = _mm_and_ps(in, _mm_cmpge_ps(nearest, _mm_setzero_ps()));
+        }
+
+        outside = static_cast<unsigned>(_mm_movemask_ps(out));
+        inside = static_cast<unsigned>(_mm_movemask_ps(in));
+#else
+        for (uint32_t slot = 0; slot < 4; slot++) {
+            for (const Plane& p : frustum.planes) {
+                auto distance = [&](const float* xs, const float* ys, const float* zs) {
+                    return p.a * xs[slot] + p.b * ys[slot] + p.c * zs[slot] + p.d;
+                };
+
+                float farthest = distance(p.a >= 0.0f ? node.maxX : node.minX, p.b >= 0.0f ? node.maxY : node.minY, p.c >= 0.0f ? node.maxZ : node.minZ);
+                float nearest = distance(p.a >= 0.0f ? node.minX : node.maxX, p.b >= 0.0f ? node.minY : node.maxY, p.c >= 0.0f ? node.minZ : node.maxZ);
+
+                if (farthest < 0.0f) outside |= 1u << slot;
+                if (!(nearest >= 0.0f)) inside &= ~(1u << slot);
+            }
+        }
+#endif
+
+        for (uint32_t slot = 0; slot < 4; slot++) {
+            if (node.count[slot] == 0 || (outside >> slot & 1)) continue;
+
+            if (inside >> slot & 1) {
+                emitRange(node.first[slot], node.count[slot]);
+            }
+            else if (node.child[slot] == Leaf) {
+                testRange(node.first[slot], node.count[slot]);
+            }
+            else {
+                m_stack.push_back(node.child[slot]);
+            }
+        }
+    }
+
+    for (uint32_t i : m_unbounded) {
+        visible[n] = i;
+        n += SphereVisible(frustum, bounds, i);
+    }
+
+    return n;
+}
+
+// MARK: - Private
+
+// Refits every child box of `node` from its spheres or its child node's boxes
+void Bvh::RefitNode(uint32_t node, const SphereBoundsSoA& bounds) noexcept
+{
+    BvhNode& out = m_nodes[node];
+
+    for (uint32_t slot = 0; slot < 4; slot++) {
+        if (out.count[slot] == 0) continue;
+
+        Box box = EmptyBox();
+        if (out.child[slot] == Leaf) {
+            for (uint32_t k = out.first[slot]; k < out.first[slot] + out.count[slot]; k++) {
+                Grow(box, SphereBox(bounds, m_items[k]));
+            }
+        }
+        else {
+            const BvhNode& child = m_nodes[out.child[slot]];
+            for (uint32_t c = 0; c < 4; c++) {
+                if (child.count[c]) Grow(box, SlotBox(child, c));
+            }
+        }
+
+        double weight = SlotWeight(out, slot);
+        m_cost += (double(Area(box)) - Area(SlotBox(out, slot))) * weight;
+        SetSlot(out, slot, box);
+    }
+}
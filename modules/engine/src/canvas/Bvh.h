@@ -0,0 +1,90 @@
+//
+// Bvh.h - Bounding volume hierarchy over scene bounds for frustum queries
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Culling.h"
+
+namespace canvas
+{
+
+// Four children per node with their boxes stored per axis, so one SSE test covers
+// all of them. Every child also records the item range under it, which lets a
+// subtree fully inside the frustum be emitted without descending.
+struct BvhNode
+{
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    uint32_t child[4]; // node index, Bvh::Leaf or Bvh::Empty
+    uint32_t first[4]; // into the item array
+    uint32_t count[4];
+};
+
+// Binned SAH tree over the boxes around bounding spheres, collapsed to 4-wide nodes
+// in one flat array. Moving objects are refit in place, touching only their path to
+// the root; once refitting has degraded the SAH cost past RebuildThreshold, or the
+// object set changed, the owner rebuilds it.
+class Bvh final
+{
+public:
+    static constexpr uint32_t Leaf = UINT32_MAX - 1;
+    static constexpr uint32_t Empty = UINT32_MAX;
+    static constexpr uint32_t MaxLeafSize = 4;
+    // SAH cost relative to the last build past which NeedsRebuild turns true
+    static constexpr float RebuildThreshold = 1.5f;
+
+    // Disallow copy / assign
+    Bvh(const Bvh&) = delete;
+    Bvh& operator=(const Bvh&) = delete;
+
+    Bvh() = default;
+
+    // Over every sphere in `bounds`; spheres without a finite radius stay out of the
+    // tree and are tested on every query. Subtrees become jobs on the shared job
+    // system, enough for up to `threads` threads (0 = all of its threads).
+    void Build(const SphereBoundsSoA& bounds, unsigned threads = 0);
+    // Fits the boxes again after the `changed` spheres moved
+    void Refit(const SphereBoundsSoA& bounds, std::span<const uint32_t> changed);
+    bool NeedsRebuild() const noexcept;
+
+    // Writes the indices of the spheres that intersect the frustum to `visible`, in
+    // no particular order, and returns how many were written; the same set as
+    // CullSpheres. `bounds` must be what the tree was last built or refit over.
+    size_t Cull(const Frustum&, const SphereBoundsSoA& bounds, uint32_t* visible);
+
+    // Number of spheres the tree was built over
+    size_t Size() const noexcept { return m_size; }
+    std::span<const BvhNode> Nodes() const noexcept { return m_nodes; }
+    // SAH cost now and right after the last build, relative to the root box
+    float Cost() const noexcept;
+    float BuiltCost() const noexcept { return m_builtCost; }
+
+private:
+    void RefitNode(uint32_t node, const SphereBoundsSoA& bounds) noexcept;
+
+    std::vector<BvhNode> m_nodes;
+    std::vector<uint32_t> m_items;     // sphere indices, grouped by subtree
+    std::vector<uint32_t> m_unbounded; // non-finite spheres, tested every query
+
+    // Per node and per sphere: (node << 2 | child slot) pointing at the parent or the
+    // leaf, Empty for the root and for unbounded spheres
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_leafOf;
+
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint32_t> m_refitNodes;
+    std::vector<uint32_t> m_stack;
+
+    size_t m_size = 0;
+    double m_cost = 0.0; // sum of child box areas weighted by their cost
+    float m_builtCost = 0.0f;
+    bool m_stale = false; // a sphere became or stopped being unbounded
+};
+
+} // namespace canvas
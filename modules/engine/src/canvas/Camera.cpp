@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "../common/BinaryLog.h"
 
 using namespace canvas;
 using namespace DirectX;
@@ -14,6 +15,9 @@ Camera::Camera(
 
 void Camera::Prepare(timer::Tick tick)
 {
+    m_previousPosition = m_state.position;
+    m_previousPitchYaw = m_state.pitchYaw;
+
     m_state.aspectRatio = m_stateReducer->getAspectRatio();
     MoveEye(m_inputController->CollectMouseDelta());
 
@@ -21,16 +25,32 @@ void Camera::Prepare(timer::Tick tick)
 
     if (m_inputController->IsKeyPressed('M'))
         m_state.pitchYaw.x = 0.0f; // reset camera vertically
+
+    YANG_BLOG(
+        DEBUG,
+        "camera position {} {} {} pitch {} yaw {}",
+        m_state.position.x,
+        m_state.position.y,
+        m_state.position.z,
+        m_state.pitchYaw.x,
+        m_state.pitchYaw.y
+    );
 }
 
-DirectX::XMMATRIX Camera::CameraViewProjection()
+DirectX::XMMATRIX Camera::CameraViewProjection(float alpha)
 {
-    auto direction = XMVectorSet(m_state.eyeDirection.x, m_state.eyeDirection.y, m_state.eyeDirection.z, 1.f);
-    // make sure direction is no zero vector
-    if (XMVector3Equal(direction, XMVectorZero())) direction = XMVectorSet(0.0f, 0.0f, 1.0f, 1.f);
+    auto position = XMVectorLerp(XMLoadFloat3(&m_previousPosition), XMLoadFloat3(&m_state.position), alpha);
+    auto pitchYaw = XMVectorLerp(XMLoadFloat2(&m_previousPitchYaw), XMLoadFloat2(&m_state.pitchYaw), alpha);
+
+    float sinPitch, cosPitch, sinYaw, cosYaw;
+    DirectX::XMScalarSinCos(&sinPitch, &cosPitch, XMVectorGetX(pitchYaw));
+    DirectX::XMScalarSinCos(&sinYaw, &cosYaw, XMVectorGetY(pitchYaw));
+
+    // same spherical to vector conversion as MoveEye
+    auto direction = XMVectorSet(sinYaw * cosPitch, sinPitch, cosYaw * cosPitch, 1.f);
 
     auto view = XMMatrixLookToLH(
-        XMVectorSet(m_state.position.x, m_state.position.y, m_state.position.z, 1.f),
+        XMVectorSetW(position, 1.f),
         direction,
         XMVectorSet(0.f, 1.f, 0.f, 0.f)
     );
@@ -45,6 +65,25 @@ DirectX::XMMATRIX Camera::CameraViewProjection()
     return view * projection;
 }
 
+Frustum Camera::FrustumPlanes(float alpha)
+{
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, CameraViewProjection(alpha));
+    return FrustumFromMatrix(viewProjection.m);
+}
+
+LodView Camera::LodViewpoint(float alpha)
+{
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, XMVectorLerp(XMLoadFloat3(&m_previousPosition), XMLoadFloat3(&m_state.position), alpha));
+
+    // projection[1][1] of XMMatrixPerspectiveFovLH
+    float height = static_cast<float>(m_stateReducer->getHeight());
+    float yScale = 1.0f / std::tan(m_state.fovRadians * 0.5f);
+
+    return {{eye.x, eye.y, eye.z}, height * yScale * 0.5f};
+}
+
 // MARK: - Private
 
 inline Int3 Camera::MoveDirection()
@@ -4,6 +4,8 @@
 #include "../input/InputController.h"
 #include "../pch.h"
 #include "../window/WindowStateReducer.h"
+#include "Culling.h"
+#include "LodSelector.h"
 #include "Models.h"
 
 namespace canvas
@@ -32,12 +34,22 @@ public:
     Camera(input::InputController*, window::WindowStateReducer*) noexcept;
     ~Camera() noexcept = default;
 
+    // One fixed simulation step
     void Prepare(timer::Tick);
-    DirectX::XMMATRIX CameraViewProjection();
+    // View-projection between the previous and the current step
+    DirectX::XMMATRIX CameraViewProjection(float alpha = 1.0f);
+    // Normalized world-space planes of the same view-projection, for canvas::CullSpheres/CullAabbs
+    Frustum FrustumPlanes(float alpha = 1.0f);
+    // Eye position and projection scale at the same point, for LodSelector
+    LodView LodViewpoint(float alpha = 1.0f);
 
 private:
     CameraState m_state{};
 
+    // Pose at the start of the last step
+    Float3 m_previousPosition = {0.0f, 0.0f, 0.0f};
+    Float2 m_previousPitchYaw = {0.0f, 0.0f};
+
     input::InputController* m_inputController;
     window::WindowStateReducer* m_stateReducer;
 
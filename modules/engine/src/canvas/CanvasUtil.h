@@ -0,0 +1,59 @@
+//
+// CanvasUtil.h - Small helpers the canvas passes share: matrix product and stage timing
+//
+
+#pragma once
+
+#include <chrono>
+
+#include "TransformHierarchy.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_CANVAS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace canvas
+{
+
+// out = a * b, row vectors
+inline void Multiply(const Matrix4& a, const Matrix4& b, Matrix4& out) noexcept
+{
+#ifdef YANG_CANVAS_X86
+    __m128 b0 = _mm_loadu_ps(b.m[0]);
+    __m128 b1 = _mm_loadu_ps(b.m[1]);
+    __m128 b2 = _mm_loadu_ps(b.m[2]);
+    __m128 b3 = _mm_loadu_ps(b.m[3]);
+
+    for (int r = 0; r < 4; r++) {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(a.m[r][0]), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[r][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[r][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[r][3]), b3));
+        _mm_storeu_ps(out.m[r], row);
+    }
+#else
+    Matrix4 result;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+        }
+    }
+    out = result;
+#endif
+}
+
+inline Matrix4 Multiply(const Matrix4& a, const Matrix4& b) noexcept
+{
+    Matrix4 out;
+    Multiply(a, b, out);
+    return out;
+}
+
+// Milliseconds since `start`, for the per-pass timings in the stats structs
+inline double MsSince(std::chrono::steady_clock::time_point start) noexcept
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace canvas
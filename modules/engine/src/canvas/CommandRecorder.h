@@ -0,0 +1,226 @@
+//
+// CommandRecorder.h - Command list wrapper that drops redundant state changes
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace canvas
+{
+
+// Per-frame call statistics; draws are always issued and counted separately
+struct RecorderCounters
+{
+    uint32_t issued = 0;
+    uint32_t skipped = 0;
+    uint32_t draws = 0;
+};
+
+// Forwards state calls to `Api::CommandList` only when they change what is bound.
+// `Api` names the list and argument types, D3D12Api in D3D12Recorder.h for the
+// renderer, or a recording fake to check the filtering without a device.
+//
+// The cache covers one recording: call Begin after every list Reset and whenever
+// state was set around the recorder.
+template <typename Api>
+class CommandRecorder final
+{
+public:
+    using CommandList = typename Api::CommandList;
+    using RootSignature = typename Api::RootSignature;
+    using PipelineState = typename Api::PipelineState;
+    using DescriptorHeap = typename Api::DescriptorHeap;
+    using Topology = typename Api::Topology;
+    using VertexBufferView = typename Api::VertexBufferView;
+    using IndexBufferView = typename Api::IndexBufferView;
+    using GpuAddress = typename Api::GpuAddress;
+
+    static constexpr uint32_t MaxVertexBuffers = 4;
+    static constexpr uint32_t MaxRootParameters = 8;
+    static constexpr uint32_t MaxDescriptorHeaps = 2;
+
+    // Disallow copy / assign
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    CommandRecorder() = default;
+
+    // Starts a recording on `list` with nothing known to be bound
+    void Begin(CommandList* list) noexcept
+    {
+        m_list = list;
+        m_counters = {};
+        Invalidate();
+    }
+
+    // Forgets all bound state, e.g. after the list was used directly
+    void Invalidate() noexcept
+    {
+        m_rootSignature = nullptr;
+        m_pipelineState = nullptr;
+        m_topology = {};
+        m_hasTopology = false;
+        m_heapCount = UINT32_MAX;
+        m_hasIndexBuffer = false;
+        m_vertexBufferMask = 0;
+        m_rootViewMask = 0;
+    }
+
+    CommandList* Get() const noexcept { return m_list; }
+    const RecorderCounters& GetCounters() const noexcept { return m_counters; }
+
+    // MARK: - State
+
+    void SetDescriptorHeaps(uint32_t count, DescriptorHeap* const* heaps)
+    {
+        bool same = count == m_heapCount;
+        for (uint32_t i = 0; same && i < count; i++) {
+            same = heaps[i] == m_heaps[i];
+        }
+        if (Skip(same)) return;
+
+        m_heapCount = count <= MaxDescriptorHeaps ? count : UINT32_MAX;
+        for (uint32_t i = 0; i < count && i < MaxDescriptorHeaps; i++) {
+            m_heaps[i] = heaps[i];
+        }
+        m_list->SetDescriptorHeaps(count, heaps);
+    }
+
+    void SetGraphicsRootSignature(RootSignature* rootSignature)
+    {
+        if (Skip(rootSignature == m_rootSignature)) return;
+
+        // A new root signature resets every root argument
+        m_rootSignature = rootSignature;
+        m_rootViewMask = 0;
+        m_list->SetGraphicsRootSignature(rootSignature);
+    }
+
+    void SetPipelineState(PipelineState* pipelineState)
+    {
+        if (Skip(pipelineState == m_pipelineState)) return;
+
+        m_pipelineState = pipelineState;
+        m_list->SetPipelineState(pipelineState);
+    }
+
+    void IASetPrimitiveTopology(Topology topology)
+    {
+        if (Skip(m_hasTopology && topology == m_topology)) return;
+
+        m_topology = topology;
+        m_hasTopology = true;
+        m_list->IASetPrimitiveTopology(topology);
+    }
+
+    void IASetVertexBuffers(uint32_t startSlot, uint32_t count, const VertexBufferView* views)
+    {
+        bool same = startSlot + count <= MaxVertexBuffers;
+        for (uint32_t i = 0; same && i < count; i++) {
+            same = (m_vertexBufferMask >> (startSlot + i) & 1) && Equal(views[i], m_vertexBuffers[startSlot + i]);
+        }
+        if (Skip(same)) return;
+
+        for (uint32_t i = 0; i < count && startSlot + i < MaxVertexBuffers; i++) {
+            m_vertexBuffers[startSlot + i] = views[i];
+            m_vertexBufferMask |= 1u << (startSlot + i);
+        }
+        m_list->IASetVertexBuffers(startSlot, count, views);
+    }
+
+    void IASetIndexBuffer(const IndexBufferView* view)
+    {
+        if (Skip(view && m_hasIndexBuffer && Equal(*view, m_indexBuffer))) return;
+
+        m_hasIndexBuffer = view != nullptr;
+        if (view) m_indexBuffer = *view;
+        m_list->IASetIndexBuffer(view);
+    }
+
+    void SetGraphicsRootConstantBufferView(uint32_t parameter, GpuAddress address)
+    {
+        bool cached = parameter < MaxRootParameters;
+        if (Skip(cached && (m_rootViewMask >> parameter & 1) && m_rootViews[parameter] == address)) return;
+
+        if (cached) {
+            m_rootViews[parameter] = address;
+            m_rootViewMask |= 1u << parameter;
+        }
+        m_list->SetGraphicsRootConstantBufferView(parameter, address);
+    }
+
+    // Shares the cache with the CBVs: a root parameter is one kind of view or the other
+    void SetGraphicsRootShaderResourceView(uint32_t parameter, GpuAddress address)
+    {
+        bool cached = parameter < MaxRootParameters;
+        if (Skip(cached && (m_rootViewMask >> parameter & 1) && m_rootViews[parameter] == address)) return;
+
+        if (cached) {
+            m_rootViews[parameter] = address;
+            m_rootViewMask |= 1u << parameter;
+        }
+        m_list->SetGraphicsRootShaderResourceView(parameter, address);
+    }
+
+    // MARK: - Draws
+
+    void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+    {
+        m_counters.draws++;
+        m_list->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+    }
+
+    void DrawIndexedInstanced(
+        uint32_t indexCount,
+        uint32_t instanceCount,
+        uint32_t startIndex,
+        int32_t baseVertex,
+        uint32_t startInstance
+    )
+    {
+        m_counters.draws++;
+        m_list->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+    }
+
+private:
+    bool Skip(bool redundant) noexcept
+    {
+        if (redundant) {
+            m_counters.skipped++;
+        }
+        else {
+            m_counters.issued++;
+        }
+        return redundant;
+    }
+
+    // Views are plain structs without padding
+    template <typename T>
+    static bool Equal(const T& a, const T& b) noexcept
+    {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    CommandList* m_list = nullptr;
+    RecorderCounters m_counters;
+
+    RootSignature* m_rootSignature = nullptr;
+    PipelineState* m_pipelineState = nullptr;
+    Topology m_topology{};
+    bool m_hasTopology = false;
+
+    DescriptorHeap* m_heaps[MaxDescriptorHeaps] = {};
+    uint32_t m_heapCount = UINT32_MAX; // unknown
+
+    VertexBufferView m_vertexBuffers[MaxVertexBuffers] = {};
+    uint32_t m_vertexBufferMask = 0;
+    IndexBufferView m_indexBuffer{};
+    bool m_hasIndexBuffer = false;
+
+    GpuAddress m_rootViews[MaxRootParameters] = {};
+    uint32_t m_rootViewMask = 0;
+};
+
+} // namespace canvas
@@ -0,0 +1,290 @@
+#include "Culling.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_CULL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX intrinsics in any function; GCC and Clang need them enabled per function
+#if defined(__GNUC__) || defined(__clang__)
+#define YANG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define YANG_TARGET_AVX2
+#endif
+
+using namespace canvas;
+
+namespace
+{
+
+Plane Normalize(float a, float b, float c, float d) noexcept
+{
+    float length = std::sqrt(a * a + b * b + c * c);
+    float inverse = length > 0.0f ? 1.0f / length : 0.0f;
+    return {a * inverse, b * inverse, c * inverse, d * inverse};
+}
+
+// Appends `base + lane` for every set bit of `mask`. Writes unconditionally and only
+// advances on visible lanes, so there is no branch per object.
+inline size_t Emit(uint32_t* visible, size_t n, uint32_t base, unsigned mask, unsigned lanes) noexcept
+{
+    for (unsigned lane = 0; lane < lanes; lane++) {
+        visible[n] = base + lane;
+        n += (mask >> lane) & 1;
+    }
+    return n;
+}
+
+// MARK: - Scalar
+
+inline bool SphereVisible(const Frustum& frustum, const SphereBoundsSoA& b, size_t i) noexcept
+{
+    for (const Plane& p : frustum.planes) {
+        if (p.a * b.x[i] + p.b * b.y[i] + p.c * b.z[i] + p.d + b.radius[i] < 0.0f) return false;
+    }
+    return true;
+}
+
+inline bool AabbVisible(const Frustum& frustum, const AabbBoundsSoA& b, size_t i) noexcept
+{
+    for (const Plane& p : frustum.planes) {
+        float distance = p.a * b.centerX[i] + p.b * b.centerY[i] + p.c * b.centerZ[i] + p.d;
+        float radius = std::fabs(p.a) * b.extentX[i] + std::fabs(p.b) * b.extentY[i] + std::fabs(p.c) * b.extentZ[i];
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
+
+size_t CullSpheresScalar(const Frustum& frustum, const SphereBoundsSoA& b, size_t first, uint32_t* visible, size_t n) noexcept
+{
+    for (size_t i = first; i < b.count; i++) {
+        visible[n] = static_cast<uint32_t>(i);
+        n += SphereVisible(frustum, b, i);
+    }
+    return n;
+}
+
+size_t CullAabbsScalar(const Frustum& frustum, const AabbBoundsSoA& b, size_t first, uint32_t* visible, size_t n) noexcept
+{
+    for (size_t i = first; i < b.count; i++) {
+        visible[n] = static_cast<uint32_t>(i);
+        n += AabbVisible(frustum, b, i);
+    }
+    return n;
+}
+
+#ifdef YANG_CULL_X86
+
+// MARK: - SSE
+
+size_t CullSpheresSse(const Frustum& frustum, const SphereBoundsSoA& b, uint32_t* visible) noexcept
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= b.count; i += 4) {
+        __m128 x = _mm_loadu_ps(b.x + i);
+        __m128 y = _mm_loadu_ps(b.y + i);
+        __m128 z = _mm_loadu_ps(b.z + i);
+        __m128 radius = _mm_loadu_ps(b.radius + i);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const Plane& p : frustum.planes) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.a)), _mm_mul_ps(y, _mm_set1_ps(p.b))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.c)), _mm_set1_ps(p.d))
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        n = Emit(visible, n, static_cast<uint32_t>(i), static_cast<unsigned>(_mm_movemask_ps(inside)), 4);
+    }
+
+    return CullSpheresScalar(frustum, b, i, visible, n);
+}
+
+size_t CullAabbsSse(const Frustum& frustum, const AabbBoundsSoA& b, uint32_t* visible) noexcept
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    for (; i + 4 <= b.count; i += 4) {
+        __m128 cx = _mm_loadu_ps(b.centerX + i);
+        __m128 cy = _mm_loadu_ps(b.centerY + i);
+        __m128 cz = _mm_loadu_ps(b.centerZ + i);
+        __m128 ex = _mm_loadu_ps(b.extentX + i);
+        __m128 ey = _mm_loadu_ps(b.extentY + i);
+        __m128 ez = _mm_loadu_ps(b.extentZ + i);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const Plane& p : frustum.planes) {
+            __m128 a = _mm_set1_ps(p.a);
+            __m128 bb = _mm_set1_ps(p.b);
+            __m128 c = _mm_set1_ps(p.c);
+
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(cx, a), _mm_mul_ps(cy, bb)),
+                _mm_add_ps(_mm_mul_ps(cz, c), _mm_set1_ps(p.d))
+            );
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(ex, _mm_and_ps(a, absMask)), _mm_mul_ps(ey, _mm_and_ps(bb, absMask))),
+                _mm_mul_ps(ez, _mm_and_ps(c, absMask))
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        n = Emit(visible, n, static_cast<uint32_t>(i), static_cast<unsigned>(_mm_movemask_ps(inside)), 4);
+    }
+
+    return CullAabbsScalar(frustum, b, i, visible, n);
+}
+
+// MARK: - AVX2
+
+YANG_TARGET_AVX2 size_t CullSpheresAvx2(const Frustum& frustum, const SphereBoundsSoA& b, uint32_t* visible) noexcept
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= b.count; i += 8) {
+        __m256 x = _mm256_loadu_ps(b.x + i);
+        __m256 y = _mm256_loadu_ps(b.y + i);
+        __m256 z = _mm256_loadu_ps(b.z + i);
+        __m256 radius = _mm256_loadu_ps(b.radius + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const Plane& p : frustum.planes) {
+            __m256 distance = _mm256_fmadd_ps(x, _mm256_set1_ps(p.a), _mm256_set1_ps(p.d));
+            distance = _mm256_fmadd_ps(y, _mm256_set1_ps(p.b), distance);
+            distance = _mm256_fmadd_ps(z, _mm256_set1_ps(p.c), distance);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        n = Emit(visible, n, static_cast<uint32_t>(i), static_cast<unsigned>(_mm256_movemask_ps(inside)), 8);
+    }
+
+    return CullSpheresScalar(frustum, b, i, visible, n);
+}
+
+YANG_TARGET_AVX2 size_t CullAabbsAvx2(const Frustum& frustum, const AabbBoundsSoA& b, uint32_t* visible) noexcept
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= b.count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(b.centerX + i);
+        __m256 cy = _mm256_loadu_ps(b.centerY + i);
+        __m256 cz = _mm256_loadu_ps(b.centerZ + i);
+        __m256 ex = _mm256_loadu_ps(b.extentX + i);
+        __m256 ey = _mm256_loadu_ps(b.extentY + i);
+        __m256 ez = _mm256_loadu_ps(b.extentZ + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const Plane& p : frustum.planes) {
+            // distance to the center plus the box extent projected onto the normal
+            __m256 sum = _mm256_fmadd_ps(cx, _mm256_set1_ps(p.a), _mm256_set1_ps(p.d));
+            sum = _mm256_fmadd_ps(cy, _mm256_set1_ps(p.b), sum);
+            sum = _mm256_fmadd_ps(cz, _mm256_set1_ps(p.c), sum);
+            sum = _mm256_fmadd_ps(ex, _mm256_set1_ps(std::fabs(p.a)), sum);
+            sum = _mm256_fmadd_ps(ey, _mm256_set1_ps(std::fabs(p.b)), sum);
+            sum = _mm256_fmadd_ps(ez, _mm256_set1_ps(std::fabs(p.c)), sum);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(sum, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        n = Emit(visible, n, static_cast<uint32_t>(i), static_cast<unsigned>(_mm256_movemask_ps(inside)), 8);
+    }
+
+    return CullAabbsScalar(frustum, b, i, visible, n);
+}
+
+bool HasAvx2() noexcept
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma || (_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // YANG_CULL_X86
+
+} // namespace
+
+Frustum canvas::FrustumFromMatrix(const float (&m)[4][4]) noexcept
+{
+    // Gribb & Hartmann: with clip = v * M, -w <= x <= w gives w + x >= 0 and w - x >= 0,
+    // i.e. column 3 plus or minus column j
+    auto combine = [&](int j, float sign) {
+        return Normalize(
+            m[0][3] + sign * m[0][j],
+            m[1][3] + sign * m[1][j],
+            m[2][3] + sign * m[2][j],
+            m[3][3] + sign * m[3][j]
+        );
+    };
+
+    Frustum frustum;
+    frustum.planes[Frustum::LEFT] = combine(0, 1.0f);
+    frustum.planes[Frustum::RIGHT] = combine(0, -1.0f);
+    frustum.planes[Frustum::BOTTOM] = combine(1, 1.0f);
+    frustum.planes[Frustum::TOP] = combine(1, -1.0f);
+    frustum.planes[Frustum::NEAR_Z] = Normalize(m[0][2], m[1][2], m[2][2], m[3][2]); // z >= 0
+    frustum.planes[Frustum::FAR_Z] = combine(2, -1.0f);
+    return frustum;
+}
+
+CullPath canvas::BestCullPath() noexcept
+{
+#ifdef YANG_CULL_X86
+    static const CullPath best = HasAvx2() ? CullPath::AVX2 : CullPath::SSE;
+    return best;
+#else
+    return CullPath::SCALAR;
+#endif
+}
+
+size_t canvas::CullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, uint32_t* visible, CullPath path) noexcept
+{
+    if (path == CullPath::AUTO) path = BestCullPath();
+
+    switch (path) {
+#ifdef YANG_CULL_X86
+    case CullPath::AVX2:
+        return CullSpheresAvx2(frustum, bounds, visible);
+    case CullPath::SSE:
+        return CullSpheresSse(frustum, bounds, visible);
+#endif
+    default:
+        return CullSpheresScalar(frustum, bounds, 0, visible, 0);
+    }
+}
+
+size_t canvas::CullAabbs(const Frustum& frustum, const AabbBoundsSoA& bounds, uint32_t* visible, CullPath path) noexcept
+{
+    if (path == CullPath::AUTO) path = BestCullPath();
+
+    switch (path) {
+#ifdef YANG_CULL_X86
+    case CullPath::AVX2:
+        return CullAabbsAvx2(frustum, bounds, visible);
+    case CullPath::SSE:
+        return CullAabbsSse(frustum, bounds, visible);
+#endif
+    default:
+        return CullAabbsScalar(frustum, bounds, 0, visible, 0);
+    }
+}
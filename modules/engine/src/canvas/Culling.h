@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace canvas
+{
+
+// a*x + b*y + c*z + d >= 0 on the inner side, (a, b, c) has unit length
+struct Plane
+{
+    float a, b, c, d;
+};
+
+struct Frustum
+{
+    enum Side
+    {
+        LEFT,
+        RIGHT,
+        BOTTOM,
+        TOP,
+        NEAR_Z,
+        FAR_Z,
+        COUNT
+    };
+
+    Plane planes[COUNT];
+};
+
+// Extracts normalized planes from a row-major view-projection matrix in the
+// DirectXMath convention (row vectors, clip = v * M, depth in [0, 1]).
+Frustum FrustumFromMatrix(const float (&m)[4][4]) noexcept;
+
+// Bounds stored as separate arrays, so 4 or 8 objects load with one instruction
+struct SphereBoundsSoA
+{
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* radius;
+    size_t count;
+};
+
+// Center / half-extent form
+struct AabbBoundsSoA
+{
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* extentX;
+    const float* extentY;
+    const float* extentZ;
+    size_t count;
+};
+
+enum class CullPath
+{
+    AUTO,   // widest the CPU supports
+    SCALAR,
+    SSE,    // 4 objects per iteration
+    AVX2    // 8 objects per iteration
+};
+
+// Widest path available on this CPU
+CullPath BestCullPath() noexcept;
+
+// Write the indices of the bounds that intersect the frustum to `visible`, in
+// ascending order, and return how many were written. `visible` needs room for
+// `bounds.count` indices.
+size_t CullSpheres(const Frustum&, const SphereBoundsSoA& bounds, uint32_t* visible, CullPath = CullPath::AUTO) noexcept;
+size_t CullAabbs(const Frustum&, const AabbBoundsSoA& bounds, uint32_t* visible, CullPath = CullPath::AUTO) noexcept;
+
+} // namespace canvas
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../pch.h"
+#include "CommandRecorder.h"
+#include "ParallelRecorder.h"
+
+namespace canvas
+{
+
+struct D3D12Api
+{
+    using CommandList = ID3D12GraphicsCommandList;
+    using RootSignature = ID3D12RootSignature;
+    using PipelineState = ID3D12PipelineState;
+    using DescriptorHeap = ID3D12DescriptorHeap;
+    using Topology = D3D_PRIMITIVE_TOPOLOGY;
+    using VertexBufferView = D3D12_VERTEX_BUFFER_VIEW;
+    using IndexBufferView = D3D12_INDEX_BUFFER_VIEW;
+    using GpuAddress = D3D12_GPU_VIRTUAL_ADDRESS;
+};
+
+using D3D12Recorder = CommandRecorder<D3D12Api>;
+using D3D12ParallelRecorder = ParallelRecorder<D3D12Api>;
+
+} // namespace canvas
@@ -15,10 +15,14 @@ enum class PSOType
 struct DrawItem
 {
     PSOType psoType{};
+    uint64_t sortKey = 0; // see SortKey in DrawSort.h
 
     D3D_PRIMITIVE_TOPOLOGY topology{D3D_PRIMITIVE_TOPOLOGY_UNDEFINED};
     UINT countPerInstance = 0;
     UINT instanceCount = 1;
+    UINT startIndex = 0; // or start vertex without an index buffer
+    INT baseVertex = 0;
+    UINT submesh = 0; // index into MeshViews::parts, tells apart what may share an instanced draw
     D3D12_VERTEX_BUFFER_VIEW vbv{};
 
     // Optional fields
@@ -26,6 +30,7 @@ struct DrawItem
     D3D12_GPU_DESCRIPTOR_HANDLE srv{};
     D3D12_GPU_VIRTUAL_ADDRESS vsCB{};
     D3D12_GPU_VIRTUAL_ADDRESS psCB{};
+    D3D12_GPU_VIRTUAL_ADDRESS instances{}; // first InstanceData of the draw, SV_InstanceID indexes from here
 };
 
 } // namespace canvas
\ No newline at end of file
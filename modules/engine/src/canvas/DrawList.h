@@ -0,0 +1,133 @@
+//
+// DrawList.h - Retained draw packets, patched instead of rebuilt each frame
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace canvas
+{
+
+// Packets are registered once and live in one array split into a visible prefix
+// and a hidden tail, so toggling visibility is a swap across the boundary and a
+// frame walks the visible packets contiguously. Order within either part is not
+// kept. Each packet carries an owner tag for the caller to map it back.
+template <typename Packet>
+class DrawList final
+{
+public:
+    using Handle = uint32_t;
+
+    // Disallow copy / assign
+    DrawList(const DrawList&) = delete;
+    DrawList& operator=(const DrawList&) = delete;
+
+    DrawList() = default;
+
+    Handle Add(const Packet& packet, uint32_t owner, bool visible)
+    {
+        Handle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        }
+        else {
+            handle = static_cast<Handle>(m_position.size());
+            m_position.push_back(0);
+        }
+
+        m_position[handle] = static_cast<uint32_t>(m_packets.size());
+        m_packets.push_back(packet);
+        m_owners.push_back(owner);
+        m_handles.push_back(handle);
+
+        if (visible) SetVisible(handle, true);
+        return handle;
+    }
+
+    void Remove(Handle handle) noexcept
+    {
+        SetVisible(handle, false);
+        Swap(m_position[handle], static_cast<uint32_t>(m_packets.size() - 1));
+
+        m_packets.pop_back();
+        m_owners.pop_back();
+        m_handles.pop_back();
+        m_freeHandles.push_back(handle);
+    }
+
+    // Patches a packet in place, e.g. after a mesh or material change
+    void Update(Handle handle, const Packet& packet) noexcept { m_packets[m_position[handle]] = packet; }
+
+    void SetVisible(Handle handle, bool visible) noexcept
+    {
+        uint32_t position = m_position[handle];
+        if (visible == (position < m_visibleCount)) return;
+
+        if (visible) {
+            Swap(position, static_cast<uint32_t>(m_visibleCount++));
+        }
+        else {
+            Swap(position, static_cast<uint32_t>(--m_visibleCount));
+        }
+    }
+
+    bool IsVisible(Handle handle) const noexcept { return m_position[handle] < m_visibleCount; }
+
+    void Clear() noexcept
+    {
+        m_packets.clear();
+        m_owners.clear();
+        m_handles.clear();
+        m_position.clear();
+        m_freeHandles.clear();
+        m_visibleCount = 0;
+    }
+
+    void Reserve(size_t count)
+    {
+        m_packets.reserve(count);
+        m_owners.reserve(count);
+        m_handles.reserve(count);
+        m_position.reserve(count);
+    }
+
+    size_t Size() const noexcept { return m_packets.size(); }
+
+    // Visible packets and their owners, index for index
+    std::span<Packet> Visible() noexcept { return {m_packets.data(), m_visibleCount}; }
+    std::span<const Packet> Visible() const noexcept { return {m_packets.data(), m_visibleCount}; }
+    std::span<const uint32_t> VisibleOwners() const noexcept { return {m_owners.data(), m_visibleCount}; }
+
+private:
+    void Swap(uint32_t a, uint32_t b) noexcept
+    {
+        assert(a < m_packets.size() && b < m_packets.size());
+        if (a == b) return;
+
+        std::swap(m_packets[a], m_packets[b]);
+        std::swap(m_owners[a], m_owners[b]);
+        std::swap(m_handles[a], m_handles[b]);
+        m_position[m_handles[a]] = a;
+        m_position[m_handles[b]] = b;
+    }
+
+    // Per position: [0, m_visibleCount) visible, the rest hidden
+    std::vector<Packet> m_packets;
+    std::vector<uint32_t> m_owners;
+    std::vector<Handle> m_handles;
+
+    // Per handle
+    std::vector<uint32_t> m_position;
+    std::vector<Handle> m_freeHandles;
+
+    size_t m_visibleCount = 0;
+};
+
+} // namespace canvas
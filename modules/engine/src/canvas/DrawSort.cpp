@@ -0,0 +1,81 @@
+#include "DrawSort.h"
+
+#include <cstring>
+#include <utility>
+
+using namespace canvas;
+
+namespace
+{
+constexpr uint64_t Mask(uint32_t bits) noexcept
+{
+    return (uint64_t(1) << bits) - 1;
+}
+
+constexpr uint32_t Passes = sizeof(uint64_t);
+constexpr uint32_t Buckets = 256;
+} // namespace
+
+uint32_t SortKey::QuantizeDepth(float viewDepth) noexcept
+{
+    // Also maps NaN and everything behind the eye to 0
+    if (!(viewDepth > 0.0f)) return 0;
+
+    uint32_t bits;
+    std::memcpy(&bits, &viewDepth, sizeof(bits));
+    return bits >> (31 - DepthBits);
+}
+
+uint64_t SortKey::Make(DrawPass pass, uint32_t layer, uint32_t pipeline, uint32_t mesh, float viewDepth) noexcept
+{
+    uint64_t key = (uint64_t(pass) & Mask(4)) << 60 | (uint64_t(layer) & Mask(LayerBits)) << 56;
+
+    uint64_t depth = QuantizeDepth(viewDepth);
+    pipeline &= Mask(PipelineBits);
+    mesh &= Mask(MeshBits);
+
+    if (pass == DrawPass::TRANSLUCENT) {
+        return key | (~depth & Mask(DepthBits)) << 32 | uint64_t(pipeline) << 24 | mesh;
+    }
+    return key | uint64_t(pipeline) << 48 | uint64_t(mesh) << 24 | depth;
+}
+
+void canvas::RadixSort(SortItem* items, SortItem* scratch, size_t count) noexcept
+{
+    if (count < 2) return;
+
+    // Every digit's histogram in one read of the keys
+    uint32_t histograms[Passes][Buckets] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = items[i].key;
+        for (uint32_t pass = 0; pass < Passes; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    SortItem* from = items;
+    SortItem* to = scratch;
+
+    for (uint32_t pass = 0; pass < Passes; pass++) {
+        uint32_t* histogram = histograms[pass];
+        uint32_t shift = pass * 8;
+
+        // All keys share this byte, the pass would be a copy
+        if (histogram[(from[0].key >> shift) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < Buckets; bucket++) {
+            uint32_t n = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+        }
+
+        std::swap(from, to);
+    }
+
+    if (from != items) std::memcpy(items, from, count * sizeof(SortItem));
+}
@@ -0,0 +1,54 @@
+//
+// DrawSort.h - 64-bit draw sort keys and an LSD radix sort over them
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace canvas
+{
+
+// Drawn in this order; the lowest key bits decide order within a pass
+enum class DrawPass : uint8_t
+{
+    SOLID,       // opaque, front to back to feed early z
+    TRANSLUCENT, // back to front for correct blending
+    OVERLAY      // UI on top of everything
+};
+
+// Key layout, most significant first:
+//
+//   SOLID        pass:4 | layer:4 | pipeline:8 | mesh:24 | depth:24
+//   TRANSLUCENT  pass:4 | layer:4 | ~depth:24  | pipeline:8 | mesh:24
+//
+// so opaque draws group by pipeline then mesh and only use depth as the tie
+// break, while translucent draws put correctness first. Depth is the top 24 bits
+// of the non-negative float, monotonic without knowing the far plane.
+struct SortKey
+{
+    static constexpr uint32_t LayerBits = 4;
+    static constexpr uint32_t PipelineBits = 8;
+    static constexpr uint32_t MeshBits = 24;
+    static constexpr uint32_t DepthBits = 24;
+
+    static uint64_t Make(DrawPass, uint32_t layer, uint32_t pipeline, uint32_t mesh, float viewDepth) noexcept;
+
+    static DrawPass Pass(uint64_t key) noexcept { return static_cast<DrawPass>(key >> 60); }
+    static uint32_t QuantizeDepth(float viewDepth) noexcept;
+};
+
+struct SortItem
+{
+    uint64_t key;
+    uint32_t index; // caller's draw index
+    uint32_t padding;
+};
+
+// Stable ascending sort by key. `scratch` needs room for `count` items; the result
+// is in `items`. Byte positions where every key is equal are skipped, so keys that
+// only differ in a few fields sort in a few passes.
+void RadixSort(SortItem* items, SortItem* scratch, size_t count) noexcept;
+
+} // namespace canvas
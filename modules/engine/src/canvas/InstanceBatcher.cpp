@@ -0,0 +1,72 @@
+#include "InstanceBatcher.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_INSTANCE_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace canvas;
+
+void InstanceBatcher::Build(const uint64_t* keys, size_t count, uint32_t groupShift)
+{
+    m_items.resize(count);
+    m_scratch.resize(count);
+    m_order.resize(count);
+    m_batches.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        m_items[i] = {keys[i], static_cast<uint32_t>(i), 0};
+    }
+    RadixSort(m_items.data(), m_scratch.data(), count);
+
+    uint64_t groupMask = groupShift < 64 ? ~uint64_t(0) << groupShift : 0;
+
+    for (size_t i = 0; i < count; i++) {
+        m_order[i] = m_items[i].index;
+
+        bool sameGroup = !m_batches.empty() && ((m_items[i].key ^ m_items[i - 1].key) & groupMask) == 0;
+        if (sameGroup && m_batches.back().instanceCount < m_maxInstances) {
+            m_batches.back().instanceCount++;
+        }
+        else {
+            m_batches.push_back({m_items[i].index, static_cast<uint32_t>(i), 1});
+        }
+    }
+}
+
+void canvas::PackInstances(const uint32_t* entities, size_t count, const Matrix4* world, const InstanceStyle* styles, InstanceData* out) noexcept
+{
+    static_assert(sizeof(InstanceStyle) == 32);
+
+    for (size_t k = 0; k < count; k++) {
+        const Matrix4& m = world[entities[k]];
+        InstanceData& instance = out[k];
+
+#if YANG_INSTANCE_X86
+        // Rows in, columns out; the fourth column of an affine matrix is dropped
+        __m128 r0 = _mm_loadu_ps(m.m[0]);
+        __m128 r1 = _mm_loadu_ps(m.m[1]);
+        __m128 r2 = _mm_loadu_ps(m.m[2]);
+        __m128 r3 = _mm_loadu_ps(m.m[3]);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        _mm_storeu_ps(instance.world[0], r0);
+        _mm_storeu_ps(instance.world[1], r1);
+        _mm_storeu_ps(instance.world[2], r2);
+
+        const float* style = reinterpret_cast<const float*>(&styles[entities[k]]);
+        float* target = reinterpret_cast<float*>(&instance.style);
+        _mm_storeu_ps(target, _mm_loadu_ps(style));
+        _mm_storeu_ps(target + 4, _mm_loadu_ps(style + 4));
+#else
+        for (int c = 0; c < 3; c++) {
+            for (int r = 0; r < 4; r++) {
+                instance.world[c][r] = m.m[r][c];
+            }
+        }
+        std::memcpy(&instance.style, &styles[entities[k]], sizeof(InstanceStyle));
+#endif
+    }
+}
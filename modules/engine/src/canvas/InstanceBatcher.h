@@ -0,0 +1,83 @@
+//
+// InstanceBatcher.h - Groups draws of the same geometry and state into instanced batches
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DrawSort.h"
+#include "TransformHierarchy.h"
+
+namespace canvas
+{
+
+// Per-entity look: vertex color * colorScale + colorBias
+struct InstanceStyle
+{
+    float colorScale[3] = {1.0f, 1.0f, 1.0f};
+    float distortion = 0.0f; // per-vertex wobble, see Distort in Triangle_VS
+    float colorBias[3] = {0.0f, 0.0f, 0.0f};
+    float padding = 0.0f;
+};
+
+// One element of the per-frame instance buffer, StructuredBuffer<InstanceData> in
+// Triangle_VS. `world` holds the first three columns of the row-vector world
+// matrix, so world position = (dot(world[0], p), dot(world[1], p), dot(world[2], p)).
+struct InstanceData
+{
+    float world[3][4];
+    InstanceStyle style;
+};
+static_assert(sizeof(InstanceData) == 80, "mirrors InstanceData in Triangle_VS");
+
+// A run of instances drawn with one call
+struct InstanceBatch
+{
+    uint32_t item;          // caller's index of the first instance, its draw stands for the batch
+    uint32_t firstInstance; // position in Order() and in the packed instance buffer
+    uint32_t instanceCount;
+};
+
+// Sorts draws by a 64-bit key and cuts the sorted run into batches: neighbours
+// whose keys agree above `groupShift` share a draw, the bits below only order the
+// instances within it, e.g. by depth. Runs longer than the instance limit are
+// split into several draws.
+class InstanceBatcher final
+{
+public:
+    static constexpr uint32_t DefaultMaxInstances = 16384;
+
+    // Disallow copy / assign
+    InstanceBatcher(const InstanceBatcher&) = delete;
+    InstanceBatcher& operator=(const InstanceBatcher&) = delete;
+
+    InstanceBatcher() = default;
+
+    void SetMaxInstances(uint32_t maxInstances) noexcept { m_maxInstances = maxInstances ? maxInstances : 1; }
+    uint32_t MaxInstances() const noexcept { return m_maxInstances; }
+
+    // Batches `count` draws by their `keys`
+    void Build(const uint64_t* keys, size_t count, uint32_t groupShift);
+
+    // Caller's draw indices in instance order, batch after batch
+    std::span<const uint32_t> Order() const noexcept { return m_order; }
+    std::span<const InstanceBatch> Batches() const noexcept { return m_batches; }
+
+private:
+    uint32_t m_maxInstances = DefaultMaxInstances;
+
+    std::vector<SortItem> m_items;
+    std::vector<SortItem> m_scratch;
+    std::vector<uint32_t> m_order;
+    std::vector<InstanceBatch> m_batches;
+};
+
+// Writes instance k from world[entities[k]] and styles[entities[k]]. `out` may be
+// write-combined upload memory: it is only written, front to back.
+void PackInstances(const uint32_t* entities, size_t count, const Matrix4* world, const InstanceStyle* styles, InstanceData* out) noexcept;
+
+} // namespace canvas
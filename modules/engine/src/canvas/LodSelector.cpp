@@ -0,0 +1,146 @@
+#include "LodSelector.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+#include "CanvasUtil.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_LOD_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace canvas;
+
+namespace
+{
+// Keeps the camera inside a bounding sphere from dividing by zero; the finest
+// level is picked there anyway
+constexpr float MinDistance = 1e-4f;
+
+// Levels whose projected error is at most `limit`, bit = level. Level 0 always
+// qualifies, so there is no fallback to handle.
+uint32_t LevelsUnder(const LodChain& chain, float pixelScale, float limit) noexcept
+{
+    uint32_t valid = (1u << chain.count) - 1;
+
+#if YANG_LOD_X86
+    __m128 projected = _mm_mul_ps(_mm_loadu_ps(chain.error), _mm_set1_ps(pixelScale));
+    uint32_t under = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(projected, _mm_set1_ps(limit))));
+#else
+    uint32_t under = 0;
+    for (uint32_t level = 0; level < LodChain::MaxLods; level++) {
+        under |= uint32_t(chain.error[level] * pixelScale <= limit) << level;
+    }
+#endif
+
+    return (under & valid) | 1u;
+}
+
+uint32_t Coarsest(uint32_t levels) noexcept
+{
+    return static_cast<uint32_t>(std::bit_width(levels)) - 1;
+}
+} // namespace
+
+size_t LodSelector::Select(const LodView& view, const LodInputs& inputs, const uint32_t* indices, size_t count, uint8_t* lods)
+{
+    static_assert(LodChain::MaxLods == 4, "one SSE register per chain");
+
+    auto start = std::chrono::steady_clock::now();
+
+    m_stats = {};
+    m_switched.clear();
+    m_candidates.clear();
+
+    auto chainOf = [&](uint32_t i) -> const LodChain* {
+        uint32_t mesh = inputs.meshes[i];
+        return mesh < inputs.chains.size() ? inputs.chains[mesh] : nullptr;
+    };
+
+    // Single-level meshes only count towards the totals
+    for (size_t k = 0; k < count; k++) {
+        uint32_t i = indices[k];
+        const LodChain* chain = chainOf(i);
+        if (!chain) continue;
+
+        if (chain->count > 1 && std::isfinite(inputs.bounds.radius[i])) {
+            m_candidates.push_back(i);
+            continue;
+        }
+
+        m_stats.trianglesDrawn += chain->triangles[0];
+        m_stats.trianglesFull += chain->triangles[0];
+    }
+
+    // Pixels per unit of model-space error: world scale over the distance to the
+    // nearest point of the bounding sphere
+    size_t candidates = m_candidates.size();
+    m_pixelScale.resize(candidates);
+
+    const SphereBoundsSoA& bounds = inputs.bounds;
+    const uint32_t* ids = m_candidates.data();
+    size_t k = 0;
+
+#if YANG_LOD_X86
+    const __m128 eyeX = _mm_set1_ps(view.eye[0]);
+    const __m128 eyeY = _mm_set1_ps(view.eye[1]);
+    const __m128 eyeZ = _mm_set1_ps(view.eye[2]);
+    const __m128 pixels = _mm_set1_ps(view.pixelsPerUnit);
+    const __m128 minDistance = _mm_set1_ps(MinDistance);
+
+    for (; k + 4 <= candidates; k += 4) {
+        uint32_t a = ids[k], b = ids[k + 1], c = ids[k + 2], d = ids[k + 3];
+
+        __m128 dx = _mm_sub_ps(_mm_setr_ps(bounds.x[a], bounds.x[b], bounds.x[c], bounds.x[d]), eyeX);
+        __m128 dy = _mm_sub_ps(_mm_setr_ps(bounds.y[a], bounds.y[b], bounds.y[c], bounds.y[d]), eyeY);
+        __m128 dz = _mm_sub_ps(_mm_setr_ps(bounds.z[a], bounds.z[b], bounds.z[c], bounds.z[d]), eyeZ);
+        __m128 radius = _mm_setr_ps(bounds.radius[a], bounds.radius[b], bounds.radius[c], bounds.radius[d]);
+        __m128 local = _mm_setr_ps(inputs.localRadius[a], inputs.localRadius[b], inputs.localRadius[c], inputs.localRadius[d]);
+
+        __m128 centerDistance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 distance = _mm_max_ps(_mm_sub_ps(centerDistance, radius), minDistance);
+
+        __m128 scale = _mm_div_ps(_mm_mul_ps(pixels, radius), _mm_mul_ps(local, distance));
+        _mm_storeu_ps(&m_pixelScale[k], scale);
+    }
+#endif
+
+    for (; k < candidates; k++) {
+        uint32_t i = ids[k];
+        float dx = bounds.x[i] - view.eye[0];
+        float dy = bounds.y[i] - view.eye[1];
+        float dz = bounds.z[i] - view.eye[2];
+
+        float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - bounds.radius[i], MinDistance);
+        m_pixelScale[k] = view.pixelsPerUnit * bounds.radius[i] / (inputs.localRadius[i] * distance);
+    }
+
+    // Finer as soon as the current level shows, coarser only with margin to spare
+    float threshold = m_settings.pixelThreshold;
+    float relaxed = threshold * (1.0f - m_settings.hysteresis);
+
+    for (k = 0; k < candidates; k++) {
+        uint32_t i = ids[k];
+        const LodChain& chain = *chainOf(i);
+        uint32_t current = std::min<uint32_t>(lods[i], chain.count - 1);
+
+        uint32_t fits = LevelsUnder(chain, m_pixelScale[k], threshold);
+        uint32_t level = fits >> current & 1 ? std::max(current, Coarsest(LevelsUnder(chain, m_pixelScale[k], relaxed))) : Coarsest(fits);
+
+        if (level != lods[i]) {
+            lods[i] = static_cast<uint8_t>(level);
+            m_switched.push_back(i);
+        }
+
+        m_stats.trianglesDrawn += chain.triangles[level];
+        m_stats.trianglesFull += chain.triangles[0];
+    }
+
+    m_stats.selected = static_cast<uint32_t>(candidates);
+    m_stats.switched = static_cast<uint32_t>(m_switched.size());
+    m_stats.selectMs = static_cast<float>(MsSince(start));
+    return m_switched.size();
+}
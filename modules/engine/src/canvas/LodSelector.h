@@ -0,0 +1,97 @@
+//
+// LodSelector.h - Screen-space level of detail selection over per-mesh LOD chains
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Culling.h"
+
+namespace canvas
+{
+
+// Levels of detail of one mesh, finest first. `error` is each level's model-space
+// geometric error against the full mesh and must not shrink along the chain.
+struct LodChain
+{
+    static constexpr uint32_t MaxLods = 4;
+
+    float error[MaxLods] = {};
+    uint32_t triangles[MaxLods] = {}; // per instance
+    uint32_t count = 1;
+};
+
+// Where the error is seen from
+struct LodView
+{
+    float eye[3] = {0.0f, 0.0f, 0.0f};
+    // Pixels one world unit spans at distance 1: viewport height * projection[1][1] / 2
+    float pixelsPerUnit = 1.0f;
+};
+
+struct LodSettings
+{
+    float pixelThreshold = 1.0f;
+    // A coarser level has to fit under pixelThreshold * (1 - hysteresis) before it
+    // replaces the current one, so a camera hovering at the boundary does not pop
+    float hysteresis = 0.25f;
+};
+
+// Per-frame entity data, indexed by dense entity index
+struct LodInputs
+{
+    SphereBoundsSoA bounds;         // world space
+    const float* localRadius;       // model-space radius, bounds radius / local radius is the world scale
+    const uint32_t* meshes;         // MeshHandle
+    // Indexed by MeshHandle, nullptr for meshes without a chain
+    std::span<const LodChain* const> chains;
+};
+
+struct LodStats
+{
+    uint32_t selected = 0; // entities with more than one level
+    uint32_t switched = 0;
+    uint64_t trianglesDrawn = 0;
+    uint64_t trianglesFull = 0; // had every entity drawn its finest level
+    float selectMs = 0.0f;
+
+    uint64_t TrianglesSaved() const noexcept { return trianglesFull - trianglesDrawn; }
+};
+
+// Picks the coarsest level whose error projects under the pixel threshold. The
+// distance part is batched 4 entities per step with SSE, then one compare over the
+// whole chain picks the level.
+class LodSelector final
+{
+public:
+    // Disallow copy / assign
+    LodSelector(const LodSelector&) = delete;
+    LodSelector& operator=(const LodSelector&) = delete;
+
+    LodSelector() = default;
+
+    void SetSettings(const LodSettings& settings) noexcept { m_settings = settings; }
+    const LodSettings& Settings() const noexcept { return m_settings; }
+
+    // Updates `lods[i]` for each of the `count` dense indices in `indices`, starting
+    // from the level each one is at, and returns how many changed
+    size_t Select(const LodView&, const LodInputs&, const uint32_t* indices, size_t count, uint8_t* lods);
+    // Dense indices whose level the last Select changed
+    std::span<const uint32_t> Switched() const noexcept { return m_switched; }
+    const LodStats& Stats() const noexcept { return m_stats; }
+
+private:
+    LodSettings m_settings;
+
+    // Scratch: entities with a multi-level chain and their pixels per unit of error
+    std::vector<uint32_t> m_candidates;
+    std::vector<float> m_pixelScale;
+    std::vector<uint32_t> m_switched;
+    LodStats m_stats;
+};
+
+} // namespace canvas
@@ -0,0 +1,378 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "../common/JobSystem.h"
+#include "CanvasUtil.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_OCCLUSION_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace canvas;
+
+namespace
+{
+constexpr uint32_t FullMask = UINT32_MAX;
+static_assert(OcclusionCuller::TileWidth * OcclusionCuller::TileHeight == 32, "one mask bit per tile pixel");
+
+// Smallest pieces handed to the job system
+constexpr size_t MinBandRows = 2;
+constexpr size_t MinCullRange = 1024;
+
+void Transform(const Matrix4& m, float x, float y, float z, float* clip) noexcept
+{
+    for (int c = 0; c < 4; c++) {
+        clip[c] = x * m.m[0][c] + y * m.m[1][c] + z * m.m[2][c] + m.m[3][c];
+    }
+}
+
+// Clip space to pixels, y down; pixel centers sit at +0.5
+void ToScreen(const float* clip, float& x, float& y, float& z) noexcept
+{
+    float inverseW = 1.0f / clip[3];
+    x = (clip[0] * inverseW * 0.5f + 0.5f) * OcclusionCuller::Width;
+    y = (0.5f - clip[1] * inverseW * 0.5f) * OcclusionCuller::Height;
+    z = clip[2] * inverseW;
+}
+
+// First and last pixel whose center lies in [low, high], clamped to [0, size)
+bool PixelSpan(float low, float high, uint32_t size, uint32_t& first, uint32_t& last) noexcept
+{
+    float a = std::max(std::ceil(low - 0.5f), 0.0f);
+    float b = std::min(std::floor(high - 0.5f), float(size - 1));
+    if (!(a <= b)) return false;
+
+    first = static_cast<uint32_t>(a);
+    last = static_cast<uint32_t>(b);
+    return true;
+}
+} // namespace
+
+void OcclusionCuller::Begin(const Matrix4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    m_stats = {};
+
+    m_mask.assign(TilesX * TilesY, 0);
+    m_zMax0.assign(TilesX * TilesY, 1.0f);
+    m_zMax1.assign(TilesX * TilesY, 0.0f);
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const Matrix4& world)
+{
+    Matrix4 m = Multiply(world, m_viewProjection);
+
+    size_t vertexCount = mesh.positions.size() / 3;
+    m_clip.resize(vertexCount * 4);
+    for (size_t v = 0; v < vertexCount; v++) {
+        const float* p = &mesh.positions[v * 3];
+        Transform(m, p[0], p[1], p[2], &m_clip[v * 4]);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const float* clip[3] = {
+            &m_clip[mesh.indices[i] * 4],
+            &m_clip[mesh.indices[i + 1] * 4],
+            &m_clip[mesh.indices[i + 2] * 4],
+        };
+
+        // Dropping a triangle only loses occlusion, so anything crossing the near
+        // plane is skipped instead of clipped
+        if (clip[0][2] < 0.0f || clip[1][2] < 0.0f || clip[2][2] < 0.0f) continue;
+
+        float x[3], y[3], z[3];
+        for (int k = 0; k < 3; k++)
+            ToScreen(clip[k], x[k], y[k], z[k]);
+
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (!(std::fabs(area) > 1e-6f)) continue;
+
+        uint32_t px0, px1, py0, py1;
+        if (!PixelSpan(std::min({x[0], x[1], x[2]}), std::max({x[0], x[1], x[2]}), Width, px0, px1)) continue;
+        if (!PixelSpan(std::min({y[0], y[1], y[2]}), std::max({y[0], y[1], y[2]}), Height, py0, py1)) continue;
+
+        float zMax = std::max({z[0], z[1], z[2]});
+        if (zMax >= 1.0f) continue;
+
+        Triangle t;
+
+        // Either winding; the sign makes the inside positive
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        for (int e = 0; e < 3; e++) {
+            int a = e, b = (e + 1) % 3;
+            t.edgeA[e] = sign * (y[a] - y[b]);
+            t.edgeB[e] = sign * (x[b] - x[a]);
+            t.edgeC[e] = sign * (x[a] * y[b] - x[b] * y[a]);
+        }
+
+        t.dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+        t.dzdy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+        t.z0 = z[0] - t.dzdx * x[0] - t.dzdy * y[0];
+        t.zMax = zMax;
+
+        t.tileMinX = static_cast<uint16_t>(px0 / TileWidth);
+        t.tileMaxX = static_cast<uint16_t>(px1 / TileWidth);
+        t.tileMinY = static_cast<uint16_t>(py0 / TileHeight);
+        t.tileMaxY = static_cast<uint16_t>(py1 / TileHeight);
+
+        m_triangles.push_back(t);
+    }
+
+    m_stats.occluders++;
+}
+
+void OcclusionCuller::Rasterize(unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now();
+    // Bands of whole tile rows never share a tile, every band walks all triangles
+    if (m_triangles.size() < ParallelTriangles || threads == 1) {
+        RasterizeBand(0, TilesY);
+    }
+    else {
+        jobs::Shared().ParallelFor(TilesY, MinBandRows, [this](size_t first, size_t last) {
+            RasterizeBand(static_cast<uint32_t>(first), static_cast<uint32_t>(last));
+        }, threads);
+    }
+
+    m_stats.triangles = static_cast<uint32_t>(m_triangles.size());
+    m_stats.rasterizeMs = static_cast<float>(MsSince(start));
+}
+
+bool OcclusionCuller::IsVisible(const float (&min)[3], const float (&max)[3]) const noexcept
+{
+    float minX, minY, maxX, maxY, nearest;
+
+#ifdef YANG_OCCLUSION_X86
+    // Corner k = min corner + the box edges selected by its bits, all in clip space
+    const Matrix4& m = m_viewProjection;
+    __m128 row0 = _mm_loadu_ps(m.m[0]), row1 = _mm_loadu_ps(m.m[1]), row2 = _mm_loadu_ps(m.m[2]);
+    __m128 base = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(min[0]), row0), _mm_mul_ps(_mm_set1_ps(min[1]), row1)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(min[2]), row2), _mm_loadu_ps(m.m[3]))
+    );
+    __m128 edgeX = _mm_mul_ps(_mm_set1_ps(max[0] - min[0]), row0);
+    __m128 edgeY = _mm_mul_ps(_mm_set1_ps(max[1] - min[1]), row1);
+    __m128 edgeZ = _mm_mul_ps(_mm_set1_ps(max[2] - min[2]), row2);
+
+    __m128 c[8];
+    c[0] = base;
+    c[1] = _mm_add_ps(base, edgeX);
+    c[2] = _mm_add_ps(base, edgeY);
+    c[3] = _mm_add_ps(c[1], edgeY);
+    for (int k = 0; k < 4; k++)
+        c[k + 4] = _mm_add_ps(c[k], edgeZ);
+
+    // Two groups of 4 corners as x, y, z, w lanes
+    _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+    _MM_TRANSPOSE4_PS(c[4], c[5], c[6], c[7]);
+
+    // Reaches in front of the near plane
+    __m128 zero = _mm_setzero_ps();
+    if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(c[2], zero), _mm_cmplt_ps(c[6], zero)))) return true;
+
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 width = _mm_set1_ps(float(Width)), height = _mm_set1_ps(float(Height));
+
+    __m128 screen[2][3];
+    for (int g = 0; g < 2; g++) {
+        __m128 inverseW = _mm_div_ps(_mm_set1_ps(1.0f), c[g * 4 + 3]);
+        screen[g][0] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(c[g * 4], inverseW), half), half), width);
+        screen[g][1] = _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(c[g * 4 + 1], inverseW), half)), height);
+        screen[g][2] = _mm_mul_ps(c[g * 4 + 2], inverseW);
+    }
+
+    auto horizontal = [](__m128 v, auto op) {
+        v = op(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        v = op(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(v);
+    };
+    auto vmin = [](__m128 a, __m128 b) { return _mm_min_ps(a, b); };
+    auto vmax = [](__m128 a, __m128 b) { return _mm_max_ps(a, b); };
+
+    minX = horizontal(_mm_min_ps(screen[0][0], screen[1][0]), vmin);
+    maxX = horizontal(_mm_max_ps(screen[0][0], screen[1][0]), vmax);
+    minY = horizontal(_mm_min_ps(screen[0][1], screen[1][1]), vmin);
+    maxY = horizontal(_mm_max_ps(screen[0][1], screen[1][1]), vmax);
+    nearest = horizontal(_mm_min_ps(screen[0][2], screen[1][2]), vmin);
+#else
+    minX = minY = nearest = INFINITY;
+    maxX = maxY = -INFINITY;
+
+    for (int corner = 0; corner < 8; corner++) {
+        float clip[4];
+        Transform(m_viewProjection, corner & 1 ? max[0] : min[0], corner & 2 ? max[1] : min[1], corner & 4 ? max[2] : min[2], clip);
+
+        // Reaches in front of the near plane
+        if (clip[2] < 0.0f) return true;
+
+        float x, y, z;
+        ToScreen(clip, x, y, z);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, z);
+    }
+#endif
+
+    // Off screen or between pixel centers; frustum culling has the last word there
+    uint32_t px0, px1, py0, py1;
+    if (!PixelSpan(minX, maxX, Width, px0, px1) || !PixelSpan(minY, maxY, Height, py0, py1)) return true;
+
+    for (uint32_t ty = py0 / TileHeight; ty <= py1 / TileHeight; ty++) {
+        uint32_t row0 = std::max(py0, ty * TileHeight) - ty * TileHeight;
+        uint32_t row1 = std::min(py1, ty * TileHeight + TileHeight - 1) - ty * TileHeight;
+
+        // One bit per covered row at its first column, multiplied by the column bits
+        uint32_t rows = 0;
+        for (uint32_t r = row0; r <= row1; r++)
+            rows |= 1u << (r * TileWidth);
+
+        for (uint32_t tx = px0 / TileWidth; tx <= px1 / TileWidth; tx++) {
+            uint32_t t = ty * TilesX + tx;
+            if (nearest > m_zMax0[t]) continue;
+            if (nearest <= std::min(m_zMax0[t], m_zMax1[t])) return true;
+
+            uint32_t col0 = std::max(px0, tx * TileWidth) - tx * TileWidth;
+            uint32_t col1 = std::min(px1, tx * TileWidth + TileWidth - 1) - tx * TileWidth;
+            uint32_t columns = ((1u << (col1 + 1)) - 1) & ~((1u << col0) - 1);
+
+            // Pixels outside the working layer are only bounded by zMax0
+            if ((columns * rows) & ~m_mask[t]) return true;
+        }
+    }
+
+    return false;
+}
+
+size_t OcclusionCuller::Cull(const SphereBoundsSoA& bounds, uint32_t* indices, size_t count, unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    m_visible.resize(count);
+    auto test = [&](size_t first, size_t last) {
+        for (size_t k = first; k < last; k++) {
+            uint32_t i = indices[k];
+            float r = bounds.radius[i];
+            float min[3] = {bounds.x[i] - r, bounds.y[i] - r, bounds.z[i] - r};
+            float max[3] = {bounds.x[i] + r, bounds.y[i] + r, bounds.z[i] + r};
+            m_visible[k] = !std::isfinite(r) || IsVisible(min, max);
+        }
+    };
+
+    if (count < ParallelObjects || threads == 1) {
+        test(0, count);
+    }
+    else {
+        jobs::Shared().ParallelFor(count, MinCullRange, test, threads);
+    }
+
+    size_t n = 0;
+    for (size_t k = 0; k < count; k++) {
+        indices[n] = indices[k];
+        n += m_visible[k];
+    }
+
+    m_stats.tested += static_cast<uint32_t>(count);
+    m_stats.culled += static_cast<uint32_t>(count - n);
+    m_stats.testMs += static_cast<float>(MsSince(start));
+    return n;
+}
+
+// MARK: - Private
+
+void OcclusionCuller::RasterizeBand(uint32_t firstTileRow, uint32_t lastTileRow) noexcept
+{
+    for (const Triangle& t : m_triangles) {
+        uint32_t ty0 = std::max<uint32_t>(t.tileMinY, firstTileRow);
+        uint32_t ty1 = std::min<uint32_t>(t.tileMaxY + 1, lastTileRow);
+
+        for (uint32_t ty = ty0; ty < ty1; ty++) {
+            for (uint32_t tx = t.tileMinX; tx <= t.tileMaxX; tx++) {
+                RasterizeTile(t, tx, ty);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTile(const Triangle& t, uint32_t tx, uint32_t ty) noexcept
+{
+    float x0 = float(tx * TileWidth) + 0.5f;
+    float y0 = float(ty * TileHeight) + 0.5f;
+    uint32_t coverage = 0;
+
+#ifdef YANG_OCCLUSION_X86
+    // Edge values of the tile's first row, left and right 4 pixels
+    __m128 left = _mm_setr_ps(x0, x0 + 1.0f, x0 + 2.0f, x0 + 3.0f);
+    __m128 right = _mm_add_ps(left, _mm_set1_ps(4.0f));
+
+    __m128 edgeLeft[3], edgeRight[3], stepY[3];
+    for (int e = 0; e < 3; e++) {
+        __m128 a = _mm_set1_ps(t.edgeA[e]);
+        __m128 rowStart = _mm_set1_ps(t.edgeB[e] * y0 + t.edgeC[e]);
+        edgeLeft[e] = _mm_add_ps(_mm_mul_ps(a, left), rowStart);
+        edgeRight[e] = _mm_add_ps(_mm_mul_ps(a, right), rowStart);
+        stepY[e] = _mm_set1_ps(t.edgeB[e]);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t row = 0; row < TileHeight; row++) {
+        __m128 insideLeft = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edgeLeft[0], zero), _mm_cmpge_ps(edgeLeft[1], zero)), _mm_cmpge_ps(edgeLeft[2], zero));
+        __m128 insideRight = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edgeRight[0], zero), _mm_cmpge_ps(edgeRight[1], zero)), _mm_cmpge_ps(edgeRight[2], zero));
+
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(insideLeft) | _mm_movemask_ps(insideRight) << 4);
+        coverage |= bits << (row * TileWidth);
+
+        for (int e = 0; e < 3; e++) {
+            edgeLeft[e] = _mm_add_ps(edgeLeft[e], stepY[e]);
+            edgeRight[e] = _mm_add_ps(edgeRight[e], stepY[e]);
+        }
+    }
+#else
+    for (uint32_t row = 0; row < TileHeight; row++) {
+        for (uint32_t column = 0; column < TileWidth; column++) {
+            float x = x0 + column, y = y0 + row;
+            bool inside = true;
+            for (int e = 0; e < 3; e++)
+                inside = inside && t.edgeA[e] * x + t.edgeB[e] * y + t.edgeC[e] >= 0.0f;
+            coverage |= uint32_t(inside) << (row * TileWidth + column);
+        }
+    }
+#endif
+
+    if (coverage == 0) return;
+
+    // Farthest the triangle gets over the tile's pixel centers: the plane peaks at a
+    // corner, and never exceeds the farthest vertex
+    float x1 = x0 + (TileWidth - 1), y1 = y0 + (TileHeight - 1);
+    float planeMax = t.z0 + std::max(t.dzdx * x0, t.dzdx * x1) + std::max(t.dzdy * y0, t.dzdy * y1);
+    float zTri = std::max(0.0f, std::min(planeMax, t.zMax));
+
+    uint32_t tile = ty * TilesX + tx;
+    uint32_t& mask = m_mask[tile];
+    float& zMax0 = m_zMax0[tile];
+    float& zMax1 = m_zMax1[tile];
+
+    if (zTri >= zMax0) return;
+
+    // Far behind the working layer and close to zMax0: merging would loosen the
+    // layer more than starting over with this triangle loses
+    if (mask != 0 && zTri - zMax1 > zMax0 - zTri) {
+        mask = 0;
+        zMax1 = 0.0f;
+    }
+
+    mask |= coverage;
+    zMax1 = std::max(zMax1, zTri);
+
+    if (mask == FullMask) {
+        zMax0 = std::min(zMax0, zMax1);
+        mask = 0;
+        zMax1 = 0.0f;
+    }
+}
@@ -0,0 +1,112 @@
+//
+// OcclusionCuller.h - CPU occlusion culling against a masked low-resolution depth buffer
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+#include "TransformHierarchy.h"
+
+namespace canvas
+{
+
+// CPU-side copy of a mesh for the occlusion rasterizer; positions are xyz triples
+struct OccluderMesh
+{
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+};
+
+struct OcclusionStats
+{
+    uint32_t occluders = 0;
+    uint32_t triangles = 0; // rasterized, after near-plane and off-screen rejection
+    uint32_t tested = 0;
+    uint32_t culled = 0;
+    float rasterizeMs = 0.0f;
+    float testMs = 0.0f;
+};
+
+// The screen is split into 8x4 pixel tiles. Each tile keeps a coverage mask and two
+// depths instead of per-pixel values: every pixel is no farther than `zMax0`, and
+// the masked ones also no farther than `zMax1`, the working layer triangles are
+// merged into until it covers the tile and becomes the new zMax0. Occluders are
+// rasterized into it with SSE, 4 pixels of a tile row per step, then occludee
+// boxes are tested tile by tile against their nearest depth.
+//
+// Conservative up to pixel-center sampling: a box is only culled when every pixel
+// it covers is behind occluder depth. Depth follows the D3D convention, 0 at the
+// near plane.
+class OcclusionCuller final
+{
+public:
+    static constexpr uint32_t Width = 320;
+    static constexpr uint32_t Height = 192;
+    static constexpr uint32_t TileWidth = 8;
+    static constexpr uint32_t TileHeight = 4;
+    static constexpr uint32_t TilesX = Width / TileWidth;
+    static constexpr uint32_t TilesY = Height / TileHeight;
+
+    // Below these the work stays on the calling thread
+    static constexpr size_t ParallelTriangles = 1024;
+    static constexpr size_t ParallelObjects = 4096;
+
+    // Disallow copy / assign
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    OcclusionCuller() = default;
+
+    // Clears the buffer and the stats for a frame seen through `viewProjection`
+    // (row vectors, DirectXMath layout)
+    void Begin(const Matrix4& viewProjection);
+    // Queues the triangles of `mesh` placed by `world`
+    void AddOccluder(const OccluderMesh& mesh, const Matrix4& world);
+    // Rasterizes the queued occluders, bands of tile rows spread over up to
+    // `threads` jobs on the shared job system (0 = as many as it splits into)
+    void Rasterize(unsigned threads = 0);
+
+    // World-space box against the rasterized occluders
+    bool IsVisible(const float (&min)[3], const float (&max)[3]) const noexcept;
+    // Drops the entries of `indices` whose sphere is hidden, keeping the order of the
+    // rest, and returns how many are left; split like Rasterize
+    size_t Cull(const SphereBoundsSoA& bounds, uint32_t* indices, size_t count, unsigned threads = 0);
+
+    bool HasOccluders() const noexcept { return !m_triangles.empty(); }
+    const OcclusionStats& Stats() const noexcept { return m_stats; }
+
+    // Tile (tx, ty): covered pixels, bit = row * TileWidth + column
+    uint32_t TileMask(uint32_t tx, uint32_t ty) const noexcept { return m_mask[ty * TilesX + tx]; }
+    float TileDepth(uint32_t tx, uint32_t ty) const noexcept { return m_zMax0[ty * TilesX + tx]; }
+
+private:
+    // Screen-space triangle set up for edge and depth evaluation at pixel centers
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3]; // inside where all a*x + b*y + c >= 0
+        float z0, dzdx, dzdy;               // depth plane through (0, 0)
+        float zMax;
+        uint16_t tileMinX, tileMinY, tileMaxX, tileMaxY;
+    };
+
+    void RasterizeBand(uint32_t firstTileRow, uint32_t lastTileRow) noexcept;
+    void RasterizeTile(const Triangle&, uint32_t tx, uint32_t ty) noexcept;
+
+    Matrix4 m_viewProjection{};
+    std::vector<Triangle> m_triangles;
+    std::vector<float> m_clip; // scratch, one occluder's vertices in clip space
+
+    // Per tile
+    std::vector<uint32_t> m_mask;
+    std::vector<float> m_zMax0;
+    std::vector<float> m_zMax1;
+
+    std::vector<uint8_t> m_visible; // scratch for Cull
+    OcclusionStats m_stats;
+};
+
+} // namespace canvas
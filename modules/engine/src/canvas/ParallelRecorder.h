@@ -0,0 +1,111 @@
+//
+// ParallelRecorder.h - Records contiguous ranges of a draw list into several command lists at once
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "../common/JobSystem.h"
+#include "CommandRecorder.h"
+
+namespace canvas
+{
+
+// Slice of the frame's sorted draws that goes into one command list
+struct RecordRange
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+// Splits a sorted draw list into contiguous ranges, records each into its own
+// command list through its own CommandRecorder on the job system, and leaves the
+// lists in range order for one submission. Every list starts with nothing bound,
+// so each range pays for its first state changes again; MinDrawsPerList keeps
+// that from outweighing what the extra threads save.
+template <typename Api>
+class ParallelRecorder final
+{
+public:
+    using Recorder = CommandRecorder<Api>;
+    using CommandList = typename Api::CommandList;
+
+    static constexpr uint32_t MaxLists = 8;
+    static constexpr uint32_t DefaultMinDrawsPerList = 256;
+
+    // Disallow copy / assign
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    ParallelRecorder() = default;
+
+    void SetMinDrawsPerList(uint32_t draws) noexcept { m_minDrawsPerList = std::max(draws, 1u); }
+    uint32_t MinDrawsPerList() const noexcept { return m_minDrawsPerList; }
+
+    // Cuts `count` draws into up to `maxLists` ranges of nearly equal size, at
+    // least MinDrawsPerList each, and returns how many lists they need
+    uint32_t Split(size_t count, uint32_t maxLists) noexcept
+    {
+        size_t lists = std::min<size_t>({count / m_minDrawsPerList, maxLists, MaxLists});
+        m_rangeCount = static_cast<uint32_t>(std::max<size_t>(lists, 1));
+
+        // The first `count % lists` ranges take one draw more
+        size_t base = count / m_rangeCount, extra = count % m_rangeCount;
+        uint32_t first = 0;
+        for (uint32_t i = 0; i < m_rangeCount; i++) {
+            uint32_t size = static_cast<uint32_t>(base + (i < extra));
+            m_ranges[i] = {first, size};
+            first += size;
+        }
+        return m_rangeCount;
+    }
+
+    std::span<const RecordRange> Ranges() const noexcept { return {m_ranges.data(), m_rangeCount}; }
+
+    // Records range i of the last Split into lists[i], ranges in parallel.
+    // record(recorder, first, last) issues the draws [first, last) of the sorted
+    // list through `recorder`, which Record has already begun on the range's list.
+    template <typename Fn>
+    void Record(CommandList* const* lists, const Fn& record)
+    {
+        auto recordRanges = [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                const RecordRange& range = m_ranges[i];
+                m_recorders[i].Begin(lists[i]);
+                record(m_recorders[i], size_t(range.first), size_t(range.first) + range.count);
+            }
+        };
+
+        jobs::Shared().ParallelFor(m_rangeCount, 1, recordRanges);
+    }
+
+    // The recorder of range i, valid until the next Record
+    const Recorder& GetRecorder(uint32_t i) const noexcept { return m_recorders[i]; }
+
+    // Summed over the lists of the last Record
+    RecorderCounters GetCounters() const noexcept
+    {
+        RecorderCounters total;
+        for (uint32_t i = 0; i < m_rangeCount; i++) {
+            const RecorderCounters& counters = m_recorders[i].GetCounters();
+            total.issued += counters.issued;
+            total.skipped += counters.skipped;
+            total.draws += counters.draws;
+        }
+        return total;
+    }
+
+private:
+    uint32_t m_minDrawsPerList = DefaultMinDrawsPerList;
+
+    std::array<RecordRange, MaxLists> m_ranges{};
+    uint32_t m_rangeCount = 0;
+    std::array<Recorder, MaxLists> m_recorders;
+};
+
+} // namespace canvas
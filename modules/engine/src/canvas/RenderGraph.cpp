@@ -0,0 +1,320 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace canvas;
+
+namespace
+{
+constexpr uint32_t Unused = UINT32_MAX;
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+bool IsWrite(uint32_t state) noexcept
+{
+    return (state & RESOURCE_STATE_WRITE_MASK) != 0;
+}
+} // namespace
+
+void RenderGraph::Reset() noexcept
+{
+    m_resources.clear();
+    m_passes.clear();
+    m_accesses.clear();
+    m_order.clear();
+    m_barriers.clear();
+    m_finalBarrier = 0;
+    m_stats = {};
+}
+
+// MARK: - Declaration
+
+GraphResource RenderGraph::Import(const char* name, uint32_t initialState, uint32_t finalState)
+{
+    m_resources.push_back({name, false, {}, initialState, finalState});
+    return static_cast<GraphResource>(m_resources.size() - 1);
+}
+
+GraphResource RenderGraph::CreateTransient(const char* name, const TransientDesc& desc)
+{
+    m_resources.push_back({name, true, desc, RESOURCE_STATE_COMMON, RESOURCE_STATE_COMMON});
+    return static_cast<GraphResource>(m_resources.size() - 1);
+}
+
+GraphPass RenderGraph::AddPass(const char* name, bool sideEffects)
+{
+    m_passes.push_back({name, sideEffects});
+    return static_cast<GraphPass>(m_passes.size() - 1);
+}
+
+void RenderGraph::Read(GraphPass pass, GraphResource resource, uint32_t state)
+{
+    assert(pass < m_passes.size() && resource < m_resources.size() && !IsWrite(state));
+    m_accesses.push_back({pass, resource, state, false});
+}
+
+void RenderGraph::Write(GraphPass pass, GraphResource resource, uint32_t state)
+{
+    assert(pass < m_passes.size() && resource < m_resources.size() && IsWrite(state));
+    m_accesses.push_back({pass, resource, state, true});
+}
+
+// MARK: - Compile
+
+void RenderGraph::Compile()
+{
+    m_order.clear();
+    m_barriers.clear();
+    m_stats = {};
+
+    Cull();
+    ComputeLifetimes();
+    PlaceTransients();
+    PlaceBarriers();
+
+    m_stats.passes = static_cast<uint32_t>(m_order.size());
+    m_stats.culled = static_cast<uint32_t>(m_passes.size() - m_order.size());
+}
+
+// Walks back from what leaves the graph: a pass stays when it has side effects or
+// writes something a later kept pass or an import needs. Earlier writers of a
+// needed resource all stay, since a write may only update part of it.
+void RenderGraph::Cull()
+{
+    std::vector<uint32_t>& byPass = m_byPass;
+    byPass.resize(m_accesses.size());
+    for (uint32_t i = 0; i < byPass.size(); i++)
+        byPass[i] = i;
+    std::stable_sort(byPass.begin(), byPass.end(), [&](uint32_t a, uint32_t b) { return m_accesses[a].pass < m_accesses[b].pass; });
+
+    std::vector<uint32_t>& needed = m_state;
+    needed.assign(m_resources.size(), 0);
+    for (size_t r = 0; r < m_resources.size(); r++)
+        needed[r] = !m_resources[r].transient;
+
+    size_t end = byPass.size();
+    for (size_t p = m_passes.size(); p-- > 0;) {
+        size_t begin = end;
+        while (begin > 0 && m_accesses[byPass[begin - 1]].pass == p)
+            begin--;
+
+        Pass& pass = m_passes[p];
+        pass.kept = pass.sideEffects;
+        for (size_t k = begin; k < end && !pass.kept; k++) {
+            const Access& access = m_accesses[byPass[k]];
+            pass.kept = access.write && needed[access.resource];
+        }
+
+        if (pass.kept) {
+            for (size_t k = begin; k < end; k++)
+                needed[m_accesses[byPass[k]].resource] = 1;
+        }
+        end = begin;
+    }
+
+    m_passOrder.assign(m_passes.size(), Unused);
+    for (GraphPass p = 0; p < m_passes.size(); p++) {
+        if (!m_passes[p].kept) continue;
+
+        m_passOrder[p] = static_cast<uint32_t>(m_order.size());
+        m_order.push_back({p, 0, 0});
+    }
+}
+
+// Uses of each resource in execution order, one per pass: a pass that writes a
+// resource uses it in the write state, otherwise in the union of its reads. Each
+// use then gets its target state, the union of the reads up to the next write.
+void RenderGraph::ComputeLifetimes()
+{
+    m_uses.clear();
+    for (const Access& access : m_accesses) {
+        if (m_passOrder[access.pass] != Unused) m_uses.push_back(access);
+    }
+    std::stable_sort(m_uses.begin(), m_uses.end(), [&](const Access& x, const Access& y) {
+        return x.resource != y.resource ? x.resource < y.resource : m_passOrder[x.pass] < m_passOrder[y.pass];
+    });
+
+    size_t uses = 0;
+    for (size_t k = 0; k < m_uses.size(); k++) {
+        const Access& access = m_uses[k];
+        if (uses > 0 && m_uses[uses - 1].resource == access.resource && m_uses[uses - 1].pass == access.pass) {
+            Access& last = m_uses[uses - 1];
+            if (access.write || last.write) {
+                last.state = access.write ? access.state : last.state;
+                last.write = true;
+            }
+            else {
+                last.state |= access.state;
+            }
+            continue;
+        }
+        m_uses[uses++] = access;
+    }
+    m_uses.resize(uses);
+
+    // Target states, back to front within each resource
+    for (size_t k = uses; k-- > 1;) {
+        const Access& next = m_uses[k];
+        Access& use = m_uses[k - 1];
+        if (!use.write && !next.write && next.resource == use.resource) use.state |= next.state;
+    }
+
+    for (Resource& resource : m_resources) {
+        resource.firstUse = 1;
+        resource.lastUse = 0;
+        resource.placed = false;
+    }
+
+    for (const Access& access : m_uses) {
+        Resource& resource = m_resources[access.resource];
+        uint32_t position = m_passOrder[access.pass];
+
+        if (resource.firstUse > resource.lastUse) {
+            resource.firstUse = position;
+            resource.home = access.state;
+        }
+        resource.lastUse = position;
+    }
+}
+
+// Largest first, each at the lowest aligned offset that no transient alive at the
+// same time covers
+void RenderGraph::PlaceTransients()
+{
+    m_placing.clear();
+    for (GraphResource r = 0; r < m_resources.size(); r++) {
+        const Resource& resource = m_resources[r];
+        if (resource.transient && resource.firstUse <= resource.lastUse) {
+            m_placing.push_back(r);
+            m_stats.transientSize += AlignUp(resource.desc.size, resource.desc.alignment);
+        }
+    }
+    std::sort(m_placing.begin(), m_placing.end(), [&](GraphResource a, GraphResource b) {
+        const Resource& x = m_resources[a];
+        const Resource& y = m_resources[b];
+        return x.desc.size != y.desc.size ? x.desc.size > y.desc.size : x.firstUse < y.firstUse;
+    });
+
+    std::vector<MemoryRange>& taken = m_taken;
+
+    for (size_t i = 0; i < m_placing.size(); i++) {
+        Resource& resource = m_resources[m_placing[i]];
+
+        taken.clear();
+        for (size_t j = 0; j < i; j++) {
+            const Resource& other = m_resources[m_placing[j]];
+            if (other.lastUse < resource.firstUse || resource.lastUse < other.firstUse) continue;
+            taken.push_back({other.offset, other.offset + other.desc.size});
+        }
+        std::sort(taken.begin(), taken.end(), [](const MemoryRange& a, const MemoryRange& b) { return a.begin < b.begin; });
+
+        uint64_t offset = 0;
+        for (const MemoryRange& range : taken) {
+            if (offset + resource.desc.size <= range.begin) break;
+            offset = std::max(offset, AlignUp(range.end, resource.desc.alignment));
+        }
+
+        resource.offset = offset;
+        resource.placed = true;
+        m_stats.heapSize = std::max(m_stats.heapSize, offset + resource.desc.size);
+    }
+}
+
+void RenderGraph::PlaceBarriers()
+{
+    // Uses by position
+    std::stable_sort(m_uses.begin(), m_uses.end(), [&](const Access& a, const Access& b) {
+        return m_passOrder[a.pass] < m_passOrder[b.pass];
+    });
+
+    m_state.resize(m_resources.size());
+    for (GraphResource r = 0; r < m_resources.size(); r++) {
+        const Resource& resource = m_resources[r];
+        m_state[r] = resource.transient ? resource.home : resource.initialState;
+    }
+    // Whether the last use wrote through unordered access
+    m_uavWritten.assign(m_resources.size(), 0);
+
+    auto push = [&](BarrierType type, GraphResource r, GraphResource before, uint32_t from, uint32_t to) {
+        m_barriers.push_back({type, r, before, from, to});
+        switch (type) {
+        case BarrierType::TRANSITION:
+            m_stats.transitions++;
+            break;
+        case BarrierType::ALIASING:
+            m_stats.aliasing++;
+            break;
+        case BarrierType::UAV:
+            m_stats.uav++;
+            break;
+        }
+    };
+
+    size_t k = 0;
+    for (uint32_t position = 0; position < m_order.size(); position++) {
+        CompiledPass& compiled = m_order[position];
+        compiled.firstBarrier = static_cast<uint32_t>(m_barriers.size());
+
+        for (; k < m_uses.size() && m_passOrder[m_uses[k].pass] == position; k++) {
+            const Access& use = m_uses[k];
+            GraphResource r = use.resource;
+            const Resource& resource = m_resources[r];
+
+            if (resource.transient && resource.firstUse == position) {
+                // The transient that used this memory last, this frame or the one before
+                GraphResource previous = NoGraphResource;
+                uint32_t previousUse = 0;
+                bool found = false, ambiguous = false;
+
+                for (GraphResource other : m_placing) {
+                    const Resource& o = m_resources[other];
+                    if (other == r || o.offset >= resource.offset + resource.desc.size || resource.offset >= o.offset + o.desc.size) continue;
+
+                    // Uses before this frame's first use rank above last frame's
+                    uint32_t rank = o.lastUse < position ? o.lastUse + uint32_t(m_order.size()) : o.lastUse;
+                    if (!found || rank > previousUse) {
+                        previous = other;
+                        previousUse = rank;
+                        ambiguous = false;
+                    }
+                    else if (rank == previousUse) {
+                        ambiguous = true;
+                    }
+                    found = true;
+                }
+
+                if (found) push(BarrierType::ALIASING, r, ambiguous ? NoGraphResource : previous, 0, 0);
+            }
+
+            // A read already covered by the union of an earlier one stays put
+            uint32_t current = m_state[r];
+            bool covered = !use.write && !IsWrite(current) && (current & use.state) == use.state;
+            if (current != use.state && !covered) {
+                push(BarrierType::TRANSITION, r, NoGraphResource, current, use.state);
+                m_state[r] = use.state;
+            }
+            else if (use.state == RESOURCE_STATE_UNORDERED_ACCESS && (use.write || m_uavWritten[r])) {
+                push(BarrierType::UAV, r, NoGraphResource, current, current);
+            }
+
+            m_uavWritten[r] = use.write && use.state == RESOURCE_STATE_UNORDERED_ACCESS;
+        }
+
+        compiled.barrierCount = static_cast<uint32_t>(m_barriers.size()) - compiled.firstBarrier;
+        m_stats.batches += compiled.barrierCount > 0;
+    }
+
+    m_finalBarrier = m_barriers.size();
+    for (GraphResource r = 0; r < m_resources.size(); r++) {
+        const Resource& resource = m_resources[r];
+        if (resource.transient && !resource.placed) continue;
+
+        uint32_t wanted = resource.transient ? resource.home : resource.finalState;
+        if (m_state[r] != wanted) push(BarrierType::TRANSITION, r, NoGraphResource, m_state[r], wanted);
+    }
+    m_stats.batches += m_barriers.size() > m_finalBarrier;
+}
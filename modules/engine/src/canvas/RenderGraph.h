@@ -0,0 +1,225 @@
+//
+// RenderGraph.h - Frame graph of passes and the resources they touch, compiled to barriers and aliased memory
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace canvas
+{
+
+using GraphResource = uint32_t;
+using GraphPass = uint32_t;
+
+constexpr GraphResource NoGraphResource = UINT32_MAX;
+
+// Resource states as bit flags, mirroring D3D12_RESOURCE_STATES without the device
+// types. Read states combine; a write state stands alone.
+enum ResourceState : uint32_t
+{
+    RESOURCE_STATE_COMMON = 0, // also PRESENT
+    RESOURCE_STATE_RENDER_TARGET = 1 << 0,
+    RESOURCE_STATE_DEPTH_WRITE = 1 << 1,
+    RESOURCE_STATE_UNORDERED_ACCESS = 1 << 2,
+    RESOURCE_STATE_COPY_DEST = 1 << 3,
+    RESOURCE_STATE_DEPTH_READ = 1 << 4,
+    RESOURCE_STATE_SHADER_READ = 1 << 5, // pixel and non-pixel shader resource
+    RESOURCE_STATE_COPY_SOURCE = 1 << 6,
+
+    RESOURCE_STATE_WRITE_MASK = RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_UNORDERED_ACCESS | RESOURCE_STATE_COPY_DEST,
+};
+
+enum class TextureUsage : uint8_t
+{
+    RENDER_TARGET,
+    DEPTH_STENCIL,
+};
+
+// A texture the graph owns for one frame. Size and alignment come from the device
+// (GetResourceAllocationInfo), so the graph can place it without one.
+struct TransientDesc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t format = 0; // DXGI_FORMAT
+    TextureUsage usage = TextureUsage::RENDER_TARGET;
+    bool allowUnorderedAccess = false;
+
+    uint64_t size = 0;
+    uint64_t alignment = 65536;
+};
+
+enum class BarrierType : uint8_t
+{
+    TRANSITION,
+    // Memory changes hands between two aliased transients; `aliasBefore` is
+    // NoGraphResource when several could have used it last
+    ALIASING,
+    // Unordered-access writes back to back
+    UAV,
+};
+
+struct GraphBarrier
+{
+    BarrierType type;
+    GraphResource resource;
+    GraphResource aliasBefore;
+    uint32_t before; // ResourceState
+    uint32_t after;
+};
+
+// A pass that survived culling, in execution order, with the barriers that go in
+// one batch right before it
+struct CompiledPass
+{
+    GraphPass pass;
+    uint32_t firstBarrier;
+    uint32_t barrierCount;
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes = 0;
+    uint32_t culled = 0;
+    uint32_t transitions = 0;
+    uint32_t aliasing = 0;
+    uint32_t uav = 0;
+    uint32_t batches = 0;      // non-empty barrier batches, final one included
+    uint64_t heapSize = 0;     // aliased transient memory
+    uint64_t transientSize = 0; // what the transients would take side by side
+};
+
+// Passes declare the resources they read and write, in the order they would run.
+// Compile culls passes nothing needs, keeps the rest in declaration order (always a
+// valid one, each read follows the write it sees), places one batch of barriers
+// before each pass and one after the last, and aliases transients whose lifetimes
+// do not overlap into one heap.
+//
+// Consecutive reads of a resource transition once, to the union of the read
+// states. A transient starts and ends each frame in the state of its first use,
+// its home state, so the device side creates it in that state once. Memory a
+// transient takes over holds garbage: the first pass writing it must clear,
+// discard or fully overwrite it.
+class RenderGraph final
+{
+public:
+    // Disallow copy / assign
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    RenderGraph() = default;
+
+    // Forgets the passes and resources, keeps the memory
+    void Reset() noexcept;
+
+    // MARK: - Declaration
+
+    // A resource the graph does not own, e.g. the back buffer, with the state it
+    // comes in and the one it has to be left in. `name` must outlive the graph.
+    GraphResource Import(const char* name, uint32_t initialState, uint32_t finalState);
+    GraphResource CreateTransient(const char* name, const TransientDesc&);
+
+    // Kept by culling even when nothing reads what it writes
+    GraphPass AddPass(const char* name, bool sideEffects = false);
+    void Read(GraphPass, GraphResource, uint32_t state);
+    void Write(GraphPass, GraphResource, uint32_t state);
+
+    // MARK: - Compiled
+
+    void Compile();
+
+    std::span<const CompiledPass> Order() const noexcept { return m_order; }
+    std::span<const GraphBarrier> Barriers(const CompiledPass& pass) const noexcept
+    {
+        return {m_barriers.data() + pass.firstBarrier, pass.barrierCount};
+    }
+    // Returns imports to their final state and transients to their home state
+    std::span<const GraphBarrier> FinalBarriers() const noexcept
+    {
+        return {m_barriers.data() + m_finalBarrier, m_barriers.size() - m_finalBarrier};
+    }
+
+    size_t ResourceCount() const noexcept { return m_resources.size(); }
+    size_t PassCount() const noexcept { return m_passes.size(); }
+    bool IsTransient(GraphResource r) const noexcept { return m_resources[r].transient; }
+    const char* ResourceName(GraphResource r) const noexcept { return m_resources[r].name; }
+    const char* PassName(GraphPass p) const noexcept { return m_passes[p].name; }
+    const TransientDesc& Desc(GraphResource r) const noexcept { return m_resources[r].desc; }
+
+    // Transients only, after Compile: byte offset in the heap, home state, and the
+    // first and last positions in Order() that use it (first > last if unused)
+    uint64_t HeapOffset(GraphResource r) const noexcept { return m_resources[r].offset; }
+    uint32_t HomeState(GraphResource r) const noexcept { return m_resources[r].home; }
+    uint32_t FirstUse(GraphResource r) const noexcept { return m_resources[r].firstUse; }
+    uint32_t LastUse(GraphResource r) const noexcept { return m_resources[r].lastUse; }
+
+    const RenderGraphStats& Stats() const noexcept { return m_stats; }
+
+private:
+    struct Resource
+    {
+        const char* name;
+        bool transient;
+        TransientDesc desc;
+        uint32_t initialState;
+        uint32_t finalState;
+
+        // Compiled
+        uint32_t home = 0;
+        uint64_t offset = 0;
+        uint32_t firstUse = 0;
+        uint32_t lastUse = 0;
+        bool placed = false;
+    };
+
+    struct Access
+    {
+        GraphPass pass;
+        GraphResource resource;
+        uint32_t state;
+        bool write;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        bool sideEffects;
+        bool kept = false;
+    };
+
+    struct MemoryRange
+    {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    void Cull();
+    void ComputeLifetimes();
+    void PlaceTransients();
+    void PlaceBarriers();
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<Access> m_accesses;
+
+    // Compiled
+    std::vector<CompiledPass> m_order;
+    std::vector<GraphBarrier> m_barriers;
+    size_t m_finalBarrier = 0;
+    RenderGraphStats m_stats;
+
+    // Scratch
+    std::vector<uint32_t> m_byPass;      // access indices grouped by pass
+    std::vector<uint32_t> m_passOrder;   // by GraphPass, position in m_order or UINT32_MAX
+    std::vector<Access> m_uses;          // one per kept pass and resource, target states
+    std::vector<uint32_t> m_state;       // by resource
+    std::vector<uint8_t> m_uavWritten;   // by resource
+    std::vector<GraphResource> m_placing; // placed transients, largest first
+    std::vector<MemoryRange> m_taken;
+};
+
+} // namespace canvas
@@ -4,7 +4,10 @@
 
 #include "Renderer.h"
 #include "../common/AsyncLogger.h"
+#include "../common/BinaryLog.h"
+#include "../common/FlightRecorder.h"
 #include "../common/GameTimer.h"
+#include "../common/JobSystem.h"
 #include "../device/DeviceResources.h"
 #include "../pch.h"
 
@@ -19,13 +22,15 @@ Renderer::Renderer(
     DX::DeviceResources* deviceResources,
     pipeline::Store* pipelineStore,
     ResourceHolder* resourceHolder,
-    Scene* scene
+    Scene* scene,
+    window::WindowStateReducer* stateReducer
 ) noexcept :
-    m_fuckingTimer(GameTimer()),
+    m_fuckingTimer(),
     m_deviceResources(deviceResources),
     m_resourceHolder(resourceHolder),
     m_scene(scene),
-    m_pipelineStore(pipelineStore)
+    m_pipelineStore(pipelineStore),
+    m_stateReducer(stateReducer)
 {
 }
 
@@ -36,6 +41,7 @@ void Renderer::OnDeviceActivated(ID3D12Device* device)
     m_pipelineStore->Initialize(device);
     m_resourceHolder->Initialize(device);
     m_scene->OnEnter();
+    UpdateSimulationStep();
     m_initialized = TRUE;
 }
 
@@ -91,6 +97,7 @@ void Renderer::OnWindowMessage(canvas::Message message, RECT windowBounds)
     }
     case canvas::Message::DISPLAY_CHANGED: {
         m_deviceResources->UpdateColorSpace();
+        UpdateSimulationStep();
         break;
     }
     case canvas::Message::SIZE_CHANGED: {
@@ -106,30 +113,147 @@ void Renderer::OnWindowMessage(canvas::Message message, RECT windowBounds)
 
 void Renderer::Render()
 {
-    timer::Tick tick = m_fuckingTimer.Tick();
+    // Start of the frame, for the flight recorder
+    auto timestamp = logging::Now();
 
-    if (tick.frameCount == m_lastRenderedFrame)
-        return;
+    // Simulate every fixed step that is due, then render in between the last two
+    timer::Tick tick = m_fuckingTimer.Tick([&](const timer::Tick& step) { m_scene->Update(step); });
 
-    m_lastRenderedFrame = tick.frameCount;
+    YANG_BLOG(
+        DEBUG,
+        "frame {} total {} dt {} alpha {}",
+        tick.frameCount,
+        tick.totalTime,
+        tick.deltaTime,
+        tick.alpha
+    );
 
     // Prepare
     auto commandList = m_deviceResources->Prepare();
 
-    m_scene->Update(tick);
+    m_scene->Interpolate(tick.alpha);
+    m_resourceHolder->BeginFrame();
 
     // Render
-    for (const auto& drawItem : m_scene->MakeDrawItems()) {
-        Draw(drawItem, commandList);
-    }
+    auto drawItems = m_scene->MakeDrawItems();
+    SortDrawItems(drawItems);
+    RecordDraws(commandList, drawItems);
+
+    logging::FlightRecorder::Frame({
+        .frameIndex = tick.frameCount,
+        .timestamp = timestamp,
+        .frameTime = m_lastFrameTimestamp ? timestamp - m_lastFrameTimestamp : 0,
+        .drawCount = static_cast<uint32_t>(drawItems.size()),
+        .fenceSignaled = m_deviceResources->GetFenceValue(),
+        .fenceCompleted = m_deviceResources->GetCompletedFenceValue(),
+    });
+    m_lastFrameTimestamp = timestamp;
+
+    ReportFrameStats();
 
     // Present
     m_deviceResources->Present();
 }
 
-void Renderer::Draw(const DrawItem& drawItem, ID3D12GraphicsCommandList* commandList) noexcept
+// Once every FrameTimeRecorder::SampleCount frames, logs the frame-time percentiles
+// over those frames, then this frame's command, occlusion and LOD counters
+void Renderer::ReportFrameStats()
+{
+    const auto& frameTimes = m_fuckingTimer.FrameTimes();
+    auto count = frameTimes.GetTotalCount();
+
+    // Paused timers stop recording, report each window once
+    if (count == m_frameTimesReported || count % timer::FrameTimeRecorder::SampleCount != 0) return;
+
+    m_frameTimesReported = count;
+
+    auto window = frameTimes.Window();
+    YANG_LOG(
+        INFO,
+        GENERAL,
+        "frame time us | p50: ", window.p50 / 1000,
+        " | p90: ", window.p90 / 1000,
+        " | p99: ", window.p99 / 1000,
+        " | max: ", window.max / 1000,
+        " | over budget: ", window.overBudget, "/", window.count
+    );
+
+    // Command list traffic of this frame
+    const auto& commands = m_recorder.GetCounters();
+    YANG_LOG(
+        INFO,
+        GENERAL,
+        "commands | draws: ", commands.draws,
+        " | lists: ", m_recorder.Ranges().size(),
+        " | instances: ", m_scene->GetInstanceCount(),
+        " | state issued: ", commands.issued,
+        " | skipped: ", commands.skipped
+    );
+
+    const auto& occlusion = m_scene->GetOcclusionStats();
+    YANG_LOG(
+        INFO,
+        GENERAL,
+        "occlusion | occluders: ", occlusion.occluders,
+        " | triangles: ", occlusion.triangles,
+        " | tested: ", occlusion.tested,
+        " | culled: ", occlusion.culled,
+        " | ms: ", occlusion.rasterizeMs + occlusion.testMs
+    );
+
+    const auto& lod = m_scene->GetLodStats();
+    YANG_LOG(
+        INFO,
+        GENERAL,
+        "lod | selected: ", lod.selected,
+        " | switched: ", lod.switched,
+        " | triangles: ", lod.trianglesDrawn,
+        " | saved: ", lod.TrianglesSaved(),
+        " | ms: ", lod.selectMs
+    );
+}
+
+void Renderer::SortDrawItems(std::span<const DrawItem> drawItems)
+{
+    m_drawOrder.resize(drawItems.size());
+    m_sortScratch.resize(drawItems.size());
+
+    for (size_t i = 0; i < drawItems.size(); i++) {
+        m_drawOrder[i] = {drawItems[i].sortKey, static_cast<uint32_t>(i), 0};
+    }
+
+    RadixSort(m_drawOrder.data(), m_sortScratch.data(), m_drawOrder.size());
+}
+
+// Contiguous ranges of the sorted draws, each recorded into its own list on the
+// job system; Present submits them in order
+void Renderer::RecordDraws(ID3D12GraphicsCommandList* commandList, std::span<const DrawItem> drawItems)
+{
+    uint32_t lists = m_recorder.Split(m_drawOrder.size(), jobs::Shared().ThreadCount());
+
+    // A single range goes straight into the frame's list
+    ID3D12GraphicsCommandList* const* targets = lists == 1 ? &commandList : m_deviceResources->PrepareDrawLists(lists).data();
+
+    m_recorder.Record(targets, [&](D3D12Recorder& recorder, size_t first, size_t last) {
+        for (size_t k = first; k < last; k++) {
+            Draw(recorder, drawItems[m_drawOrder[k].index]);
+        }
+    });
+}
+
+// Step the simulation once per display refresh where the rate is known
+void Renderer::UpdateSimulationStep()
+{
+    double hz = m_stateReducer->getRefreshRate();
+    if (hz < 30.0 || hz > 500.0) return;
+
+    m_fuckingTimer.SetStep(1.0 / hz);
+    YANG_LOG(INFO, WINDOW, "simulation step 1/", hz, " s");
+}
+
+void Renderer::Draw(D3D12Recorder& recorder, const DrawItem& drawItem)
 {
-    m_pipelineStore->Prepare(drawItem.psoType, commandList);
+    m_pipelineStore->Prepare(drawItem.psoType, recorder);
 
     // TODO: add srv heap
     // // 6) Глобальные heap'ы (CBV/SRV/UAV)
@@ -137,21 +261,22 @@ void Renderer::Draw(const DrawItem& drawItem, ID3D12GraphicsCommandList* command
     // commandList->SetDescriptorHeaps(_countof(heaps), heaps);
     // if (it.srv.ptr) commandList->SetGraphicsRootDescriptorTable(2, drawItem.srv);
 
-    commandList->IASetPrimitiveTopology(drawItem.topology);
-    commandList->IASetVertexBuffers(0, 1, &drawItem.vbv);
+    recorder.IASetPrimitiveTopology(drawItem.topology);
+    recorder.IASetVertexBuffers(0, 1, &drawItem.vbv);
 
-    if (drawItem.vsCB) commandList->SetGraphicsRootConstantBufferView(0, drawItem.vsCB);
-    if (drawItem.psCB) commandList->SetGraphicsRootConstantBufferView(0, drawItem.psCB);
+    if (drawItem.vsCB) recorder.SetGraphicsRootConstantBufferView(0, drawItem.vsCB);
+    if (drawItem.psCB) recorder.SetGraphicsRootConstantBufferView(0, drawItem.psCB);
+    if (drawItem.instances) recorder.SetGraphicsRootShaderResourceView(1, drawItem.instances);
 
-    PIXBeginEvent(commandList, PIX_COLOR_DEFAULT, L"Render");
+    PIXBeginEvent(recorder.Get(), PIX_COLOR_DEFAULT, L"Render");
 
     if (drawItem.ibv.SizeInBytes) {
-        commandList->IASetIndexBuffer(&drawItem.ibv);
-        commandList->DrawIndexedInstanced(drawItem.countPerInstance, drawItem.instanceCount, 0, 0, 0);
+        recorder.IASetIndexBuffer(&drawItem.ibv);
+        recorder.DrawIndexedInstanced(drawItem.countPerInstance, drawItem.instanceCount, drawItem.startIndex, drawItem.baseVertex, 0);
     }
     else {
-        commandList->DrawInstanced(drawItem.countPerInstance, drawItem.instanceCount, 0, 0);
+        recorder.DrawInstanced(drawItem.countPerInstance, drawItem.instanceCount, drawItem.startIndex, 0);
     }
 
-    PIXEndEvent(commandList);
+    PIXEndEvent(recorder.Get());
 }
\ No newline at end of file
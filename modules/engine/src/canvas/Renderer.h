@@ -8,12 +8,17 @@
 #include "../device/DeviceResources.h"
 #include "../input/InputController.h"
 #include "../pipeline/Store.h"
+#include "../window/WindowStateReducer.h"
 #include "Camera.h"
+#include "D3D12Recorder.h"
 #include "DrawItem.h"
+#include "DrawSort.h"
 #include "ResourceHolder.h"
 #include "Scene.h"
 
 #include <memory>
+#include <span>
+#include <vector>
 
 namespace canvas
 {
@@ -36,7 +41,7 @@ public:
     Renderer(const Renderer&) = delete;
     Renderer& operator=(const Renderer&) = delete;
 
-    Renderer(DX::DeviceResources*, pipeline::Store*, ResourceHolder*, Scene*) noexcept;
+    Renderer(DX::DeviceResources*, pipeline::Store*, ResourceHolder*, Scene*, window::WindowStateReducer*) noexcept;
     ~Renderer() noexcept = default;
 
     void OnWindowMessage(canvas::Message, RECT windowBounds);
@@ -47,10 +52,24 @@ public:
 
 private:
     void Render();
-    void Draw(const DrawItem&, ID3D12GraphicsCommandList*) noexcept;
+    void UpdateSimulationStep();
+    void ReportFrameStats();
+    void SortDrawItems(std::span<const DrawItem>);
+    void RecordDraws(ID3D12GraphicsCommandList*, std::span<const DrawItem>);
+    // Called from the recording threads
+    void Draw(D3D12Recorder&, const DrawItem&);
 
     GameTimer m_fuckingTimer;
-    uint64_t m_lastRenderedFrame = 0;
+    uint64_t m_lastFrameTimestamp = 0;
+    uint64_t m_frameTimesReported = 0;
+
+    // Draw order of the current frame, by DrawItem::sortKey
+    std::vector<SortItem> m_drawOrder;
+    std::vector<SortItem> m_sortScratch;
+
+    // Splits the sorted draws over command lists, one recorder per list skipping
+    // rebinds of what that list already has bound
+    D3D12ParallelRecorder m_recorder;
 
     bool m_initialized = false;
     bool m_hasInvalidSize = false;
@@ -60,5 +79,6 @@ private:
     pipeline::Store* m_pipelineStore;
     ResourceHolder* m_resourceHolder;
     Scene* m_scene;
+    window::WindowStateReducer* m_stateReducer;
 };
 } // namespace canvas
@@ -10,6 +10,11 @@ using namespace canvas;
 
 using Microsoft::WRL::ComPtr;
 
+namespace
+{
+constexpr size_t FramesInFlight = DX::BufferParams::MAX_BACK_BUFFER_COUNT;
+}
+
 inline void Unmap(ID3D12Resource* resource)
 {
     resource->Unmap(0, nullptr);
@@ -35,10 +40,14 @@ void ResourceHolder::Initialize(ID3D12Device* device)
     m_resourceFactory = std::make_unique<device::ResourceFactory>(device);
 
     m_constantBuffer = m_resourceFactory->CreateUploadBuffer(
-        sizeof(ShaderConstants),
+        sizeof(ShaderConstants) * MaxDrawsPerFrame * FramesInFlight,
         D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
     );
     Map(m_constantBuffer.Get(), &m_shaderConstants);
+
+    // GENERIC_READ covers the root SRV reads
+    m_instanceBuffer = m_resourceFactory->CreateUploadBuffer(sizeof(InstanceData) * MaxInstancesPerFrame * FramesInFlight);
+    Map(m_instanceBuffer.Get(), &m_instances);
 }
 
 void ResourceHolder::Deinitialize() noexcept
@@ -46,42 +55,57 @@ void ResourceHolder::Deinitialize() noexcept
     Unmap(m_constantBuffer.Get());
     m_constantBuffer.Reset();
     m_shaderConstants = nullptr;
+    m_frameSlice = 0;
+    m_drawsThisFrame = 0;
+
+    Unmap(m_instanceBuffer.Get());
+    m_instanceBuffer.Reset();
+    m_instances = nullptr;
+    m_instancesThisFrame = 0;
 
     m_cache.clear();
 }
 
+void ResourceHolder::BeginFrame() noexcept
+{
+    m_frameSlice = (m_frameSlice + 1) % FramesInFlight;
+    m_drawsThisFrame = 0;
+    m_instancesThisFrame = 0;
+}
+
 MeshHandle ResourceHolder::LoadMesh(const MeshDesc& desc)
 {
-    MeshHandle meshHandle;
+    MeshHandle meshHandle = m_nextHandle++;
 
     SubmeshRange submeshRange{};
     MeshResource meshResource{};
 
     switch (desc) {
     case MeshDesc::CUBES: {
-        meshHandle = 1;
-
         auto meshVertices = MakeCubeVertices();
         auto meshVB = CreateVertexBuffer(meshVertices.data(), sizeof(meshVertices), sizeof(Vertex));
         meshResource.vb = meshVB.resource;
-        meshResource.vbv = meshVB.view;
+        meshResource.views.vbv = meshVB.view;
 
         auto meshIndices = MakeCubeIndices();
         auto meshIB = CreateIndexBuffer(meshIndices.data(), sizeof(meshIndices));
         meshResource.ib = meshIB.resource;
-        meshResource.ibv = meshIB.view;
+        meshResource.views.ibv = meshIB.view;
+
+        for (const auto& vertex : meshVertices) {
+            meshResource.occluder.positions.insert(meshResource.occluder.positions.end(), {vertex.position.x, vertex.position.y, vertex.position.z});
+        }
+        meshResource.occluder.indices.assign(meshIndices.begin(), meshIndices.end());
 
         submeshRange.indexCount = 36;
         submeshRange.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
         break;
     }
     case MeshDesc::UI: {
-        meshHandle = 2;
-
         auto uiVertices = MakeTriangle(0.5f, 0.5f);
         auto uiVB = CreateVertexBuffer(uiVertices.data(), sizeof(uiVertices), sizeof(Vertex));
         meshResource.vb = uiVB.resource;
-        meshResource.vbv = uiVB.view;
+        meshResource.views.vbv = uiVB.view;
 
         submeshRange.indexCount = 3;
         submeshRange.topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -89,8 +113,11 @@ MeshHandle ResourceHolder::LoadMesh(const MeshDesc& desc)
     }
     };
 
-    meshResource.parts.push_back(submeshRange);
-    m_cache[meshHandle] = meshResource;
+    // Neither mesh has anything to simplify; a single level still reports its triangles
+    meshResource.views.parts.push_back(submeshRange);
+    meshResource.views.lods.push_back({0, 1});
+    meshResource.views.lodChain.triangles[0] = submeshRange.indexCount / 3;
+    m_cache[meshHandle] = std::move(meshResource);
     return meshHandle;
 }
 
@@ -99,23 +126,39 @@ void ResourceHolder::UnloadMesh(MeshHandle handle)
     m_cache.erase(handle);
 }
 
-MeshViews ResourceHolder::GetMeshViews(MeshHandle handle)
+const MeshViews& ResourceHolder::GetMeshViews(MeshHandle handle)
 {
-    auto resource = m_cache.at(handle);
+    return m_cache.at(handle).views;
+}
 
-    MeshViews meshViews{};
+const OccluderMesh* ResourceHolder::GetOccluderMesh(MeshHandle handle)
+{
+    const OccluderMesh& occluder = m_cache.at(handle).occluder;
+    return occluder.indices.empty() ? nullptr : &occluder;
+}
 
-    meshViews.vbv = resource.vbv;
-    meshViews.ibv = resource.ibv;
-    meshViews.parts = resource.parts;
+D3D12_GPU_VIRTUAL_ADDRESS ResourceHolder::WritePerDrawCB(const ShaderConstants& data)
+{
+    if (m_drawsThisFrame == MaxDrawsPerFrame) {
+        throw std::runtime_error("per-draw constant buffer ring is full");
+    }
 
-    return meshViews;
-};
+    size_t slot = m_frameSlice * MaxDrawsPerFrame + m_drawsThisFrame++;
+    m_shaderConstants[slot] = data;
 
-D3D12_GPU_VIRTUAL_ADDRESS ResourceHolder::WritePerDrawCB(const ShaderConstants& data)
+    return m_constantBuffer->GetGPUVirtualAddress() + slot * sizeof(ShaderConstants);
+}
+
+InstanceAllocation ResourceHolder::AllocateInstances(size_t count)
 {
-    *m_shaderConstants = data;
-    return m_constantBuffer->GetGPUVirtualAddress();
+    if (count > MaxInstancesPerFrame - m_instancesThisFrame) {
+        throw std::runtime_error("instance buffer ring is full");
+    }
+
+    size_t first = m_frameSlice * MaxInstancesPerFrame + m_instancesThisFrame;
+    m_instancesThisFrame += count;
+
+    return {m_instances + first, m_instanceBuffer->GetGPUVirtualAddress() + first * sizeof(InstanceData)};
 }
 
 // MARK: - Private
@@ -34,15 +34,25 @@ public:
     void Initialize(ID3D12Device*);
     void Deinitialize() noexcept;
 
+    // Moves WritePerDrawCB to the next frame's slice of the constant buffer ring
+    void BeginFrame() noexcept;
+
     // MARK: - ResourceFactory
 
     MeshHandle LoadMesh(const MeshDesc&) override;
     void UnloadMesh(MeshHandle) override;
-    MeshViews GetMeshViews(MeshHandle handle) override;
+    const MeshViews& GetMeshViews(MeshHandle handle) override;
+    const OccluderMesh* GetOccluderMesh(MeshHandle handle) override;
 
     // MARK: - RendererServices
 
     D3D12_GPU_VIRTUAL_ADDRESS WritePerDrawCB(const ShaderConstants& data) override;
+    InstanceAllocation AllocateInstances(size_t count) override;
+
+    // Per-draw constants each frame can write before the ring runs out
+    static constexpr size_t MaxDrawsPerFrame = 4096;
+    // Likewise for instances
+    static constexpr size_t MaxInstancesPerFrame = 131072;
 
 private:
     struct VertexBuffer
@@ -61,18 +71,27 @@ private:
     {
         Microsoft::WRL::ComPtr<ID3D12Resource> vb;
         Microsoft::WRL::ComPtr<ID3D12Resource> ib;
-        D3D12_VERTEX_BUFFER_VIEW vbv{};
-        D3D12_INDEX_BUFFER_VIEW ibv{};
-        std::vector<SubmeshRange> parts;
+        MeshViews views;
+        OccluderMesh occluder; // empty when the mesh is no occluder
     };
 
     VertexBuffer CreateVertexBuffer(const void* data, size_t bytes, UINT stride);
     IndexBuffer CreateIndexBuffer(const void* data, size_t bytes);
 
+    // One slice of MaxDrawsPerFrame constants per frame in flight, so a draw never
+    // overwrites constants the GPU may still be reading
     ShaderConstants* m_shaderConstants = nullptr;
+    size_t m_frameSlice = 0;
+    size_t m_drawsThisFrame = 0;
 
     Microsoft::WRL::ComPtr<ID3D12Resource> m_constantBuffer;
+
+    // Same scheme for the instance buffer
+    InstanceData* m_instances = nullptr;
+    size_t m_instancesThisFrame = 0;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_instanceBuffer;
     std::unordered_map<MeshHandle, MeshResource> m_cache;
+    MeshHandle m_nextHandle = 1;
 
     std::unique_ptr<device::ResourceFactory> m_resourceFactory;
 };
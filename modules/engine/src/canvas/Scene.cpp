@@ -2,10 +2,70 @@
 #include "../input/InputController.h"
 #include "../window/WindowStateReducer.h"
 #include "Camera.h"
+#include "DrawSort.h"
+
+#include <limits>
 
 using namespace DirectX;
 using namespace canvas;
 
+namespace
+{
+// Cubes of Triangle_VS in model space, instance by instance
+constexpr float ClusterScale = 0.1f;
+constexpr float ClusterDistance = 5.0f;
+constexpr float ClusterOffsets[][3] = {
+    {0.0f, 0.0f, ClusterDistance},
+    {ClusterDistance, 0.0f, 0.0f}, // shakes
+    {0.0f, 0.0f, -ClusterDistance}, // distorted
+    {0.0f, 0.0f, 0.0f},             // spins
+    {0.0f, -ClusterDistance, 0.0f},
+    {0.0f, ClusterDistance, 0.0f},
+    {0.0f, 0.0f, 0.0f}, // orbits
+};
+
+InstanceStyle Tint(float r, float g, float b, float biasR = 0.0f, float biasG = 0.0f, float biasB = 0.0f)
+{
+    InstanceStyle style;
+    style.colorScale[0] = r;
+    style.colorScale[1] = g;
+    style.colorScale[2] = b;
+    style.colorBias[0] = biasR;
+    style.colorBias[1] = biasG;
+    style.colorBias[2] = biasB;
+    return style;
+}
+
+// Offset of a shake every 1.5 s, see the former Shake in Triangle_VS
+Float3 ShakeOffset(float time)
+{
+    constexpr float Interval = 1.5f;
+    constexpr float Duration = 0.4f;
+    constexpr float Intensity = 0.15f;
+    constexpr float Frequency = 150.0f;
+
+    float cycle = std::fmod(time, Interval);
+    if (cycle > Duration) return {0.0f, 0.0f, 0.0f};
+
+    float t = cycle / Duration;
+    float envelope = std::sin(t * XM_PI) * (1.0f - t) * Intensity;
+
+    return {
+        std::sin(time * Frequency) * envelope,
+        std::sin(time * Frequency * 1.3f) * envelope,
+        std::sin(time * Frequency * 0.7f) * envelope,
+    };
+}
+
+// pipeline:8 | mesh:24 | submesh:8 | depth:24; everything above the depth has to
+// match for two packets to share an instanced draw
+uint64_t BatchKey(PSOType psoType, MeshHandle mesh, uint32_t submesh, float depth) noexcept
+{
+    return uint64_t(static_cast<uint32_t>(psoType) & 0xFF) << 56 | uint64_t(mesh & 0xFFFFFF) << 32 |
+           uint64_t(submesh & 0xFF) << 24 | SortKey::QuantizeDepth(depth);
+}
+} // namespace
+
 Scene::Scene(
     ResourceFactory& resourceFactory,
     RendererServices& rendererServices,
@@ -20,38 +80,243 @@ Scene::Scene(
 
 void Scene::OnEnter()
 {
-    m_meshHandle = m_resourceFactory.LoadMesh(MeshDesc::CUBES);
-    m_uiHandle = m_resourceFactory.LoadMesh(MeshDesc::UI);
+    MeshHandle cubes = m_resourceFactory.LoadMesh(MeshDesc::CUBES);
+    MeshHandle ui = m_resourceFactory.LoadMesh(MeshDesc::UI);
+    m_meshes = {cubes, ui};
+
+    // Seven cubes around the origin, each an instance of its own; AnimateCluster
+    // moves them every step
+    InstanceStyle clusterStyles[] = {
+        Tint(0.0f, 1.0f, 0.0f),
+        Tint(0.0f, 1.0f, 1.0f),
+        Tint(0.0f, 1.0f, 1.0f, 1.0f),
+        Tint(1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+        Tint(0.0f, 1.0f, 0.0f),
+        Tint(0.0f, 1.0f, 0.0f),
+        Tint(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f),
+    };
+    clusterStyles[2].distortion = 1.0f;
+
+    for (size_t k = 0; k < std::size(ClusterOffsets); k++) {
+        EntityDesc cube;
+        for (int axis = 0; axis < 3; axis++) {
+            cube.position[axis] = ClusterOffsets[k][axis] * ClusterScale;
+            cube.scale[axis] = ClusterScale;
+        }
+        // Distort moves each vertex up to 0.7 per axis
+        cube.radius = clusterStyles[k].distortion ? 3.0f : 1.8f;
+        cube.mesh = cubes;
+        cube.pso = static_cast<uint32_t>(PSOType::GRAPHICS);
+        cube.style = clusterStyles[k];
+        m_cluster.push_back(m_storage.Create(cube));
+    }
+
+    // Drawn in clip space, never culled
+    EntityDesc overlay;
+    overlay.radius = std::numeric_limits<float>::infinity();
+    overlay.mesh = ui;
+    overlay.pso = static_cast<uint32_t>(PSOType::UI);
+    m_storage.Create(overlay);
+
+    m_bvhStale = true;
 }
 
 void Scene::OnExit()
 {
-    m_resourceFactory.UnloadMesh(m_meshHandle);
-    m_resourceFactory.UnloadMesh(m_uiHandle);
+    m_drawList.Clear();
+    m_packetHandles.clear();
+    m_lodChains.clear();
+    m_drawItems.clear();
+    m_cluster.clear();
+    m_visible.clear();
+    m_wasVisible.clear();
+    m_storage.Clear();
+    m_bvhStale = true;
+
+    for (auto mesh : m_meshes) {
+        m_resourceFactory.UnloadMesh(mesh);
+    }
+    m_meshes.clear();
 }
 
 void Scene::Update(const timer::Tick& tick)
 {
     m_camera->Prepare(tick);
 
-    XMStoreFloat4x4(
-        &m_shaderConstants.viewProjection,
-        XMMatrixTranspose(m_camera->CameraViewProjection())
-    );
+    m_previousTime = m_currentTime;
+    m_currentTime = tick.totalTime;
+}
 
-    XMMATRIX M = XMMatrixScaling(0.1f, 0.1f, 0.1f) * XMMatrixTranslation(0.0f, 0.0f, 0.0f);
-    XMStoreFloat4x4(&m_shaderConstants.model, XMMatrixTranspose(M));
+void Scene::Interpolate(double alpha)
+{
+    XMMATRIX viewProjection = m_camera->CameraViewProjection(static_cast<float>(alpha));
+
+    XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(&m_viewProjection), viewProjection);
+    m_frustum = FrustumFromMatrix(m_viewProjection.m);
+    m_lodView = m_camera->LodViewpoint(static_cast<float>(alpha));
+
+    XMStoreFloat4x4(&m_shaderConstants.viewProjection, XMMatrixTranspose(viewProjection));
 
-    double pitch = XM_2PI * std::fmod(tick.totalTime, 1.0);
+    double time = m_previousTime + (m_currentTime - m_previousTime) * alpha;
+    m_shaderConstants.time = static_cast<float>(time);
 
-    XMStoreFloat4x4(
-        &m_shaderConstants.modelRotated,
-        XMMatrixTranspose(M * XMMatrixRotationRollPitchYaw(0.0, pitch, 0.0))
-    );
-    m_shaderConstants.time = static_cast<float>(tick.totalTime);
+    // The cluster is a function of time alone, so it is posed at the rendered time
+    // rather than the last step, as Triangle_VS did before it moved to the CPU
+    AnimateCluster(time);
+    m_storage.UpdateTransforms();
+    UpdateBvh();
 }
 
-inline DrawItem BaseDrawItem(MeshViews meshViews, SubmeshRange submesh)
+inline DrawPass PassOf(PSOType psoType)
+{
+    switch (psoType) {
+    case PSOType::UI:
+        return DrawPass::OVERLAY;
+    default:
+        return DrawPass::SOLID;
+    }
+}
+
+std::span<const DrawItem> Scene::MakeDrawItems()
+{
+    static_assert(sizeof(Matrix4) == sizeof(XMFLOAT4X4));
+
+    // Mesh or PSO changed
+    for (uint32_t slot : m_storage.DirtySlots()) {
+        RegisterDraws(m_storage.IndexOfSlot(slot));
+    }
+    m_storage.ClearDirty();
+
+    if (m_bvhStale) UpdateBvh();
+
+    m_visible.resize(m_storage.Size());
+    size_t visibleCount = m_bvh.Cull(m_frustum, m_storage.Bounds(), m_visible.data());
+    m_visible.resize(visibleCount);
+
+    // Occluders in view hide what is behind them
+    uint8_t* flags = m_storage.Flags();
+    const Matrix4* world = m_storage.World();
+    const uint32_t* meshes = m_storage.Meshes();
+
+    m_occlusion.Begin(m_viewProjection);
+    for (uint32_t i : m_visible) {
+        if (!(flags[i] & ENTITY_OCCLUDER)) continue;
+        if (const OccluderMesh* occluder = m_resourceFactory.GetOccluderMesh(meshes[i])) m_occlusion.AddOccluder(*occluder, world[i]);
+    }
+    if (m_occlusion.HasOccluders()) {
+        m_occlusion.Rasterize();
+        m_visible.resize(m_occlusion.Cull(m_storage.Bounds(), m_visible.data(), m_visible.size()));
+    }
+
+    // Entering or leaving view; the BVH returns no particular order, so the
+    // culled entities are marked instead of merging sorted lists
+    for (uint32_t i : m_visible) {
+        flags[i] |= ENTITY_CULLED;
+        if (!(flags[i] & ENTITY_VISIBLE)) SetDrawsVisible(i, true);
+    }
+    for (uint32_t i : m_wasVisible) {
+        if (!(flags[i] & ENTITY_CULLED)) SetDrawsVisible(i, false);
+    }
+    for (uint32_t i : m_visible) {
+        flags[i] &= ~ENTITY_CULLED;
+    }
+
+    std::swap(m_visible, m_wasVisible);
+
+    // Levels of detail of what is in view; a switch rebuilds the entity's packets
+    LodInputs lodInputs{m_storage.Bounds(), m_storage.LocalRadii(), meshes, m_lodChains};
+    if (m_lodSelector.Select(m_lodView, lodInputs, m_wasVisible.data(), m_wasVisible.size(), m_storage.Lods())) {
+        for (uint32_t i : m_lodSelector.Switched()) {
+            RegisterDraws(i);
+        }
+    }
+
+    // One draw per mesh part and pipeline, instances front to back
+    auto packets = m_drawList.Visible();
+    auto owners = m_drawList.VisibleOwners();
+
+    // Distance in front of the near plane stands in for view depth
+    const Plane& nearPlane = m_frustum.planes[Frustum::NEAR_Z];
+    auto viewDepth = [&](uint32_t i) {
+        const float* position = world[i].m[3];
+        return nearPlane.a * position[0] + nearPlane.b * position[1] + nearPlane.c * position[2] + nearPlane.d;
+    };
+
+    m_batchKeys.resize(packets.size());
+    m_packetEntities.resize(packets.size());
+
+    for (size_t p = 0; p < packets.size(); p++) {
+        uint32_t i = m_storage.IndexOfSlot(owners[p]);
+        m_batchKeys[p] = BatchKey(packets[p].psoType, meshes[i], packets[p].submesh, viewDepth(i));
+        m_packetEntities[p] = i;
+    }
+
+    m_batcher.Build(m_batchKeys.data(), packets.size(), SortKey::DepthBits);
+
+    auto order = m_batcher.Order();
+    m_instanceEntities.resize(order.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        m_instanceEntities[k] = m_packetEntities[order[k]];
+    }
+
+    InstanceAllocation instances = m_rendererServices.AllocateInstances(order.size());
+    PackInstances(m_instanceEntities.data(), order.size(), world, m_storage.Styles(), instances.data);
+
+    D3D12_GPU_VIRTUAL_ADDRESS constants = m_rendererServices.WritePerDrawCB(m_shaderConstants);
+
+    // Each batch is drawn as its nearest packet, which the batch key put first
+    m_drawItems.clear();
+    for (const InstanceBatch& batch : m_batcher.Batches()) {
+        DrawItem di = packets[batch.item];
+        uint32_t i = m_packetEntities[batch.item];
+
+        di.sortKey = SortKey::Make(PassOf(di.psoType), 0, static_cast<uint32_t>(di.psoType), meshes[i], viewDepth(i));
+        di.instanceCount = batch.instanceCount;
+        di.instances = instances.address + batch.firstInstance * sizeof(InstanceData);
+        if (di.psoType == PSOType::GRAPHICS) di.vsCB = constants;
+
+        m_drawItems.push_back(di);
+    }
+
+    return m_drawItems;
+}
+
+// MARK: - Private
+
+void Scene::AnimateCluster(double time)
+{
+    if (m_cluster.size() != std::size(ClusterOffsets)) return;
+
+    float t = static_cast<float>(time);
+
+    Float3 shake = ShakeOffset(t);
+    const float* shaken = ClusterOffsets[1];
+    m_storage.SetPosition(m_cluster[1], (shaken[0] + shake.x) * ClusterScale, (shaken[1] + shake.y) * ClusterScale, (shaken[2] + shake.z) * ClusterScale);
+
+    InstanceStyle pulse = Tint(0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.5f - std::fmod(t, 1.5f) * 0.5f);
+    m_storage.SetStyle(m_cluster[1], pulse);
+
+    float spin = XM_2PI * static_cast<float>(std::fmod(time, 1.0));
+    m_storage.SetRotation(m_cluster[3], 0.0f, std::sin(spin * 0.5f), 0.0f, std::cos(spin * 0.5f));
+
+    // Radius 8 at 2 rad/s
+    m_storage.SetPosition(m_cluster[6], std::cos(t * 2.0f) * 8.0f * ClusterScale, 0.0f, std::sin(t * 2.0f) * 8.0f * ClusterScale);
+}
+
+void Scene::UpdateBvh()
+{
+    SphereBoundsSoA bounds = m_storage.Bounds();
+
+    if (!m_bvhStale) {
+        m_bvh.Refit(bounds, m_storage.Changed());
+        if (!m_bvh.NeedsRebuild()) return;
+    }
+
+    m_bvh.Build(bounds);
+    m_bvhStale = false;
+}
+
+inline DrawItem BaseDrawItem(const MeshViews& meshViews, const SubmeshRange& submesh)
 {
     DrawItem di{};
 
@@ -59,35 +324,84 @@ inline DrawItem BaseDrawItem(MeshViews meshViews, SubmeshRange submesh)
     di.ibv = meshViews.ibv;
     di.topology = submesh.topology;
     di.countPerInstance = submesh.indexCount;
+    di.startIndex = submesh.startIndex;
+    di.baseVertex = submesh.baseVertex;
 
     return di;
 }
 
-std::vector<DrawItem> Scene::MakeDrawItems()
+// (Re)builds the packets of entity `index` from the parts of its current level
+void Scene::RegisterDraws(size_t index)
 {
-    std::vector<DrawItem> drawItems;
+    MeshHandle mesh = m_storage.Meshes()[index];
+    const MeshViews& meshViews = m_resourceFactory.GetMeshViews(mesh);
+    DrawRange& range = m_storage.Draws()[index];
+    uint8_t& flags = m_storage.Flags()[index];
 
-    auto graphics = m_resourceFactory.GetMeshViews(m_meshHandle);
+    if (mesh >= m_lodChains.size()) m_lodChains.resize(mesh + 1, nullptr);
+    m_lodChains[mesh] = meshViews.lods.empty() ? nullptr : &meshViews.lodChain;
 
-    for (auto submesh : graphics.parts) {
-        DrawItem di = BaseDrawItem(graphics, submesh);
-        di.vsCB = m_rendererServices.WritePerDrawCB(m_shaderConstants);
-        di.psoType = PSOType::GRAPHICS;
-        di.instanceCount = 7;
+    std::span<const SubmeshRange> parts = meshViews.parts;
+    uint32_t mostParts = static_cast<uint32_t>(parts.size());
 
-        drawItems.push_back(di);
+    if (!meshViews.lods.empty()) {
+        uint8_t& lod = m_storage.Lods()[index];
+        lod = static_cast<uint8_t>(std::min<size_t>(lod, meshViews.lods.size() - 1));
+
+        const MeshLod& level = meshViews.lods[lod];
+        parts = parts.subspan(level.firstPart, level.partCount);
+
+        mostParts = 0;
+        for (const MeshLod& other : meshViews.lods) {
+            mostParts = std::max(mostParts, other.partCount);
+        }
     }
 
-    // graphics.srv = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvHeap->GetGPUDescriptorHandleForHeapStart(), 0, m_srvDescriptorSize);
+    size_t firstPart = parts.data() - meshViews.parts.data();
+    auto makeDrawItem = [&](uint32_t k) {
+        DrawItem di = BaseDrawItem(meshViews, parts[k]);
+        di.psoType = static_cast<PSOType>(m_storage.Psos()[index]);
+        di.submesh = static_cast<UINT>(firstPart + k);
+        return di;
+    };
 
-    auto ui = m_resourceFactory.GetMeshViews(m_uiHandle);
+    if (range.count == parts.size()) {
+        for (uint32_t k = 0; k < range.count; k++) {
+            m_drawList.Update(m_packetHandles[range.first + k], makeDrawItem(k));
+        }
+    }
+    else {
+        for (uint32_t k = 0; k < range.count; k++) {
+            m_drawList.Remove(m_packetHandles[range.first + k]);
+        }
 
-    for (auto submesh : ui.parts) {
-        DrawItem di = BaseDrawItem(ui, submesh);
-        di.psoType = PSOType::UI;
+        // Room for the largest level; an outgrown range stays behind unused in m_packetHandles
+        if (parts.size() > range.capacity) {
+            range.first = static_cast<uint32_t>(m_packetHandles.size());
+            range.capacity = mostParts;
+            m_packetHandles.resize(range.first + range.capacity);
+        }
+        range.count = static_cast<uint32_t>(parts.size());
 
-        drawItems.push_back(di);
+        for (uint32_t k = 0; k < range.count; k++) {
+            m_packetHandles[range.first + k] = m_drawList.Add(makeDrawItem(k), m_storage.Slots()[index], flags & ENTITY_VISIBLE);
+        }
     }
+}
+
+void Scene::SetDrawsVisible(size_t index, bool visible)
+{
+    const DrawRange& range = m_storage.Draws()[index];
+    uint8_t& flags = m_storage.Flags()[index];
 
-    return drawItems;
-}
\ No newline at end of file
+    if (visible) {
+        flags |= ENTITY_VISIBLE;
+    }
+    else {
+        flags &= ~ENTITY_VISIBLE;
+    }
+
+    for (uint32_t k = 0; k < range.count; k++) {
+        m_drawList.SetVisible(m_packetHandles[range.first + k], visible);
+    }
+}
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "../pch.h"
+#include "Bvh.h"
+#include "Culling.h"
 #include "DrawItem.h"
+#include "DrawList.h"
+#include "InstanceBatcher.h"
+#include "LodSelector.h"
 #include "Models.h"
+#include "OcclusionCuller.h"
+#include "SceneStorage.h"
 #include <memory>
+#include <span>
 #include <vector>
 
 // Forward declarations
@@ -31,11 +39,23 @@ struct SubmeshRange
     D3D_PRIMITIVE_TOPOLOGY topology{D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST};
 };
 
+// A run of MeshViews::parts drawn for one level of detail
+struct MeshLod
+{
+    uint32_t firstPart = 0;
+    uint32_t partCount = 0;
+};
+
 struct MeshViews
 {
     D3D12_VERTEX_BUFFER_VIEW vbv{};
     D3D12_INDEX_BUFFER_VIEW ibv{};
+    // Parts of every level, back to back
     std::vector<SubmeshRange> parts;
+    // Finest first, at most LodChain::MaxLods; empty means all parts are one level
+    std::vector<MeshLod> lods;
+    // Geometric error and triangles of each entry of `lods`
+    LodChain lodChain;
 };
 
 enum class MeshDesc
@@ -50,7 +70,17 @@ public:
     virtual ~ResourceFactory() = default;
     virtual MeshHandle LoadMesh(const MeshDesc&) = 0;
     virtual void UnloadMesh(MeshHandle) = 0;
-    virtual MeshViews GetMeshViews(MeshHandle) = 0;
+    // Valid until the mesh is unloaded
+    virtual const MeshViews& GetMeshViews(MeshHandle) = 0;
+    // CPU copy for occlusion culling, nullptr when the mesh has none
+    virtual const OccluderMesh* GetOccluderMesh(MeshHandle) = 0;
+};
+
+// Instance buffer space of the current frame
+struct InstanceAllocation
+{
+    InstanceData* data = nullptr; // write-only upload memory
+    D3D12_GPU_VIRTUAL_ADDRESS address{};
 };
 
 class RendererServices
@@ -58,6 +88,8 @@ class RendererServices
 public:
     virtual ~RendererServices() = default;
     virtual D3D12_GPU_VIRTUAL_ADDRESS WritePerDrawCB(const ShaderConstants& data) = 0;
+    // Room for `count` instances, valid until the frame is presented
+    virtual InstanceAllocation AllocateInstances(size_t count) = 0;
 };
 
 class Scene final
@@ -73,13 +105,62 @@ public:
     void OnEnter();
     void OnExit();
 
+    // Advances the simulation by one fixed step
     void Update(const timer::Tick& tick);
-    std::vector<DrawItem> MakeDrawItems();
+    // Blends the last two steps into the render state, `alpha` from timer::Tick, and
+    // poses the animated entities at that time
+    void Interpolate(double alpha);
+    // Patches the retained draw list and returns its visible packets batched into
+    // instanced draws, valid until the next call
+    std::span<const DrawItem> MakeDrawItems();
+
+    // Occlusion culling work of the last MakeDrawItems
+    const OcclusionStats& GetOcclusionStats() const noexcept { return m_occlusion.Stats(); }
+    // Level of detail selection of the last MakeDrawItems
+    const LodStats& GetLodStats() const noexcept { return m_lodSelector.Stats(); }
+    // Instances packed by the last MakeDrawItems
+    size_t GetInstanceCount() const noexcept { return m_batcher.Order().size(); }
 
 private:
+    // Refits the tree to what moved in the last step, rebuilding it when stale
+    void UpdateBvh();
+    // Moves and tints the cluster around the origin, what Triangle_VS used to do per instance ID
+    void AnimateCluster(double time);
+    void RegisterDraws(size_t index);
+    void SetDrawsVisible(size_t index, bool visible);
+
+    // Shared by every draw; per-entity data goes into the instance buffer
     ShaderConstants m_shaderConstants;
-    MeshHandle m_meshHandle;
-    MeshHandle m_uiHandle;
+    Matrix4 m_viewProjection{};
+    Frustum m_frustum{};
+    double m_previousTime = 0.0;
+    double m_currentTime = 0.0;
+
+    SceneStorage m_storage;
+    std::vector<MeshHandle> m_meshes;
+    std::vector<Entity> m_cluster;
+    // Indexed by dense entity index, so rebuilt whenever entities come or go
+    Bvh m_bvh;
+    bool m_bvhStale = true;
+    OcclusionCuller m_occlusion;
+    LodSelector m_lodSelector;
+    LodView m_lodView{};
+    // Indexed by MeshHandle, filled as entities register their draws
+    std::vector<const LodChain*> m_lodChains;
+    // Culled entity indices of this and the previous frame
+    std::vector<uint32_t> m_visible;
+    std::vector<uint32_t> m_wasVisible;
+
+    // Packets owned by entity slot; each entity's DrawRange points into m_packetHandles
+    DrawList<DrawItem> m_drawList;
+    std::vector<DrawList<DrawItem>::Handle> m_packetHandles;
+
+    // Visible packets grouped into one draw per mesh part and pipeline
+    InstanceBatcher m_batcher;
+    std::vector<uint64_t> m_batchKeys;
+    std::vector<uint32_t> m_packetEntities; // dense entity index per visible packet
+    std::vector<uint32_t> m_instanceEntities; // the same, in instance order
+    std::vector<DrawItem> m_drawItems;
 
     std::unique_ptr<Camera> m_camera;
 
@@ -0,0 +1,411 @@
+#include "SceneStorage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "../common/JobSystem.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define YANG_SCENE_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace canvas;
+
+// MARK: - Entities
+
+Entity SceneStorage::Create(const EntityDesc& desc)
+{
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(m_index.size());
+        m_index.push_back(0);
+        m_generation.push_back(0);
+    }
+
+    m_index[slot] = static_cast<uint32_t>(m_owner.size());
+
+    m_positionX.push_back(desc.position[0]);
+    m_positionY.push_back(desc.position[1]);
+    m_positionZ.push_back(desc.position[2]);
+    m_rotationX.push_back(desc.rotation[0]);
+    m_rotationY.push_back(desc.rotation[1]);
+    m_rotationZ.push_back(desc.rotation[2]);
+    m_rotationW.push_back(desc.rotation[3]);
+    m_scaleX.push_back(desc.scale[0]);
+    m_scaleY.push_back(desc.scale[1]);
+    m_scaleZ.push_back(desc.scale[2]);
+    m_localRadius.push_back(desc.radius);
+
+    m_local.push_back({});
+    m_world.push_back({});
+    m_node.push_back(TransformHierarchy::None);
+    m_boundsX.push_back(0.0f);
+    m_boundsY.push_back(0.0f);
+    m_boundsZ.push_back(0.0f);
+    m_boundsRadius.push_back(0.0f);
+
+    m_mesh.push_back(desc.mesh);
+    m_pso.push_back(desc.pso);
+    m_style.push_back(desc.style);
+    m_lod.push_back(0);
+    m_draws.push_back({});
+    m_flags.push_back(desc.occluder ? ENTITY_OCCLUDER : 0);
+    m_owner.push_back(slot);
+
+    uint32_t index = m_index[slot];
+    MarkDirty(index);
+
+    // Valid before the first UpdateTransforms; a root's world matrix is its local one
+    BuildLocals(index, index + 1);
+    m_world[index] = m_local[index];
+    UpdateBounds(index);
+    m_node[index] = m_hierarchy.Add(TransformHierarchy::None, m_local[index], slot);
+
+    return {slot, m_generation[slot]};
+}
+
+void SceneStorage::Destroy(Entity entity) noexcept
+{
+    if (!IsAlive(entity)) return;
+
+    uint32_t index = m_index[entity.slot];
+    uint32_t last = static_cast<uint32_t>(m_owner.size() - 1);
+
+    if (m_flags[index] & ENTITY_DIRTY) {
+        m_dirtySlots.erase(std::find(m_dirtySlots.begin(), m_dirtySlots.end(), entity.slot));
+    }
+    if (m_flags[index] & ENTITY_MOVED) {
+        m_movedSlots.erase(std::find(m_movedSlots.begin(), m_movedSlots.end(), entity.slot));
+    }
+
+    m_hierarchy.Remove(m_node[index]);
+
+    // Move the last entity into the hole
+    ForEachArray([&](auto& array) {
+        array[index] = array[last];
+        array.pop_back();
+    });
+
+    if (index != last) m_index[m_owner[index]] = index;
+
+    m_generation[entity.slot]++;
+    m_freeSlots.push_back(entity.slot);
+}
+
+void SceneStorage::Clear() noexcept
+{
+    for (uint32_t slot : m_owner) {
+        m_generation[slot]++;
+        m_freeSlots.push_back(slot);
+    }
+
+    ForEachArray([](auto& array) { array.clear(); });
+    m_dirtySlots.clear();
+    m_movedSlots.clear();
+    m_changed.clear();
+    m_hierarchy.Clear();
+}
+
+bool SceneStorage::IsAlive(Entity entity) const noexcept
+{
+    return entity.slot < m_generation.size() && m_generation[entity.slot] == entity.generation;
+}
+
+uint32_t SceneStorage::IndexOf(Entity entity) const noexcept
+{
+    assert(IsAlive(entity));
+    return m_index[entity.slot];
+}
+
+void SceneStorage::SetPosition(Entity entity, float x, float y, float z)
+{
+    uint32_t i = IndexOf(entity);
+    m_positionX[i] = x;
+    m_positionY[i] = y;
+    m_positionZ[i] = z;
+    MarkMoved(i);
+}
+
+void SceneStorage::SetRotation(Entity entity, float x, float y, float z, float w)
+{
+    uint32_t i = IndexOf(entity);
+    m_rotationX[i] = x;
+    m_rotationY[i] = y;
+    m_rotationZ[i] = z;
+    m_rotationW[i] = w;
+    MarkMoved(i);
+}
+
+void SceneStorage::SetScale(Entity entity, float x, float y, float z)
+{
+    uint32_t i = IndexOf(entity);
+    m_scaleX[i] = x;
+    m_scaleY[i] = y;
+    m_scaleZ[i] = z;
+    MarkMoved(i);
+}
+
+void SceneStorage::SetMesh(Entity entity, uint32_t mesh)
+{
+    uint32_t i = IndexOf(entity);
+    m_mesh[i] = mesh;
+    m_lod[i] = 0;
+    MarkDirty(i);
+}
+
+void SceneStorage::SetPso(Entity entity, uint32_t pso)
+{
+    uint32_t i = IndexOf(entity);
+    m_pso[i] = pso;
+    MarkDirty(i);
+}
+
+void SceneStorage::SetStyle(Entity entity, const InstanceStyle& style) noexcept
+{
+    m_style[IndexOf(entity)] = style;
+}
+
+void SceneStorage::SetParent(Entity child, Entity parent)
+{
+    TransformHierarchy::Node parentNode = IsAlive(parent) ? m_node[IndexOf(parent)] : TransformHierarchy::None;
+    m_hierarchy.SetParent(m_node[IndexOf(child)], parentNode);
+}
+
+void SceneStorage::MarkMoved(uint32_t index)
+{
+    if (m_flags[index] & ENTITY_MOVED) return;
+
+    m_flags[index] |= ENTITY_MOVED;
+    m_movedSlots.push_back(m_owner[index]);
+}
+
+void SceneStorage::ClearDirty() noexcept
+{
+    for (uint32_t slot : m_dirtySlots) {
+        m_flags[m_index[slot]] &= ~ENTITY_DIRTY;
+    }
+    m_dirtySlots.clear();
+}
+
+// MARK: - Transforms
+
+void SceneStorage::UpdateTransforms(unsigned threads)
+{
+    size_t count = Size();
+    size_t moved = m_movedSlots.size();
+
+    // With most of the scene moving, one contiguous pass beats picking entities out
+    if (moved > 0 && moved * 4 >= count) {
+        if (count < ParallelThreshold || threads == 1) {
+            BuildLocals(0, count);
+        }
+        else {
+            // Whole blocks of 4, so only the last range has a scalar tail
+            size_t blocks = (count + 3) / 4;
+            jobs::Shared().ParallelFor(blocks, ParallelThreshold / 16, [this, count](size_t first, size_t last) {
+                BuildLocals(first * 4, std::min(last * 4, count));
+            }, threads);
+        }
+    }
+    else {
+        for (uint32_t slot : m_movedSlots) {
+            uint32_t i = m_index[slot];
+            BuildLocals(i, i + 1);
+        }
+    }
+
+    for (uint32_t slot : m_movedSlots) {
+        uint32_t i = m_index[slot];
+        m_hierarchy.SetLocal(m_node[i], m_local[i]);
+        m_flags[i] &= ~ENTITY_MOVED;
+    }
+    m_movedSlots.clear();
+
+    // Moved entities and everything below them
+    m_hierarchy.Update();
+    m_changed.clear();
+    for (TransformHierarchy::Node node : m_hierarchy.Changed()) {
+        uint32_t i = m_index[m_hierarchy.Owner(node)];
+        m_world[i] = m_hierarchy.World(node);
+        UpdateBounds(i);
+        m_changed.push_back(i);
+    }
+}
+
+// Local = scale * rotation * translation, the XMMatrixAffineTransformation order
+void SceneStorage::BuildLocals(size_t first, size_t last) noexcept
+{
+    last = std::min(last, Size());
+    size_t i = first;
+
+#ifdef YANG_SCENE_X86
+    // 4 entities per iteration: build each matrix element for all 4 lanes, then
+    // transpose lanes into rows
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= last; i += 4) {
+        __m128 x = _mm_loadu_ps(&m_rotationX[i]);
+        __m128 y = _mm_loadu_ps(&m_rotationY[i]);
+        __m128 z = _mm_loadu_ps(&m_rotationZ[i]);
+        __m128 w = _mm_loadu_ps(&m_rotationW[i]);
+
+        __m128 x2 = _mm_add_ps(x, x);
+        __m128 y2 = _mm_add_ps(y, y);
+        __m128 z2 = _mm_add_ps(z, z);
+
+        __m128 xx = _mm_mul_ps(x, x2);
+        __m128 yy = _mm_mul_ps(y, y2);
+        __m128 zz = _mm_mul_ps(z, z2);
+        __m128 xy = _mm_mul_ps(x, y2);
+        __m128 xz = _mm_mul_ps(x, z2);
+        __m128 yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2);
+        __m128 wy = _mm_mul_ps(w, y2);
+        __m128 wz = _mm_mul_ps(w, z2);
+
+        __m128 sx = _mm_loadu_ps(&m_scaleX[i]);
+        __m128 sy = _mm_loadu_ps(&m_scaleY[i]);
+        __m128 sz = _mm_loadu_ps(&m_scaleZ[i]);
+
+        __m128 r0[4] = {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+            _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+            _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+            zero,
+        };
+        __m128 r1[4] = {
+            _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+            _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+            zero,
+        };
+        __m128 r2[4] = {
+            _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+            _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+            zero,
+        };
+
+        __m128 px = _mm_loadu_ps(&m_positionX[i]);
+        __m128 py = _mm_loadu_ps(&m_positionY[i]);
+        __m128 pz = _mm_loadu_ps(&m_positionZ[i]);
+        __m128 r3[4] = {px, py, pz, one};
+
+        _MM_TRANSPOSE4_PS(r0[0], r0[1], r0[2], r0[3]);
+        _MM_TRANSPOSE4_PS(r1[0], r1[1], r1[2], r1[3]);
+        _MM_TRANSPOSE4_PS(r2[0], r2[1], r2[2], r2[3]);
+        _MM_TRANSPOSE4_PS(r3[0], r3[1], r3[2], r3[3]);
+
+        for (int lane = 0; lane < 4; lane++) {
+            float(&m)[4][4] = m_local[i + lane].m;
+            _mm_storeu_ps(m[0], r0[lane]);
+            _mm_storeu_ps(m[1], r1[lane]);
+            _mm_storeu_ps(m[2], r2[lane]);
+            _mm_storeu_ps(m[3], r3[lane]);
+        }
+    }
+#endif
+
+    for (; i < last; i++) {
+        float x = m_rotationX[i], y = m_rotationY[i], z = m_rotationZ[i], w = m_rotationW[i];
+        float sx = m_scaleX[i], sy = m_scaleY[i], sz = m_scaleZ[i];
+
+        float xx = 2.0f * x * x, yy = 2.0f * y * y, zz = 2.0f * z * z;
+        float xy = 2.0f * x * y, xz = 2.0f * x * z, yz = 2.0f * y * z;
+        float wx = 2.0f * w * x, wy = 2.0f * w * y, wz = 2.0f * w * z;
+
+        m_local[i] = {{
+            {(1.0f - yy - zz) * sx, (xy + wz) * sx, (xz - wy) * sx, 0.0f},
+            {(xy - wz) * sy, (1.0f - xx - zz) * sy, (yz + wx) * sy, 0.0f},
+            {(xz + wy) * sz, (yz - wx) * sz, (1.0f - xx - yy) * sz, 0.0f},
+            {m_positionX[i], m_positionY[i], m_positionZ[i], 1.0f},
+        }};
+    }
+}
+
+// The bounding sphere follows the origin and grows with the longest world axis
+void SceneStorage::UpdateBounds(size_t i) noexcept
+{
+    const float(&m)[4][4] = m_world[i].m;
+
+    float axis = 0.0f;
+    for (int r = 0; r < 3; r++) {
+        axis = std::max(axis, m[r][0] * m[r][0] + m[r][1] * m[r][1] + m[r][2] * m[r][2]);
+    }
+
+    m_boundsX[i] = m[3][0];
+    m_boundsY[i] = m[3][1];
+    m_boundsZ[i] = m[3][2];
+    m_boundsRadius[i] = m_localRadius[i] * std::sqrt(axis);
+}
+
+// MARK: - Components
+
+TransformArrays SceneStorage::Transforms() noexcept
+{
+    return {
+        m_positionX.data(),
+        m_positionY.data(),
+        m_positionZ.data(),
+        m_rotationX.data(),
+        m_rotationY.data(),
+        m_rotationZ.data(),
+        m_rotationW.data(),
+        m_scaleX.data(),
+        m_scaleY.data(),
+        m_scaleZ.data(),
+        Size(),
+    };
+}
+
+SphereBoundsSoA SceneStorage::Bounds() const noexcept
+{
+    return {m_boundsX.data(), m_boundsY.data(), m_boundsZ.data(), m_boundsRadius.data(), Size()};
+}
+
+// MARK: - Private
+
+void SceneStorage::MarkDirty(uint32_t index)
+{
+    if (m_flags[index] & ENTITY_DIRTY) return;
+
+    m_flags[index] |= ENTITY_DIRTY;
+    m_dirtySlots.push_back(m_owner[index]);
+}
+
+template <typename Fn>
+void SceneStorage::ForEachArray(Fn&& fn)
+{
+    fn(m_positionX);
+    fn(m_positionY);
+    fn(m_positionZ);
+    fn(m_rotationX);
+    fn(m_rotationY);
+    fn(m_rotationZ);
+    fn(m_rotationW);
+    fn(m_scaleX);
+    fn(m_scaleY);
+    fn(m_scaleZ);
+    fn(m_localRadius);
+    fn(m_local);
+    fn(m_world);
+    fn(m_node);
+    fn(m_boundsX);
+    fn(m_boundsY);
+    fn(m_boundsZ);
+    fn(m_boundsRadius);
+    fn(m_mesh);
+    fn(m_pso);
+    fn(m_style);
+    fn(m_lod);
+    fn(m_draws);
+    fn(m_flags);
+    fn(m_owner);
+}
@@ -0,0 +1,185 @@
+//
+// SceneStorage.h - Entities with their components in packed arrays
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Culling.h"
+#include "InstanceBatcher.h"
+#include "TransformHierarchy.h"
+
+namespace canvas
+{
+
+// Slot in the handle table plus the generation it was created in, so a handle to a
+// destroyed entity never aliases whoever reuses the slot
+struct Entity
+{
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+struct EntityDesc
+{
+    float position[3] = {0.0f, 0.0f, 0.0f};
+    float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // unit quaternion x, y, z, w
+    float scale[3] = {1.0f, 1.0f, 1.0f};
+    float radius = 1.0f; // model-space bounding sphere around the origin
+
+    uint32_t mesh = 0;   // MeshHandle
+    uint32_t pso = 0;    // PSOType
+    InstanceStyle style;
+    bool occluder = false; // rasterized for occlusion culling, needs an OccluderMesh
+};
+
+// Range of a caller-owned handle array holding an entity's draw packets
+struct DrawRange
+{
+    uint32_t first = 0;
+    uint32_t count = 0;
+    uint32_t capacity = 0; // handles reserved at `first`, so LOD switches stay in place
+};
+
+// Per-entity state bits for the draw list
+enum EntityFlags : uint8_t
+{
+    ENTITY_VISIBLE = 1 << 0, // packets are in the visible part of the draw list
+    ENTITY_DIRTY = 1 << 1,   // mesh or PSO changed, packets need rebuilding
+    ENTITY_MOVED = 1 << 2,   // position, rotation or scale changed since UpdateTransforms
+    ENTITY_CULLED = 1 << 3,  // scratch mark: passed this frame's culling
+    ENTITY_OCCLUDER = 1 << 4,
+};
+
+// Mutable views over the transform components, index i is the i-th live entity
+struct TransformArrays
+{
+    float* positionX;
+    float* positionY;
+    float* positionZ;
+    float* rotationX;
+    float* rotationY;
+    float* rotationZ;
+    float* rotationW;
+    float* scaleX;
+    float* scaleY;
+    float* scaleZ;
+    size_t count;
+};
+
+// Live entities are kept dense: components sit in parallel arrays at the same index
+// and destroying an entity moves the last one into its place. Handles go through a
+// slot table, so they stay valid while indices shift. Each entity is a node in a
+// TransformHierarchy, so world matrices are only recomputed for what moved.
+class SceneStorage final
+{
+public:
+    // Below this many entities a bulk UpdateTransforms stays on the calling thread
+    static constexpr size_t ParallelThreshold = 16384;
+
+    // Disallow copy / assign
+    SceneStorage(const SceneStorage&) = delete;
+    SceneStorage& operator=(const SceneStorage&) = delete;
+
+    SceneStorage() = default;
+
+    Entity Create(const EntityDesc&);
+    void Destroy(Entity) noexcept;
+    void Clear() noexcept;
+
+    bool IsAlive(Entity) const noexcept;
+    // Dense index of a live entity, valid until the next Destroy
+    uint32_t IndexOf(Entity) const noexcept;
+    uint32_t IndexOfSlot(uint32_t slot) const noexcept { return m_index[slot]; }
+    size_t Size() const noexcept { return m_owner.size(); }
+
+    void SetPosition(Entity, float x, float y, float z);
+    void SetRotation(Entity, float x, float y, float z, float w);
+    void SetScale(Entity, float x, float y, float z);
+    // Both mark the entity dirty; a new mesh starts at its finest level
+    void SetMesh(Entity, uint32_t mesh);
+    void SetPso(Entity, uint32_t pso);
+    // Read straight into the instance buffer every frame, no rebuild needed
+    void SetStyle(Entity, const InstanceStyle&) noexcept;
+
+    // Attaches `child` under `parent`, or makes it a root for an invalid parent.
+    // Position / rotation / scale become relative to the parent.
+    void SetParent(Entity child, Entity parent);
+    // For edits made straight through Transforms(); the setters call it themselves
+    void MarkMoved(uint32_t index);
+
+    // Rebuilds local matrices of the moved entities, then world matrices and
+    // world-space bounds of those and their descendants. Many moved entities are
+    // built in bulk, as up to `threads` jobs on the shared job system (0 = as many
+    // as it splits into).
+    void UpdateTransforms(unsigned threads = 0);
+    // Dense indices whose world matrix and bounds the last UpdateTransforms rewrote,
+    // valid until the next Create or Destroy
+    std::span<const uint32_t> Changed() const noexcept { return m_changed; }
+
+    // MARK: - Components
+
+    TransformArrays Transforms() noexcept;
+
+    const Matrix4* World() const noexcept { return m_world.data(); }
+    SphereBoundsSoA Bounds() const noexcept;
+    const uint32_t* Meshes() const noexcept { return m_mesh.data(); }
+    const uint32_t* Psos() const noexcept { return m_pso.data(); }
+    const InstanceStyle* Styles() const noexcept { return m_style.data(); }
+    const float* LocalRadii() const noexcept { return m_localRadius.data(); }
+    // Level of detail the packets are built from, see LodSelector
+    uint8_t* Lods() noexcept { return m_lod.data(); }
+    // Slot of each entity, the stable key to map back from draw packets
+    const uint32_t* Slots() const noexcept { return m_owner.data(); }
+
+    DrawRange* Draws() noexcept { return m_draws.data(); }
+    uint8_t* Flags() noexcept { return m_flags.data(); }
+
+    // Slots of the entities created or given a new mesh / PSO since the last ClearDirty
+    std::span<const uint32_t> DirtySlots() const noexcept { return m_dirtySlots; }
+    void ClearDirty() noexcept;
+
+private:
+    void MarkDirty(uint32_t index);
+    // Local matrices of the dense range [first, last), safe on disjoint ranges in parallel
+    void BuildLocals(size_t first, size_t last) noexcept;
+    void UpdateBounds(size_t index) noexcept;
+
+    template <typename Fn>
+    void ForEachArray(Fn&& fn);
+
+    // Dense, one element per live entity
+    std::vector<float> m_positionX, m_positionY, m_positionZ;
+    std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+    std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+    std::vector<float> m_localRadius;
+
+    std::vector<Matrix4> m_local;
+    std::vector<Matrix4> m_world;
+    std::vector<TransformHierarchy::Node> m_node;
+    std::vector<float> m_boundsX, m_boundsY, m_boundsZ, m_boundsRadius;
+
+    std::vector<uint32_t> m_mesh;
+    std::vector<uint32_t> m_pso;
+    std::vector<InstanceStyle> m_style;
+    std::vector<uint8_t> m_lod;
+    std::vector<DrawRange> m_draws;
+    std::vector<uint8_t> m_flags;
+    std::vector<uint32_t> m_owner; // slot
+
+    // Per slot
+    std::vector<uint32_t> m_index;
+    std::vector<uint32_t> m_generation;
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<uint32_t> m_dirtySlots;
+    std::vector<uint32_t> m_movedSlots;
+    std::vector<uint32_t> m_changed;
+
+    TransformHierarchy m_hierarchy;
+};
+
+} // namespace canvas
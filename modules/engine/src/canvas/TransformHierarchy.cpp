@@ -0,0 +1,282 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "CanvasUtil.h"
+
+using namespace canvas;
+
+namespace
+{
+constexpr uint32_t None = TransformHierarchy::None;
+
+// Update sweeps the whole tree once more than 1 / SweepRatio of the nodes are dirty
+constexpr size_t SweepRatio = 8;
+} // namespace
+
+TransformHierarchy::Node TransformHierarchy::Add(Node parent, const Matrix4& local, uint32_t owner)
+{
+    Node node;
+    if (!m_freeNodes.empty()) {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    else {
+        node = static_cast<Node>(m_position.size());
+        m_position.push_back(None);
+        m_parentNode.push_back(None);
+        m_owner.push_back(0);
+    }
+
+    m_parentNode[node] = parent;
+    m_owner[node] = owner;
+
+    // Placed at the end; only a root in a flat hierarchy is already where Relayout
+    // would put it
+    uint32_t position = static_cast<uint32_t>(m_nodes.size());
+    m_position[node] = position;
+
+    m_local.push_back(local);
+    m_world.push_back(local);
+    m_parent.push_back(None);
+    m_firstChild.push_back(0);
+    m_childCount.push_back(0);
+    m_depth.push_back(0);
+    m_dirty.push_back(0);
+    m_nodes.push_back(node);
+
+    if (parent != None || m_levels.size() > 1) {
+        m_layoutDirty = true;
+        return node;
+    }
+
+    if (m_levels.empty()) m_levels.resize(1);
+    MarkDirty(position);
+    return node;
+}
+
+void TransformHierarchy::Remove(Node node)
+{
+    assert(m_position[node] != None);
+
+    Node parent = m_parentNode[node];
+    if (!m_layoutDirty) {
+        uint32_t position = m_position[node];
+        for (uint32_t c = m_firstChild[position]; c < m_firstChild[position] + m_childCount[position]; c++) {
+            m_parentNode[m_nodes[c]] = parent;
+        }
+    }
+    else {
+        // Child ranges are stale, look the children up by parent link
+        for (Node child = 0; child < m_parentNode.size(); child++) {
+            if (m_position[child] != None && m_parentNode[child] == node) m_parentNode[child] = parent;
+        }
+    }
+
+    // The stale entry stays in the arrays until Relayout drops it
+    m_position[node] = None;
+    m_parentNode[node] = None;
+    m_freeNodes.push_back(node);
+    m_layoutDirty = true;
+}
+
+void TransformHierarchy::Clear() noexcept
+{
+    m_local.clear();
+    m_world.clear();
+    m_parent.clear();
+    m_firstChild.clear();
+    m_childCount.clear();
+    m_depth.clear();
+    m_dirty.clear();
+    m_nodes.clear();
+
+    m_position.clear();
+    m_parentNode.clear();
+    m_owner.clear();
+    m_freeNodes.clear();
+
+    m_levels.clear();
+    m_changed.clear();
+    m_layoutDirty = false;
+}
+
+void TransformHierarchy::SetParent(Node node, Node parent)
+{
+    if (m_parentNode[node] == parent) return;
+
+#ifndef NDEBUG
+    for (Node ancestor = parent; ancestor != None; ancestor = m_parentNode[ancestor]) {
+        assert(ancestor != node && "SetParent would create a cycle");
+    }
+#endif
+
+    m_parentNode[node] = parent;
+    m_layoutDirty = true;
+}
+
+void TransformHierarchy::SetLocal(Node node, const Matrix4& local)
+{
+    uint32_t position = m_position[node];
+    m_local[position] = local;
+    MarkDirty(position);
+}
+
+void TransformHierarchy::Update()
+{
+    m_changed.clear();
+
+    if (m_layoutDirty) {
+        Relayout();
+
+        // Parents precede children, one pass in order settles everything
+        for (uint32_t p = 0; p < m_nodes.size(); p++) {
+            if (m_parent[p] == None) {
+                m_world[p] = m_local[p];
+            }
+            else {
+                Multiply(m_local[p], m_world[m_parent[p]], m_world[p]);
+            }
+        }
+
+        m_changed.assign(m_nodes.begin(), m_nodes.end());
+        return;
+    }
+
+    size_t queued = 0;
+    for (const auto& dirty : m_levels)
+        queued += dirty.size();
+
+    // With a large share of the nodes moved, most of the tree is dirty anyway and
+    // one pass in order is cheaper than chasing the worklists
+    if (queued * SweepRatio >= m_nodes.size()) {
+        for (uint32_t p = 0; p < m_nodes.size(); p++) {
+            if (m_parent[p] == None) {
+                if (!m_dirty[p]) continue;
+                m_world[p] = m_local[p];
+            }
+            else {
+                if (!m_dirty[p] && !m_dirty[m_parent[p]]) continue;
+                m_dirty[p] = 1;
+                Multiply(m_local[p], m_world[m_parent[p]], m_world[p]);
+            }
+            m_changed.push_back(m_nodes[p]);
+        }
+
+        std::fill(m_dirty.begin(), m_dirty.end(), uint8_t(0));
+        for (auto& dirty : m_levels)
+            dirty.clear();
+        return;
+    }
+
+    // Each depth only reads world matrices of the one above, finished already
+    for (size_t depth = 0; depth < m_levels.size(); depth++) {
+        auto& dirty = m_levels[depth];
+
+        for (uint32_t p : dirty) {
+            if (m_parent[p] == None) {
+                m_world[p] = m_local[p];
+            }
+            else {
+                Multiply(m_local[p], m_world[m_parent[p]], m_world[p]);
+            }
+
+            for (uint32_t c = m_firstChild[p]; c < m_firstChild[p] + m_childCount[p]; c++) {
+                MarkDirty(c);
+            }
+
+            m_dirty[p] = 0;
+            m_changed.push_back(m_nodes[p]);
+        }
+
+        dirty.clear();
+    }
+}
+
+// MARK: - Private
+
+void TransformHierarchy::MarkDirty(uint32_t position)
+{
+    // Relayout recomputes everything anyway
+    if (m_layoutDirty || m_dirty[position]) return;
+
+    m_dirty[position] = 1;
+    assert(m_depth[position] < m_levels.size());
+    m_levels[m_depth[position]].push_back(position);
+}
+
+// Rebuilds the breadth-first order from the parent links
+void TransformHierarchy::Relayout()
+{
+    size_t nodeCount = m_position.size();
+
+    // Children of every node, grouped by a counting sort on the parent
+    std::vector<uint32_t> childStart(nodeCount + 1, 0);
+    std::vector<Node> roots;
+    for (Node node = 0; node < nodeCount; node++) {
+        if (m_position[node] == None) continue;
+
+        if (m_parentNode[node] == None) {
+            roots.push_back(node);
+        }
+        else {
+            childStart[m_parentNode[node] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < nodeCount; i++) {
+        childStart[i + 1] += childStart[i];
+    }
+
+    std::vector<Node> children(childStart[nodeCount]);
+    std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+    for (Node node = 0; node < nodeCount; node++) {
+        if (m_position[node] != None && m_parentNode[node] != None) children[fill[m_parentNode[node]]++] = node;
+    }
+
+    // Breadth-first order; appending each node's children keeps them contiguous
+    size_t liveCount = nodeCount - m_freeNodes.size();
+    std::vector<Node> order = std::move(roots);
+    order.reserve(liveCount);
+
+    std::vector<Matrix4> local(order.size());
+    std::vector<uint32_t> parent(order.size(), None);
+    std::vector<uint16_t> depth(order.size(), 0);
+    std::vector<uint32_t> firstChild, childCount;
+    local.reserve(liveCount);
+    parent.reserve(liveCount);
+    depth.reserve(liveCount);
+    firstChild.reserve(liveCount);
+    childCount.reserve(liveCount);
+
+    for (size_t i = 0; i < order.size(); i++) {
+        Node node = order[i];
+        local[i] = m_local[m_position[node]];
+
+        firstChild.push_back(static_cast<uint32_t>(order.size()));
+        childCount.push_back(childStart[node + 1] - childStart[node]);
+
+        for (uint32_t c = childStart[node]; c < childStart[node + 1]; c++) {
+            order.push_back(children[c]);
+            local.push_back({});
+            parent.push_back(static_cast<uint32_t>(i));
+            depth.push_back(static_cast<uint16_t>(depth[i] + 1));
+        }
+    }
+
+    for (uint32_t p = 0; p < order.size(); p++) {
+        m_position[order[p]] = p;
+    }
+
+    m_local = std::move(local);
+    m_world.resize(order.size());
+    m_parent = std::move(parent);
+    m_firstChild = std::move(firstChild);
+    m_childCount = std::move(childCount);
+    m_depth = std::move(depth);
+    m_dirty.assign(order.size(), 0);
+    m_nodes = std::move(order);
+
+    m_levels.assign(m_nodes.empty() ? 0 : m_depth.back() + 1, {});
+    m_layoutDirty = false;
+}
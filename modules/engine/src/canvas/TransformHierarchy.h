@@ -0,0 +1,91 @@
+//
+// TransformHierarchy.h - Parent / child transforms with incremental world updates
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace canvas
+{
+
+// Row-major, row vectors; same layout as DirectX::XMFLOAT4X4
+struct Matrix4
+{
+    float m[4][4];
+};
+
+// Nodes are laid out breadth-first: every depth is one contiguous range and the
+// children of a node are contiguous in the next one. SetLocal marks a node dirty;
+// Update walks the depths top down, recomputing world = local * parent world for
+// the dirty nodes only and dirtying their children on the way, so its cost follows
+// the number of moved nodes and their descendants rather than the scene size.
+//
+// Structural edits (SetParent, Remove, adding a child) re-lay the arrays out on the
+// next Update and recompute every world matrix. Adding roots to a flat hierarchy
+// appends in place.
+class TransformHierarchy final
+{
+public:
+    using Node = uint32_t;
+    static constexpr Node None = UINT32_MAX;
+
+    // Disallow copy / assign
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    TransformHierarchy() = default;
+
+    // `owner` is handed back through Owner() to map changed nodes to their objects
+    Node Add(Node parent, const Matrix4& local, uint32_t owner);
+    // Children move up to the removed node's parent
+    void Remove(Node);
+    void Clear() noexcept;
+
+    // `parent` = None makes the node a root; must not be the node or a descendant
+    void SetParent(Node, Node parent);
+    void SetLocal(Node, const Matrix4& local);
+
+    // Brings every dirty world matrix up to date
+    void Update();
+
+    Node GetParent(Node node) const noexcept { return m_parentNode[node]; }
+    uint32_t Owner(Node node) const noexcept { return m_owner[node]; }
+    const Matrix4& World(Node node) const noexcept { return m_world[m_position[node]]; }
+    const Matrix4& Local(Node node) const noexcept { return m_local[m_position[node]]; }
+
+    // Nodes whose world matrix the last Update rewrote
+    std::span<const Node> Changed() const noexcept { return m_changed; }
+    size_t Size() const noexcept { return m_nodes.size(); }
+    size_t Depth() const noexcept { return m_levels.size(); }
+
+private:
+    void MarkDirty(uint32_t position);
+    void Relayout();
+
+    // Per position, breadth-first
+    std::vector<Matrix4> m_local;
+    std::vector<Matrix4> m_world;
+    std::vector<uint32_t> m_parent;     // position, None for roots
+    std::vector<uint32_t> m_firstChild; // position
+    std::vector<uint32_t> m_childCount;
+    std::vector<uint16_t> m_depth;
+    std::vector<uint8_t> m_dirty;
+    std::vector<Node> m_nodes;
+
+    // Per node
+    std::vector<uint32_t> m_position;
+    std::vector<Node> m_parentNode;
+    std::vector<uint32_t> m_owner;
+    std::vector<Node> m_freeNodes;
+
+    // Dirty positions per depth, drained by Update
+    std::vector<std::vector<uint32_t>> m_levels;
+    std::vector<Node> m_changed;
+    bool m_layoutDirty = false;
+};
+
+} // namespace canvas
@@ -6,6 +6,8 @@
 
 #include "AsyncLogger.h"
 
+// std::cout fallback for code that does not log through YANG_LOG. Each thread
+// accumulates its own line until '\n' or a flush, so lines never interleave.
 struct AsyncBuf : std::streambuf
 {
     explicit AsyncBuf(AsyncLogger& L) :
@@ -13,16 +15,26 @@ struct AsyncBuf : std::streambuf
     {
     }
 
-    // буфер для накопления до \n
-    std::string buf;
-
     int overflow(int ch) override
     {
         if (ch == traits_type::eof()) return 0;
-        buf.push_back(static_cast<char>(ch));
+
+        if (ch == '\n')
+            flush_();
+        else
+            line().push_back(static_cast<char>(ch));
+
         return ch;
     }
 
+    std::streamsize xsputn(const char* s, std::streamsize count) override
+    {
+        for (std::streamsize i = 0; i < count; i++) {
+            overflow(traits_type::to_int_type(s[i]));
+        }
+        return count;
+    }
+
     int sync() override
     {
         flush_();
@@ -30,12 +42,20 @@ struct AsyncBuf : std::streambuf
     }
 
 private:
+    // буфер для накопления до \n, свой у каждого потока
+    static std::string& line()
+    {
+        thread_local std::string buf;
+        return buf;
+    }
+
     void flush_()
     {
+        auto& buf = line();
         if (!buf.empty()) {
-            logger.log(std::move(buf));
+            logger.log(buf);
             buf.clear();
         }
     }
     AsyncLogger& logger;
-};
\ No newline at end of file
+};
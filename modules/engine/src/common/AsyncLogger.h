@@ -1,13 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
-#include <string>
+#include <string_view>
 #include <thread>
 
+#include "FlightRecorder.h"
+#include "LogChannel.h"
+#include "LogFormat.h"
+#include "LogSink.h"
+#include "MappedFileSink.h"
+#include "MpscRing.h"
+
 class AsyncLogger
 {
 public:
@@ -20,58 +30,78 @@ public:
         ERROR
     };
 
+    // What a producer does when the ring is full
+    enum class OverflowPolicy
+    {
+        BLOCK,        // wait for the worker to free a slot
+        DROP_NEWEST,  // discard the record being logged
+        DROP_OLDEST   // discard the oldest queued record
+    };
+
+    struct Config
+    {
+        size_t capacity = 4096; // slots, power of two
+        OverflowPolicy overflow = OverflowPolicy::BLOCK;
+        size_t batchSize = 64;                     // wake the worker once this many records are queued
+        std::chrono::milliseconds flushInterval{20}; // ... or after this long
+        logging::DurabilityPolicy durability{};
+        bool mapped = false; // write through logging::MappedFileSink instead
+        logging::RotationPolicy rotation{};
+    };
+
+    // Fixed-size slot, longer lines are truncated
+    struct Record
+    {
+        static constexpr size_t MaxLength = 232;
+
+        uint64_t timestamp = 0; // logging::Now() at enqueue
+        LogLevel level = DEBUG;
+        uint16_t length = 0;
+        logging::Channel channel = logging::Channel::GENERAL;
+        char text[MaxLength];
+    };
+
     AsyncLogger() :
+        AsyncLogger(Config{})
+    {
+    }
+
+    explicit AsyncLogger(Config config) :
+        config(config),
+        ring(config.capacity),
         done(false)
     {
         worker = std::thread([this] {
-            std::filesystem::create_directories("logs");
-
-            HANDLE h = CreateFileW(
-                L"logs\\engine.log",
-                GENERIC_WRITE,
-                FILE_SHARE_READ | FILE_SHARE_WRITE,
-                nullptr,
-                CREATE_ALWAYS,
-                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
-                nullptr
-            );
-            assert(h != INVALID_HANDLE_VALUE);
-
-            auto write_line = [&](std::string_view s) {
-                DWORD written = 0;
-                WriteFile(h, s.data(), static_cast<DWORD>(s.size()), &written, nullptr);
-                static const char nl = '\n';
-                WriteFile(h, &nl, 1, &written, nullptr);
-                FlushFileBuffers(h); // гарантируем, что OS сразу выкинет на диск
+            auto sink = makeSink(std::filesystem::path("logs") / "engine.log");
+
+            logging::RecordFormatter formatter;
+
+            auto write_record = [&](const Record& record) {
+                auto line = formatter.Format(
+                    record.timestamp,
+                    levelToString(record.level),
+                    logging::ChannelName(record.channel),
+                    std::string_view(record.text, record.length)
+                );
+                sink->Append(line, record.level == ERROR);
             };
 
             std::unique_lock<std::mutex> lk(mu);
             for (;;) {
-                cv.wait(lk, [this]{ return done || !q.empty(); });
-                while (!q.empty()) {
-                    // Create timestamp
-                    time_t now = time(0);
-                    tm timeinfo;
-                    localtime_s(&timeinfo, &now);
-                    char timestamp[20];
-                    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
-
-                    // Create log entry
-                    std::ostringstream logEntry;
-
-                    logEntry
-                        << "[" << std::string(timestamp) << "] "
-                        << levelToString(LogLevel::DEBUG) << ": "
-                        << std::move(q.front()); q.pop();
-
-                    auto message = logEntry.str();
-
-                    lk.unlock();
-                    write_line(message);
-                    lk.lock();
-                }
-                if (done && q.empty()) break;
-            } });
+                // Producers only signal on batch boundaries; the timeout bounds the latency
+                // of a partial batch and covers a notify that raced with this wait.
+                cv.wait_for(lk, this->config.flushInterval, [this] {
+                    return done || ring.Size() >= this->config.batchSize;
+                });
+
+                lk.unlock();
+                ring.Drain(write_record);
+                sink->Commit(); // one write per batch
+                lk.lock();
+
+                if (done && ring.Size() == 0) break;
+            }
+        });
     }
 
     ~AsyncLogger()
@@ -82,18 +112,71 @@ public:
         }
         cv.notify_all();
         if (worker.joinable()) worker.join();
-        fout.close();
     }
 
-    void log(std::string s)
+    void log(
+        std::string_view s,
+        LogLevel level = DEBUG,
+        logging::Channel channel = logging::Channel::GENERAL
+    )
     {
-        std::lock_guard<std::mutex> lk(mu);
-        q.push(std::move(s));
-        cv.notify_one();
+        size_t position = 0;
+        Record* record = begin(level, channel, &position);
+        if (!record) return;
+
+        record->length = static_cast<uint16_t>(std::min(s.size(), Record::MaxLength));
+        memcpy(record->text, s.data(), record->length);
+        commit(record, position);
+    }
+
+    // Zero-copy path: claims a slot for the caller to fill `text`/`length` in place.
+    // Returns nullptr when the overflow policy dropped the record.
+    Record* begin(LogLevel level, logging::Channel channel, size_t* position)
+    {
+        auto timestamp = logging::Now();
+
+        Record* record = claim(position);
+        if (!record) return nullptr;
+
+        record->timestamp = timestamp;
+        record->level = level;
+        record->channel = channel;
+        record->length = 0;
+        return record;
+    }
+
+    void commit(Record* record, size_t position)
+    {
+        // Copy before publishing: once the worker releases the slot it can be reused
+        logging::FlightRecorder::Record(
+            record->timestamp,
+            static_cast<uint8_t>(record->level),
+            record->channel,
+            std::string_view(record->text, record->length)
+        );
+
+        ring.Publish(record);
+
+        // Exactly one producer crosses each batch boundary, so the worker gets one
+        // wakeup per batch instead of one per line.
+        if ((position + 1) % config.batchSize == 0)
+            cv.notify_one();
+    }
+
+    // Number of records lost to the overflow policy
+    uint64_t dropped() const noexcept
+    {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+    // Records queued but not yet written, i.e. how far the worker lags behind
+    size_t pending() const noexcept
+    {
+        return ring.Size();
     }
 
     // Converts log level to a string for output
-    std::string levelToString(LogLevel level)
+    static constexpr std::string_view levelToString(LogLevel level)
     {
         switch (level) {
         case DEBUG:
@@ -110,10 +193,42 @@ public:
     }
 
 private:
-    std::ofstream fout;
-    std::queue<std::string> q;
+    std::unique_ptr<logging::Sink> makeSink(const std::filesystem::path& path) const
+    {
+        if (config.mapped)
+            return std::make_unique<logging::MappedFileSink>(path, config.rotation, config.durability);
+
+        return std::make_unique<logging::FileSink>(path, config.durability);
+    }
+
+    Record* claim(size_t* position)
+    {
+        for (;;) {
+            if (Record* record = ring.TryClaim(position))
+                return record;
+
+            switch (config.overflow) {
+            case OverflowPolicy::BLOCK:
+                cv.notify_one();
+                std::this_thread::yield();
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            case OverflowPolicy::DROP_OLDEST:
+                if (ring.DiscardOldest())
+                    droppedCount.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    const Config config;
+    MpscRing<Record> ring;
+    std::atomic<uint64_t> droppedCount{0};
+
     std::mutex mu;
     std::condition_variable cv;
     std::thread worker;
     std::atomic<bool> done;
-};
\ No newline at end of file
+};
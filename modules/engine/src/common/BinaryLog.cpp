@@ -0,0 +1,175 @@
+#include "BinaryLog.h"
+
+#include "LogSink.h"
+
+using namespace logging;
+
+namespace
+{
+// Rewrites a record's fixed-width integers as varints, leaves everything else as is.
+// Returns the end of `out`, which must hold MaxArgs * 2 bytes more than the payload.
+uint8_t* PackPayload(const ArgType* types, size_t argc, const uint8_t* payload, uint8_t* out) noexcept
+{
+    auto load = [&payload](auto value) {
+        memcpy(&value, payload, sizeof(value));
+        payload += sizeof(value);
+        return value;
+    };
+
+    for (size_t i = 0; i < argc; i++) {
+        switch (types[i]) {
+        case ArgType::I32:
+            out = PutVarint(out, ZigZag(load(int32_t{})));
+            break;
+        case ArgType::U32:
+            out = PutVarint(out, load(uint32_t{}));
+            break;
+        case ArgType::I64:
+            out = PutVarint(out, ZigZag(load(int64_t{})));
+            break;
+        case ArgType::U64:
+            out = PutVarint(out, load(uint64_t{}));
+            break;
+        case ArgType::STR: {
+            size_t length = 1 + payload[0];
+            memcpy(out, payload, length);
+            payload += length;
+            out += length;
+            break;
+        }
+        default: {
+            size_t size = ArgSize(types[i]);
+            memcpy(out, payload, size);
+            payload += size;
+            out += size;
+            break;
+        }
+        }
+    }
+    return out;
+}
+} // namespace
+
+BinaryLog::BinaryLog(const std::filesystem::path& path, size_t capacity) :
+    m_ring(capacity)
+{
+    m_worker = std::thread([this, path] { Run(path); });
+}
+
+BinaryLog::~BinaryLog() noexcept
+{
+    if (Current() == this)
+        SetCurrent(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_done = true;
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+// MARK: - Private
+
+uint16_t BinaryLog::Register(BinarySite& site, const ArgType* types, size_t argc) noexcept
+{
+    std::lock_guard<std::mutex> lk(m_registerMutex);
+
+    // Another thread may have registered the site while we waited
+    auto key = site.key.load(std::memory_order_relaxed);
+    if ((key >> 16) == m_generation)
+        return static_cast<uint16_t>(key);
+
+    auto index = m_descriptorCount.load(std::memory_order_relaxed);
+    if (index == MaxSites) return 0;
+
+    Descriptor& descriptor = m_descriptors[index];
+    descriptor.format = site.format;
+    descriptor.level = site.level;
+    descriptor.argc = static_cast<uint8_t>(argc);
+    std::copy(types, types + argc, descriptor.types);
+
+    m_descriptorCount.store(index + 1, std::memory_order_release);
+
+    auto id = static_cast<uint16_t>(index + 1);
+    site.key.store(m_generation << 16 | id, std::memory_order_release);
+    return id;
+}
+
+void BinaryLog::Run(const std::filesystem::path& path)
+{
+    FileSink sink(path);
+
+    BinaryFileHeader header{};
+    memcpy(header.magic, BinaryFileHeader::Magic, sizeof(header.magic));
+    header.version = BinaryFileHeader::CurrentVersion;
+    header.anchorWall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()
+    )
+                            .count();
+    header.anchorSteady = Now();
+    sink.Append({reinterpret_cast<const char*>(&header), sizeof(header)});
+
+    size_t emitted = 0;
+
+    auto append = [&](const auto& value) {
+        sink.Append({reinterpret_cast<const char*>(&value), sizeof(value)});
+    };
+
+    // Descriptors are registered before any record that uses them is published,
+    // so catching up here always puts a descriptor ahead of its first record.
+    auto emit_descriptors = [&] {
+        auto count = m_descriptorCount.load(std::memory_order_acquire);
+        for (; emitted < count; emitted++) {
+            const Descriptor& descriptor = m_descriptors[emitted];
+            auto id = static_cast<uint16_t>(emitted + 1);
+            auto length = static_cast<uint16_t>(strlen(descriptor.format));
+
+            append(BinaryEntry::DESCRIPTOR);
+            append(id);
+            append(descriptor.level);
+            append(descriptor.argc);
+            sink.Append({reinterpret_cast<const char*>(descriptor.types), descriptor.argc});
+            append(length);
+            sink.Append({descriptor.format, length});
+        }
+    };
+
+    uint64_t previous = header.anchorSteady;
+
+    auto write_record = [&](const Record& record) {
+        if (record.id == 0) return;
+        if (record.id > emitted) emit_descriptors();
+
+        uint8_t payload[Record::PayloadSize + MaxArgs * 2];
+        const Descriptor& descriptor = m_descriptors[record.id - 1];
+        size_t size = PackPayload(descriptor.types, descriptor.argc, record.payload, payload) - payload;
+
+        // Producers race to the ring, so a record may be a little older than the last
+        uint8_t entry[1 + 3 * MaxVarintSize + sizeof(payload)];
+        uint8_t* out = entry;
+        *out++ = static_cast<uint8_t>(BinaryEntry::RECORD);
+        out = PutVarint(out, record.id);
+        out = PutVarint(out, ZigZag(static_cast<int64_t>(record.timestamp - previous)));
+        out = PutVarint(out, size);
+        memcpy(out, payload, size);
+        out += size;
+        previous = record.timestamp;
+
+        sink.Append({reinterpret_cast<const char*>(entry), static_cast<size_t>(out - entry)});
+    };
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (;;) {
+        m_cv.wait_for(lk, std::chrono::milliseconds(50), [this] {
+            return m_done || m_ring.Size() >= BatchSize;
+        });
+
+        lk.unlock();
+        m_ring.Drain(write_record);
+        sink.Commit();
+        lk.lock();
+
+        if (m_done && m_ring.Size() == 0) break;
+    }
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "AsyncLogger.h"
+#include "LogFormat.h"
+#include "MpscRing.h"
+
+namespace logging
+{
+
+// MARK: - File layout
+//
+// BinaryFileHeader, then a stream of entries, each starting with a BinaryEntry tag:
+//   DESCRIPTOR: u16 id, u8 level, u8 argc, argc x ArgType, u16 length, format bytes
+//   RECORD:     varint id, varint timestamp delta, varint size, size payload bytes
+// The timestamp delta is zigzagged and taken from the previous record, or from
+// anchorSteady for the first. Arguments are packed in call order: integers as varints
+// (signed ones zigzagged), floats and bools as is, strings as u8 length + bytes.
+
+enum class ArgType : uint8_t
+{
+    I32,
+    U32,
+    I64,
+    U64,
+    F32,
+    F64,
+    BOOL,
+    STR
+};
+
+enum class BinaryEntry : uint8_t
+{
+    DESCRIPTOR = 'D',
+    RECORD = 'R'
+};
+
+struct BinaryFileHeader
+{
+    static constexpr char Magic[4] = {'Y', 'B', 'L', 'G'};
+    static constexpr uint32_t CurrentVersion = 2;
+
+    char magic[4];
+    uint32_t version;
+    int64_t anchorWall;    // ns since the Unix epoch ...
+    uint64_t anchorSteady; // ... at this logging::Now() value
+};
+
+// One per call site, declared static by YANG_BLOG and registered on first use.
+struct BinarySite
+{
+    const char* format;
+    uint8_t level;
+    // Generation of the BinaryLog that registered the site above, its id below; a
+    // log installed later finds another generation and registers the site again
+    std::atomic<uint64_t> key{0};
+};
+
+// MARK: - Varints
+
+// LEB128: 7 bits per byte, low bits first, the top bit set on all but the last byte
+constexpr size_t MaxVarintSize = 10;
+
+constexpr uint64_t ZigZag(int64_t value) noexcept
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int64_t UnZigZag(uint64_t value) noexcept
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline uint8_t* PutVarint(uint8_t* out, uint64_t value) noexcept
+{
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+// MARK: - Argument encoding
+
+template <typename T>
+constexpr ArgType ArgTypeOf() noexcept
+{
+    using U = std::remove_cvref_t<T>;
+
+    if constexpr (std::is_same_v<U, bool>)
+        return ArgType::BOOL;
+    else if constexpr (std::is_enum_v<U>)
+        return ArgTypeOf<std::underlying_type_t<U>>();
+    else if constexpr (std::is_integral_v<U>)
+        return sizeof(U) <= 4 ? (std::is_signed_v<U> ? ArgType::I32 : ArgType::U32)
+                              : (std::is_signed_v<U> ? ArgType::I64 : ArgType::U64);
+    else if constexpr (std::is_same_v<U, float>)
+        return ArgType::F32;
+    else if constexpr (std::is_same_v<U, double>)
+        return ArgType::F64;
+    else {
+        static_assert(std::is_convertible_v<U, std::string_view>, "unsupported binary log argument");
+        return ArgType::STR;
+    }
+}
+
+constexpr size_t ArgSize(ArgType type) noexcept
+{
+    switch (type) {
+    case ArgType::I32:
+    case ArgType::U32:
+    case ArgType::F32:
+        return 4;
+    case ArgType::I64:
+    case ArgType::U64:
+    case ArgType::F64:
+        return 8;
+    case ArgType::BOOL:
+        return 1;
+    case ArgType::STR:
+        return 0; // variable
+    }
+    return 0;
+}
+
+// Appends one argument at its fixed width, returns false when it does not fit. The
+// worker turns the integers into varints, off the calling thread.
+template <typename T>
+inline bool EncodeArg(uint8_t*& out, const uint8_t* end, const T& value) noexcept
+{
+    constexpr ArgType type = ArgTypeOf<T>();
+
+    if constexpr (type == ArgType::STR) {
+        std::string_view s = value;
+        size_t length = std::min<size_t>(s.size(), UINT8_MAX);
+        if (out + 1 + length > end) return false;
+
+        *out++ = static_cast<uint8_t>(length);
+        memcpy(out, s.data(), length);
+        out += length;
+    }
+    else {
+        using Stored = std::conditional_t<
+            type == ArgType::I32, int32_t,
+            std::conditional_t<
+                type == ArgType::U32, uint32_t,
+                std::conditional_t<
+                    type == ArgType::I64, int64_t,
+                    std::conditional_t<
+                        type == ArgType::U64, uint64_t,
+                        std::conditional_t<type == ArgType::BOOL, bool, std::remove_cvref_t<T>>>>>>;
+
+        if (out + sizeof(Stored) > end) return false;
+
+        auto stored = static_cast<Stored>(value);
+        memcpy(out, &stored, sizeof(Stored));
+        out += sizeof(Stored);
+    }
+    return true;
+}
+
+// MARK: - Logger
+
+// Deferred-formatting logger: the producer copies a site id, a timestamp and the raw
+// argument bytes into the ring; the worker packs them into varints on the way to disk
+// and the logdecode tool renders the text offline.
+class BinaryLog final
+{
+public:
+    static constexpr size_t MaxSites = 1024;
+    static constexpr size_t MaxArgs = 16;
+
+    struct Record
+    {
+        static constexpr size_t PayloadSize = 108;
+
+        uint64_t timestamp = 0;
+        uint16_t id = 0;
+        uint16_t size = 0;
+        uint8_t payload[PayloadSize];
+    };
+
+    // Disallow copy / assign
+    BinaryLog(const BinaryLog&) = delete;
+    BinaryLog& operator=(const BinaryLog&) = delete;
+
+    explicit BinaryLog(
+        const std::filesystem::path& path = std::filesystem::path("logs") / "engine.blog",
+        size_t capacity = 1 << 14
+    );
+    ~BinaryLog() noexcept;
+
+    // Process-wide instance used by YANG_BLOG, owned by the Engine
+    static BinaryLog* Current() noexcept { return s_current.load(std::memory_order_acquire); }
+    static void SetCurrent(BinaryLog* log) noexcept { s_current.store(log, std::memory_order_release); }
+
+    template <typename... Args>
+    void Write(BinarySite& site, const Args&... args) noexcept
+    {
+        static_assert(sizeof...(Args) <= MaxArgs, "too many binary log arguments");
+
+        auto key = site.key.load(std::memory_order_acquire);
+        auto id = (key >> 16) == m_generation ? static_cast<uint16_t>(key) : uint16_t(0);
+        if (id == 0) {
+            const ArgType types[] = {ArgTypeOf<Args>()..., ArgType::BOOL};
+            id = Register(site, types, sizeof...(Args));
+            if (id == 0) return;
+        }
+
+        auto timestamp = Now();
+
+        size_t position = 0;
+        Record* record = m_ring.TryClaim(&position);
+        if (!record) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        uint8_t* out = record->payload;
+        [[maybe_unused]] const uint8_t* end = record->payload + Record::PayloadSize;
+        bool fits = (EncodeArg(out, end, args) && ...);
+
+        record->timestamp = timestamp;
+        record->id = fits ? id : 0; // the worker skips records that did not fit
+        record->size = static_cast<uint16_t>(out - record->payload);
+        m_ring.Publish(record);
+
+        if (!fits)
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+        if ((position + 1) % BatchSize == 0)
+            m_cv.notify_one();
+    }
+
+    uint64_t Dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t BatchSize = 256;
+
+    struct Descriptor
+    {
+        const char* format;
+        uint8_t level;
+        uint8_t argc;
+        ArgType types[MaxArgs];
+    };
+
+    uint16_t Register(BinarySite&, const ArgType* types, size_t argc) noexcept;
+    void Run(const std::filesystem::path&);
+
+    static inline std::atomic<BinaryLog*> s_current{nullptr};
+    static inline std::atomic<uint64_t> s_generations{0};
+
+    // Unique per instance, unlike the address a later log may reuse
+    const uint64_t m_generation = s_generations.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    MpscRing<Record> m_ring;
+    std::atomic<uint64_t> m_dropped{0};
+
+    std::mutex m_registerMutex;
+    std::array<Descriptor, MaxSites> m_descriptors{};
+    std::atomic<size_t> m_descriptorCount{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_done{false};
+    std::thread m_worker;
+};
+
+} // namespace logging
+
+// Logs through the current BinaryLog, e.g. YANG_BLOG(DEBUG, "frame {} dt {}", frame, dt)
+#define YANG_BLOG(level, format, ...)                                           \
+    do {                                                                        \
+        if (auto* yangBinaryLog = logging::BinaryLog::Current()) {              \
+            static logging::BinarySite yangSite{format, AsyncLogger::level};    \
+            yangBinaryLog->Write(yangSite __VA_OPT__(, ) __VA_ARGS__);          \
+        }                                                                       \
+    } while (0)
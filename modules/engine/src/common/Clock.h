@@ -0,0 +1,111 @@
+//
+// Clock.h - Monotonic time sources for StepTimer
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace timer
+{
+// Raw monotonic counter. StepTimer only looks at differences between readings.
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    // Counter units per second
+    virtual uint64_t Frequency() const noexcept = 0;
+    virtual uint64_t Now() = 0;
+};
+
+#ifdef _WIN32
+// QueryPerformanceCounter, throws when the counter is unavailable.
+class QpcClock final : public Clock
+{
+public:
+    QpcClock() noexcept(false)
+    {
+        LARGE_INTEGER frequency;
+        if (!QueryPerformanceFrequency(&frequency)) {
+            throw std::exception();
+        }
+
+        m_frequency = static_cast<uint64_t>(frequency.QuadPart);
+    }
+
+    uint64_t Frequency() const noexcept override { return m_frequency; }
+
+    uint64_t Now() override
+    {
+        LARGE_INTEGER counter;
+        if (!QueryPerformanceCounter(&counter)) {
+            throw std::exception();
+        }
+
+        return static_cast<uint64_t>(counter.QuadPart);
+    }
+
+private:
+    uint64_t m_frequency = 0;
+};
+#endif
+
+// Nanoseconds from CLOCK_MONOTONIC_RAW where it exists (not slewed by NTP),
+// otherwise from std::chrono::steady_clock.
+class MonotonicClock final : public Clock
+{
+public:
+    uint64_t Frequency() const noexcept override { return 1000000000; }
+
+    uint64_t Now() noexcept override
+    {
+#ifdef CLOCK_MONOTONIC_RAW
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+#else
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            )
+                .count()
+        );
+#endif
+    }
+};
+
+// Only moves when told to, so a fixed-step simulation gets the same Tick sequence
+// on every run and can step as fast as the CPU allows.
+class VirtualClock final : public Clock
+{
+public:
+    uint64_t Frequency() const noexcept override { return 1000000000; }
+    uint64_t Now() noexcept override { return m_now; }
+
+    void Advance(std::chrono::nanoseconds delta) noexcept { m_now += static_cast<uint64_t>(delta.count()); }
+    void AdvanceSeconds(double seconds) noexcept { m_now += static_cast<uint64_t>(seconds * 1e9); }
+
+private:
+    uint64_t m_now = 0;
+};
+
+// QPC on Windows, MonotonicClock elsewhere
+inline Clock& DefaultClock()
+{
+#ifdef _WIN32
+    static QpcClock clock;
+#else
+    static MonotonicClock clock;
+#endif
+    return clock;
+}
+} // namespace timer
@@ -0,0 +1,306 @@
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+
+#include "AsyncLogger.h"
+#include "LogFormat.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+using namespace logging;
+
+namespace
+{
+
+constexpr size_t MaxPathLength = 260;
+
+struct Entry
+{
+    uint64_t timestamp;
+    uint8_t level;
+    Channel channel;
+    uint16_t length;
+    char text[FlightRecorder::TextLength];
+};
+
+struct ThreadRing
+{
+    std::atomic<uint64_t> head{0};
+    uint64_t threadId = 0;
+    Entry entries[FlightRecorder::RecordsPerThread];
+};
+
+struct FrameRing
+{
+    std::atomic<uint64_t> head{0};
+    FrameSummary frames[FlightRecorder::FrameCount];
+};
+
+// Static storage, so a crash never has to allocate to reach the rings
+alignas(64) ThreadRing s_threads[FlightRecorder::MaxThreads];
+std::atomic<size_t> s_threadCount{0};
+FrameRing s_frames;
+char s_dumpPath[MaxPathLength] = "logs/crash.flight";
+std::atomic<bool> s_dumping{false};
+
+thread_local ThreadRing* t_ring = nullptr;
+thread_local bool t_full = false;
+
+uint64_t CurrentThreadId() noexcept
+{
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#else
+    return static_cast<uint64_t>(pthread_self());
+#endif
+}
+
+// Buffered writer over a raw file, usable inside a signal handler
+class DumpWriter final
+{
+public:
+    explicit DumpWriter(const char* path) noexcept
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        m_file = file == INVALID_HANDLE_VALUE ? nullptr : file;
+#else
+        m_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    }
+
+    ~DumpWriter() noexcept
+    {
+        Flush();
+#ifdef _WIN32
+        if (m_file) {
+            FlushFileBuffers(m_file);
+            CloseHandle(m_file);
+        }
+#else
+        if (m_fd >= 0) {
+            fsync(m_fd);
+            close(m_fd);
+        }
+#endif
+    }
+
+    bool IsOpen() const noexcept
+    {
+#ifdef _WIN32
+        return m_file != nullptr;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+    DumpWriter& operator<<(std::string_view s) noexcept
+    {
+        while (!s.empty()) {
+            if (m_size == sizeof(m_buffer)) Flush();
+
+            size_t count = std::min(s.size(), sizeof(m_buffer) - m_size);
+            memcpy(m_buffer + m_size, s.data(), count);
+            m_size += count;
+            s.remove_prefix(count);
+        }
+        return *this;
+    }
+
+    DumpWriter& operator<<(uint64_t value) noexcept
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return *this << std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+    }
+
+    // Milliseconds with microsecond precision, e.g. "-12.345"
+    void Millis(int64_t ns) noexcept
+    {
+        if (ns < 0) {
+            *this << "-";
+            ns = -ns;
+        }
+
+        uint64_t micros = static_cast<uint64_t>(ns) / 1000;
+
+        char fraction[3];
+        for (int i = 2; i >= 0; i--) {
+            fraction[i] = static_cast<char>('0' + micros % 10);
+            micros /= 10;
+        }
+
+        *this << micros << "." << std::string_view(fraction, 3);
+    }
+
+private:
+    void Flush() noexcept
+    {
+        if (!IsOpen() || m_size == 0) return;
+
+#ifdef _WIN32
+        DWORD written = 0;
+        WriteFile(m_file, m_buffer, static_cast<DWORD>(m_size), &written, nullptr);
+#else
+        const char* data = m_buffer;
+        size_t left = m_size;
+        while (left > 0) {
+            ssize_t written = write(m_fd, data, left);
+            if (written <= 0) break;
+            data += written;
+            left -= static_cast<size_t>(written);
+        }
+#endif
+        m_size = 0;
+    }
+
+#ifdef _WIN32
+    void* m_file = nullptr; // HANDLE
+#else
+    int m_fd = -1;
+#endif
+    char m_buffer[4096];
+    size_t m_size = 0;
+};
+
+ThreadRing* CurrentRing() noexcept
+{
+    if (t_ring || t_full) return t_ring;
+
+    size_t index = s_threadCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= FlightRecorder::MaxThreads) {
+        t_full = true;
+        return nullptr;
+    }
+
+    t_ring = &s_threads[index];
+    t_ring->threadId = CurrentThreadId();
+    return t_ring;
+}
+
+#ifndef _WIN32
+alignas(16) char s_signalStack[64 * 1024];
+
+void OnCrashSignal(int signal)
+{
+    FlightRecorder::Dump();
+
+    // SA_RESETHAND restored the default action, let it terminate the process
+    raise(signal);
+}
+#endif
+
+} // namespace
+
+// MARK: - Recording
+
+void FlightRecorder::Record(uint64_t timestamp, uint8_t level, Channel channel, std::string_view text) noexcept
+{
+    ThreadRing* ring = CurrentRing();
+    if (!ring) return;
+
+    // Only the owning thread writes, so the head needs no read-modify-write
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Entry& entry = ring->entries[head % RecordsPerThread];
+
+    entry.timestamp = timestamp;
+    entry.level = level;
+    entry.channel = channel;
+    entry.length = static_cast<uint16_t>(std::min(text.size(), TextLength));
+    memcpy(entry.text, text.data(), entry.length);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void FlightRecorder::Frame(const FrameSummary& summary) noexcept
+{
+    uint64_t head = s_frames.head.load(std::memory_order_relaxed);
+    s_frames.frames[head % FrameCount] = summary;
+    s_frames.head.store(head + 1, std::memory_order_release);
+}
+
+// MARK: - Dump
+
+void FlightRecorder::SetDumpPath(const char* path) noexcept
+{
+    size_t length = std::min(strlen(path), MaxPathLength - 1);
+    memcpy(s_dumpPath, path, length);
+    s_dumpPath[length] = '\0';
+}
+
+bool FlightRecorder::Dump() noexcept
+{
+    // A second fault while dumping must not recurse
+    if (s_dumping.exchange(true)) return false;
+
+    DumpWriter out(s_dumpPath);
+    if (!out.IsOpen()) return false;
+
+    uint64_t now = Now();
+    out << "flight recorder, times in ms relative to the dump\n";
+
+    // Frames, oldest first
+    uint64_t frameHead = s_frames.head.load(std::memory_order_acquire);
+    uint64_t frameFirst = frameHead > FrameCount ? frameHead - FrameCount : 0;
+
+    out << "\nframes " << (frameHead - frameFirst) << "\n";
+    for (uint64_t i = frameFirst; i < frameHead; i++) {
+        const FrameSummary& frame = s_frames.frames[i % FrameCount];
+
+        out << "  #" << frame.frameIndex << " t=";
+        out.Millis(static_cast<int64_t>(frame.timestamp - now));
+        out << " frame=";
+        out.Millis(static_cast<int64_t>(frame.frameTime));
+        out << " draws=" << uint64_t(frame.drawCount);
+        out << " fence=" << frame.fenceSignaled << "/" << frame.fenceCompleted << "\n";
+    }
+
+    // Records per thread, oldest first
+    size_t threads = std::min(s_threadCount.load(std::memory_order_acquire), MaxThreads);
+    for (size_t t = 0; t < threads; t++) {
+        const ThreadRing& ring = s_threads[t];
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t first = head > RecordsPerThread ? head - RecordsPerThread : 0;
+
+        out << "\nthread " << ring.threadId << " records " << (head - first) << "\n";
+        for (uint64_t i = first; i < head; i++) {
+            const Entry& entry = ring.entries[i % RecordsPerThread];
+            auto level = static_cast<AsyncLogger::LogLevel>(entry.level);
+
+            out << "  t=";
+            out.Millis(static_cast<int64_t>(entry.timestamp - now));
+            out << " " << AsyncLogger::levelToString(level) << " [" << ChannelName(entry.channel) << "]: ";
+            out << std::string_view(entry.text, std::min<size_t>(entry.length, TextLength)) << "\n";
+        }
+    }
+
+    return true;
+}
+
+void FlightRecorder::InstallCrashHandler() noexcept
+{
+#ifndef _WIN32
+    // Run on a separate stack so a stack overflow can still be dumped
+    stack_t stack{};
+    stack.ss_sp = s_signalStack;
+    stack.ss_size = sizeof(s_signalStack);
+    sigaltstack(&stack, nullptr);
+
+    struct sigaction action{};
+    action.sa_handler = OnCrashSignal;
+    action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+
+    for (int signal : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT})
+        sigaction(signal, &action, nullptr);
+#endif
+}
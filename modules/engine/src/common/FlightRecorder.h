@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "LogChannel.h"
+
+namespace logging
+{
+
+// What the renderer knew about one frame
+struct FrameSummary
+{
+    uint64_t frameIndex = 0;
+    uint64_t timestamp = 0;     // logging::Now() at the start of the frame
+    uint64_t frameTime = 0;     // ns since the previous frame started
+    uint32_t drawCount = 0;
+    uint64_t fenceSignaled = 0; // value the frame will signal
+    uint64_t fenceCompleted = 0; // last value the GPU reached
+};
+
+// Always-on black box. Every log record is also copied into a small ring owned by
+// the logging thread, and the renderer adds one summary per frame. Nothing here
+// locks or allocates, so Dump() can run from a crash handler after the AsyncLogger
+// queue is already beyond saving.
+class FlightRecorder final
+{
+public:
+    static constexpr size_t MaxThreads = 32;
+    static constexpr size_t RecordsPerThread = 64;
+    static constexpr size_t FrameCount = 256;
+    static constexpr size_t TextLength = 116;
+
+    // Called on every committed log record; threads past MaxThreads are not recorded
+    static void Record(uint64_t timestamp, uint8_t level, Channel channel, std::string_view text) noexcept;
+
+    // Called once per frame from the render thread
+    static void Frame(const FrameSummary& summary) noexcept;
+
+    // Where Dump() writes; the path is copied, longer paths are cut off
+    static void SetDumpPath(const char* path) noexcept;
+
+    // Writes every ring to the dump path. Async-signal-safe: raw file I/O and
+    // stack buffers only. Returns false when the file could not be opened.
+    static bool Dump() noexcept;
+
+    // Installs handlers for SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT that dump and
+    // then re-raise. On Windows the app's unhandled exception filter calls Dump().
+    static void InstallCrashHandler() noexcept;
+};
+
+} // namespace logging
@@ -0,0 +1,152 @@
+#include "FramePacer.h"
+
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <time.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace timer;
+
+namespace
+{
+// steady_clock is QPC on Windows and CLOCK_MONOTONIC on Linux, the clock both
+// waitable timers and clock_nanosleep measure against.
+uint64_t Now() noexcept
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+}
+
+inline void Relax() noexcept
+{
+#if defined(_M_X64) || defined(__x86_64__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+} // namespace
+
+FramePacer::FramePacer(Config config) :
+    m_config(config),
+    m_lateness(config.spinMargin)
+{
+#ifdef _WIN32
+    // Windows 10 1803+; older systems get a regular timer (~1 ms granularity at best)
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_timer) m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+#endif
+
+    SetTargetRate(config.targetHz);
+}
+
+FramePacer::~FramePacer() noexcept
+{
+#ifdef _WIN32
+    if (m_timer) CloseHandle(m_timer);
+#endif
+}
+
+void FramePacer::SetTargetRate(double hz) noexcept
+{
+    m_config.targetHz = hz;
+    m_period = hz > 0.0 ? static_cast<uint64_t>(1e9 / hz) : 0;
+    m_deadline = 0;
+}
+
+bool FramePacer::Wait()
+{
+    uint64_t now = Now();
+
+    if (m_period == 0) {
+        m_frames++;
+        return true;
+    }
+
+    if (m_deadline == 0) m_deadline = now + m_period;
+
+    // Coarse sleep
+    if (now + m_config.spinMargin < m_deadline) {
+        uint64_t before = now;
+
+#ifdef _WIN32
+        if (m_config.wakeOnMessages && m_timer) {
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>((m_deadline - m_config.spinMargin - now) / 100);
+            SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE);
+
+            HANDLE timer = m_timer;
+            DWORD result = MsgWaitForMultipleObjectsEx(1, &timer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+            now = Now();
+            m_slept += now - before;
+
+            if (result == WAIT_OBJECT_0 + 1) return false;
+        }
+        else
+#endif
+        {
+            Sleep(m_deadline - m_config.spinMargin);
+            now = Now();
+            m_slept += now - before;
+        }
+    }
+
+    // Fine spin for the last stretch
+    uint64_t spinStart = now;
+    while (now < m_deadline) {
+        Relax();
+        now = Now();
+    }
+    m_spun += now - spinStart;
+
+    m_lateness.Record(now - m_deadline);
+    m_frames++;
+
+    // A frame that overran by more than a period restarts the schedule instead of
+    // releasing a burst of frames to catch up
+    m_deadline += m_period;
+    if (m_deadline <= now) m_deadline = now + m_period;
+
+    return true;
+}
+
+// MARK: - Private
+
+void FramePacer::Sleep(uint64_t until)
+{
+#ifdef _WIN32
+    uint64_t now = Now();
+    if (until <= now) return;
+
+    if (m_timer) {
+        LARGE_INTEGER due;
+        due.QuadPart = -static_cast<LONGLONG>((until - now) / 100);
+        SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE);
+        WaitForSingleObject(m_timer, INFINITE);
+    }
+    else {
+        ::Sleep(static_cast<DWORD>((until - now) / 1000000));
+    }
+#else
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(until / 1000000000);
+    deadline.tv_nsec = static_cast<long>(until % 1000000000);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+#endif
+}
@@ -0,0 +1,69 @@
+//
+// FramePacer.h - Frame rate limiter that sleeps instead of spinning
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "FrameTimeRecorder.h"
+
+namespace timer
+{
+// Holds the render loop to a target rate. Each Wait() sleeps on a high-resolution
+// waitable timer (clock_nanosleep on Linux) until `spinMargin` before the deadline,
+// then spins for the rest, so only the last stretch costs CPU.
+class FramePacer final
+{
+public:
+    struct Config
+    {
+        double targetHz = 144.0;        // 0 = unlimited
+        uint64_t spinMargin = 1000000;  // ns spun before each deadline
+        bool wakeOnMessages = true;     // Windows: return early on queued window messages
+    };
+
+    // Disallow copy / assign
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    FramePacer() :
+        FramePacer(Config{})
+    {
+    }
+    explicit FramePacer(Config config);
+    ~FramePacer() noexcept;
+
+    void SetTargetRate(double hz) noexcept;
+    double GetTargetRate() const noexcept { return m_config.targetHz; }
+
+    // Blocks until the next frame is due and returns true. Returns false when a window
+    // message arrived first; pump messages and call again, the deadline is kept.
+    bool Wait();
+
+    // Frames paced so far
+    uint64_t GetFrameCount() const noexcept { return m_frames; }
+    // Time spent asleep instead of busy-waiting, i.e. CPU time saved
+    uint64_t GetSleptTime() const noexcept { return m_slept; }
+    // Time spent spinning for the last stretch
+    uint64_t GetSpunTime() const noexcept { return m_spun; }
+    // How late each frame was released past its deadline; over budget = later than the spin margin
+    const FrameTimeRecorder& Lateness() const noexcept { return m_lateness; }
+
+private:
+    void Sleep(uint64_t until);
+
+    Config m_config;
+    uint64_t m_period = 0; // ns, 0 = unlimited
+    uint64_t m_deadline = 0;
+
+    uint64_t m_frames = 0;
+    uint64_t m_slept = 0;
+    uint64_t m_spun = 0;
+    FrameTimeRecorder m_lateness;
+
+#ifdef _WIN32
+    void* m_timer = nullptr; // HANDLE
+#endif
+};
+} // namespace timer
@@ -0,0 +1,188 @@
+//
+// FrameTimeRecorder.h - Frame-time histogram and percentiles
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace timer
+{
+// Frame times in nanoseconds
+struct FrameTimeSummary
+{
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+    uint64_t overBudget = 0;
+};
+
+// Records every frame twice: into a log-bucketed histogram that covers everything
+// since Reset(), and into a ring of the latest raw samples for sliding windows.
+// One thread records; any thread can query at any time without locks. A reader
+// racing the writer may be off by the frame being written.
+class FrameTimeRecorder final
+{
+public:
+    static constexpr size_t SampleCount = 1024;
+
+    // 2^SubBucketBits buckets per power of two, so a bucket is at most 1/16 (6.25%) wide
+    static constexpr uint32_t SubBucketBits = 4;
+    static constexpr uint32_t SubBuckets = 1u << SubBucketBits;
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    // Disallow copy / assign
+    FrameTimeRecorder(const FrameTimeRecorder&) = delete;
+    FrameTimeRecorder& operator=(const FrameTimeRecorder&) = delete;
+
+    explicit FrameTimeRecorder(uint64_t budget = 16666667) noexcept :
+        m_budget(budget)
+    {
+    }
+
+    void SetBudget(uint64_t budget) noexcept { m_budget.store(budget, std::memory_order_relaxed); }
+    uint64_t GetBudget() const noexcept { return m_budget.load(std::memory_order_relaxed); }
+
+    // Frames recorded since construction, not cleared by Reset()
+    uint64_t GetTotalCount() const noexcept { return m_head.load(std::memory_order_acquire); }
+
+    // Writer thread only
+    void Record(uint64_t frameTime) noexcept
+    {
+        // Single writer: plain load + store instead of a locked read-modify-write
+        auto& bucket = m_buckets[BucketIndex(frameTime)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (frameTime > m_max.load(std::memory_order_relaxed))
+            m_max.store(frameTime, std::memory_order_relaxed);
+
+        if (frameTime > GetBudget())
+            m_overBudget.store(m_overBudget.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        m_samples[head % SampleCount].store(frameTime, std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Clears the histogram; the sample ring keeps feeding Window()
+    void Reset() noexcept
+    {
+        for (auto& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+
+        m_count.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+        m_overBudget.store(0, std::memory_order_relaxed);
+    }
+
+    // Everything since Reset(); percentiles are bucket upper bounds
+    FrameTimeSummary SinceReset() const noexcept
+    {
+        FrameTimeSummary summary;
+        summary.count = m_count.load(std::memory_order_relaxed);
+        summary.max = m_max.load(std::memory_order_relaxed);
+        summary.overBudget = m_overBudget.load(std::memory_order_relaxed);
+        if (summary.count == 0) return summary;
+
+        uint64_t targets[] = {Rank(summary.count, 50), Rank(summary.count, 90), Rank(summary.count, 99)};
+        uint64_t* results[] = {&summary.p50, &summary.p90, &summary.p99};
+
+        uint64_t seen = 0;
+        size_t next = 0;
+        for (size_t i = 0; i < BucketCount && next < 3; i++) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+
+            while (next < 3 && seen > targets[next]) {
+                *results[next] = std::min(BucketUpperBound(i), summary.max);
+                next++;
+            }
+        }
+
+        // The writer moved on while we summed, fall back to the max
+        for (; next < 3; next++)
+            *results[next] = summary.max;
+
+        return summary;
+    }
+
+    // Exact statistics over the latest `frames` frames (at most SampleCount)
+    FrameTimeSummary Window(size_t frames = SampleCount) const noexcept
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        size_t count = static_cast<size_t>(std::min<uint64_t>({frames, SampleCount, head}));
+
+        FrameTimeSummary summary;
+        summary.count = count;
+        if (count == 0) return summary;
+
+        std::array<uint64_t, SampleCount> sorted;
+        uint64_t budget = GetBudget();
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t sample = m_samples[(head - count + i) % SampleCount].load(std::memory_order_relaxed);
+            sorted[i] = sample;
+            summary.max = std::max(summary.max, sample);
+            summary.overBudget += sample > budget;
+        }
+
+        auto begin = sorted.begin();
+        auto select = [&](uint32_t percent) {
+            auto nth = begin + static_cast<ptrdiff_t>(Rank(count, percent));
+            std::nth_element(begin, nth, begin + static_cast<ptrdiff_t>(count));
+            return *nth;
+        };
+
+        summary.p50 = select(50);
+        summary.p90 = select(90);
+        summary.p99 = select(99);
+        return summary;
+    }
+
+    // HDR-style bucket: exponent of the top bit, then the next SubBucketBits bits
+    static constexpr size_t BucketIndex(uint64_t value) noexcept
+    {
+        if (value < SubBuckets) return static_cast<size_t>(value);
+
+        uint32_t exponent = 63 - static_cast<uint32_t>(std::countl_zero(value));
+        uint32_t shift = exponent - SubBucketBits;
+        uint64_t sub = (value >> shift) & (SubBuckets - 1);
+        return (shift + 1) * SubBuckets + static_cast<size_t>(sub);
+    }
+
+    static constexpr uint64_t BucketUpperBound(size_t index) noexcept
+    {
+        if (index < SubBuckets) return index;
+
+        uint32_t shift = static_cast<uint32_t>(index / SubBuckets) - 1;
+        uint64_t sub = index % SubBuckets;
+        uint64_t lower = (SubBuckets + sub) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+    // 0-based rank of the percentile in `count` sorted values
+    static constexpr uint64_t Rank(uint64_t count, uint32_t percent) noexcept
+    {
+        return std::min(count - 1, count * percent / 100);
+    }
+
+    std::atomic<uint64_t> m_budget;
+
+    std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_max{0};
+    std::atomic<uint64_t> m_overBudget{0};
+
+    std::array<std::atomic<uint64_t>, SampleCount> m_samples{};
+    std::atomic<uint64_t> m_head{0};
+};
+} // namespace timer
@@ -1,6 +1,9 @@
 #pragma once
 
-#include "../pch.h"
+#include <cstdint>
+
+#include "Clock.h"
+#include "FrameTimeRecorder.h"
 #include "StepTimer.h"
 
 namespace timer
@@ -10,22 +13,45 @@ struct Tick
     double totalTime{0.0};
     double deltaTime{0.0};
     uint64_t frameCount{0};
+
+    // How far the render time is between this step and the next one, in [0, 1).
+    // Render state = previous + (current - previous) * alpha.
+    double alpha{0.0};
 };
 }; // namespace timer
 
 class GameTimer final
 {
 public:
-    GameTimer() noexcept :
-        m_stepTimer(DX::StepTimer())
+    static constexpr double DefaultStep = 1 / 144.0;
+
+    // Fixed steps run per Tick before the backlog is dropped
+    static constexpr uint32_t MaxStepsPerTick = 8;
+
+    // Pass a timer::VirtualClock to drive the simulation from a headless loop
+    explicit GameTimer(timer::Clock& clock = timer::DefaultClock(), double step = DefaultStep) noexcept :
+        m_stepTimer(clock)
     {
-        m_stepTimer.SetFixedTimeStep(TRUE);
-        m_stepTimer.SetTargetElapsedSeconds(1 / 144.0);
+        m_stepTimer.SetFixedTimeStep(true);
+        m_stepTimer.SetTargetElapsedSeconds(step);
+        m_stepTimer.SetMaxUpdatesPerTick(MaxStepsPerTick);
+        m_frameTimes.SetBudget(StepToBudget(step));
     }
 
     // in seconds
 
-    timer::Tick Tick()
+    // The step is also the frame-time budget
+    void SetStep(double step) noexcept
+    {
+        m_stepTimer.SetTargetElapsedSeconds(step);
+        m_frameTimes.SetBudget(StepToBudget(step));
+    }
+    double GetStep() const noexcept { return DX::StepTimer::TicksToSeconds(m_stepTimer.GetTargetElapsedTicks()); }
+
+    // Runs `step(tick)` once per fixed step that is due (possibly zero times) and
+    // returns the latest tick with `alpha` set for interpolation.
+    template <typename TStep>
+    timer::Tick Tick(const TStep& step)
     {
         if (m_pauseTime > 0) {
             return m_currentTick;
@@ -35,11 +61,26 @@ public:
             m_currentTick.deltaTime = m_stepTimer.GetElapsedSeconds();
             m_currentTick.totalTime = m_stepTimer.GetTotalSeconds() - m_pausedTotalTime;
             m_currentTick.frameCount = m_stepTimer.GetFrameCount();
+            step(m_currentTick);
         });
 
+        m_frameTimes.Record(m_stepTimer.GetFrameTicks() * NanosecondsPerTick);
+
+        m_currentTick.alpha = static_cast<double>(m_stepTimer.GetLeftOverTicks())
+            / static_cast<double>(m_stepTimer.GetTargetElapsedTicks());
+
         return m_currentTick;
     }
 
+    timer::Tick Tick()
+    {
+        return Tick([](const timer::Tick&) {});
+    }
+
+    // Wall time between Tick calls, i.e. between rendered frames
+    const timer::FrameTimeRecorder& FrameTimes() const noexcept { return m_frameTimes; }
+    timer::FrameTimeRecorder& FrameTimes() noexcept { return m_frameTimes; }
+
     void Resume()
     {
         if (m_pauseTime == 0)
@@ -60,7 +101,12 @@ public:
     }
 
 private:
+    static constexpr uint64_t NanosecondsPerTick = 1000000000 / DX::StepTimer::TicksPerSecond;
+
+    static uint64_t StepToBudget(double step) noexcept { return static_cast<uint64_t>(step * 1e9); }
+
     DX::StepTimer m_stepTimer;
+    timer::FrameTimeRecorder m_frameTimes;
 
     timer::Tick m_currentTick{};
 
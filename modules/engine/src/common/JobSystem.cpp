@@ -0,0 +1,210 @@
+#include "JobSystem.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace jobs;
+
+namespace
+{
+// The system the current thread belongs to and its queue there
+thread_local JobSystem* t_system = nullptr;
+thread_local unsigned t_index = ~0u;
+
+void Pause() noexcept
+{
+#if defined(_M_X64) || defined(__x86_64__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+} // namespace
+
+JobSystem::JobSystem(unsigned workers)
+{
+    for (unsigned i = 0; i <= workers; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    m_previous = t_system;
+    m_previousIndex = t_index;
+    t_system = this;
+    t_index = 0;
+
+    for (unsigned i = 1; i <= workers; i++) {
+        m_workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() noexcept
+{
+    m_stop.store(true, std::memory_order_seq_cst);
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    m_epoch.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+
+    if (t_system == this) {
+        t_system = m_previous;
+        t_index = m_previousIndex;
+    }
+}
+
+unsigned JobSystem::Self() const noexcept
+{
+    return t_system == this ? t_index : NoThread;
+}
+
+// MARK: - Jobs
+
+Job* JobSystem::Allocate() noexcept
+{
+    unsigned self = Self();
+    if (self == NoThread) return nullptr;
+
+    // A slot still queued or not yet copied out means the pool wrapped around
+    Queue& queue = *m_queues[self];
+    Job& job = queue.jobs[queue.next & (QueueCapacity - 1)];
+    if (job.busy.load(std::memory_order_acquire)) return nullptr;
+
+    queue.next++;
+    job.busy.store(true, std::memory_order_relaxed);
+    return &job;
+}
+
+void JobSystem::Submit(Job* job) noexcept
+{
+    if (job->counter) job->counter->Add();
+
+    if (!m_queues[Self()]->deque.Push(job)) {
+        Execute(*job);
+        return;
+    }
+
+    WakeOne();
+}
+
+void JobSystem::Wait(Counter& counter, bool help) noexcept
+{
+    unsigned self = Self();
+
+    if (help && self != NoThread) {
+        uint32_t idle = 0;
+        while (!counter.Done()) {
+            if (Job* job = Find(self)) {
+                Execute(*job);
+                idle = 0;
+            }
+            else if (++idle < IdleSpins) {
+                Pause();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+
+    // Announce the block, then check: the last job either sees the announcement and
+    // moves m_finished, or it finished before the check
+    m_blocked.fetch_add(1, std::memory_order_seq_cst);
+    for (;;) {
+        uint32_t finished = m_finished.load(std::memory_order_seq_cst);
+        if (counter.m_pending.load(std::memory_order_seq_cst) == 0) break;
+        m_finished.wait(finished, std::memory_order_seq_cst);
+    }
+    m_blocked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+Job* JobSystem::Find(unsigned self) noexcept
+{
+    if (Job* job = m_queues[self]->deque.Pop()) return job;
+
+    // Victims in turn, starting past ourselves so the threads spread out
+    size_t count = m_queues.size();
+    for (size_t k = 1; k < count; k++) {
+        if (Job* job = m_queues[(self + k) % count]->deque.Steal()) return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::Execute(Job& job) noexcept
+{
+    // Copied out first so the owner can reuse the slot while this one runs
+    auto run = job.run;
+    Counter* counter = job.counter;
+    alignas(8) unsigned char payload[Job::PayloadSize];
+    std::memcpy(payload, job.payload, sizeof(payload));
+    job.busy.store(false, std::memory_order_release);
+
+    run(*this, payload);
+
+    if (counter && counter->Finish()) WakeBlocked();
+}
+
+// MARK: - Workers
+
+void JobSystem::WorkerLoop(unsigned self) noexcept
+{
+    t_system = this;
+    t_index = self;
+
+    uint32_t idle = 0;
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        if (Job* job = Find(self)) {
+            Execute(*job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < IdleSpins) {
+            Pause();
+            continue;
+        }
+
+        // Announce the sleep, then look once more: a submitter either sees the
+        // announcement and moves the epoch, or its job is found here
+        uint32_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        Job* job = Find(self);
+        if (!job && !m_stop.load(std::memory_order_seq_cst)) {
+            m_epoch.wait(epoch, std::memory_order_seq_cst);
+        }
+
+        m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+
+        if (job) Execute(*job);
+    }
+}
+
+void JobSystem::WakeOne() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) == 0) return;
+
+    m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    m_epoch.notify_one();
+}
+
+void JobSystem::WakeBlocked() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_blocked.load(std::memory_order_relaxed) == 0) return;
+
+    m_finished.fetch_add(1, std::memory_order_seq_cst);
+    m_finished.notify_all();
+}
+
+JobSystem& jobs::Shared()
+{
+    static JobSystem system;
+    return system;
+}
@@ -0,0 +1,233 @@
+//
+// JobSystem.h - Work-stealing job system with counters and parallel-for
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "WorkStealingDeque.h"
+
+namespace jobs
+{
+class JobSystem;
+
+// Jobs left to finish; Run adds one, the job's completion takes it away. Outlives
+// every job it counts, which Wait guarantees.
+class Counter final
+{
+public:
+    // Disallow copy / assign
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    Counter() = default;
+
+    bool Done() const noexcept { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    void Add() noexcept { m_pending.fetch_add(1, std::memory_order_relaxed); }
+    // True for the last job. The waiter may return and destroy the counter right
+    // after, so nothing touches it past this point.
+    bool Finish() noexcept { return m_pending.fetch_sub(1, std::memory_order_seq_cst) == 1; }
+
+    std::atomic<uint32_t> m_pending{0};
+};
+
+// One cache line: a trampoline, its counter and the captured state in place
+struct alignas(64) Job
+{
+    static constexpr size_t PayloadSize = 40;
+
+    void (*run)(JobSystem&, const void* payload);
+    Counter* counter;
+    // Set while queued, cleared once an executor has copied the job out
+    std::atomic<bool> busy{false};
+    alignas(8) unsigned char payload[PayloadSize];
+};
+
+static_assert(sizeof(Job) == 64);
+
+// One worker per core besides the thread that creates the system, each with a
+// Chase-Lev deque; idle threads steal from the others. The creating thread owns a
+// deque too and executes jobs while it waits. Threads that are not part of the
+// system still can call Run and ParallelFor, the work then runs inline.
+//
+// Jobs must not throw.
+class JobSystem final
+{
+public:
+    // Per thread: queued jobs, and the pool the thread allocates its jobs from
+    static constexpr size_t QueueCapacity = 4096;
+    // Spins before an idle worker goes to sleep
+    static constexpr uint32_t IdleSpins = 2048;
+
+    // Disallow copy / assign
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    explicit JobSystem(unsigned workers = DefaultWorkers());
+    ~JobSystem() noexcept;
+
+    static unsigned DefaultWorkers() noexcept { return std::max(1u, std::thread::hardware_concurrency()) - 1; }
+
+    // Workers plus the creating thread
+    unsigned ThreadCount() const noexcept { return static_cast<unsigned>(m_queues.size()); }
+
+    // MARK: - Jobs
+
+    // Queues fn() against `counter`. fn is copied into the job, so it has to be
+    // small and trivially copyable: capture by reference or pointer.
+    template <typename Fn>
+    void Run(Counter& counter, const Fn& fn)
+    {
+        static_assert(std::is_trivially_copyable_v<Fn> && sizeof(Fn) <= Job::PayloadSize && alignof(Fn) <= 8,
+                      "job state has to fit the payload in place");
+
+        Job* job = Allocate();
+        if (!job) {
+            fn();
+            return;
+        }
+
+        job->run = [](JobSystem&, const void* payload) { (*static_cast<const Fn*>(payload))(); };
+        job->counter = &counter;
+        new (job->payload) Fn(fn);
+        Submit(job);
+    }
+
+    // Returns once `counter` is done. With `help`, a thread of the system runs queued
+    // jobs (its own first, then stolen) meanwhile instead of blocking.
+    void Wait(Counter& counter, bool help = true) noexcept;
+
+    // Calls fn(first, last) over disjoint ranges covering [0, count), from this and
+    // other threads, and returns when all are done. Ranges are split in half only
+    // while the local deque runs dry, i.e. while other threads are stealing, and
+    // never below `minGrain`. `maxWays` caps how many ranges there are (0 = no cap).
+    template <typename Fn>
+    void ParallelFor(size_t count, size_t minGrain, const Fn& fn, unsigned maxWays = 0)
+    {
+        if (count == 0) return;
+
+        size_t grain = std::max<size_t>(minGrain, 1);
+        if (maxWays > 0) grain = std::max(grain, (count + maxWays - 1) / maxWays);
+
+        if (count <= grain || ThreadCount() == 1 || Self() == NoThread) {
+            fn(size_t(0), count);
+            return;
+        }
+
+        Counter counter;
+        RangeJob<Fn>{&fn, &counter, 0, count, grain}.Execute(*this);
+        Wait(counter);
+    }
+
+private:
+    static constexpr unsigned NoThread = ~0u;
+
+    struct Queue
+    {
+        explicit Queue() :
+            deque(QueueCapacity),
+            jobs(std::make_unique<Job[]>(QueueCapacity))
+        {
+        }
+
+        WorkStealingDeque<Job*> deque;
+        std::unique_ptr<Job[]> jobs;
+        size_t next = 0;
+    };
+
+    template <typename Fn>
+    struct RangeJob
+    {
+        const Fn* fn;
+        Counter* counter;
+        size_t first;
+        size_t last;
+        size_t grain;
+
+        void Execute(JobSystem& system) const
+        {
+            const WorkStealingDeque<Job*>& local = system.m_queues[system.Self()]->deque;
+
+            size_t begin = first, end = last;
+            while (begin < end) {
+                // Hand out the upper half while there is nothing left to steal here
+                if (end - begin > grain && local.Size() == 0) {
+                    size_t mid = begin + (end - begin) / 2;
+                    if (system.RunRange(RangeJob{fn, counter, mid, end, grain})) {
+                        end = mid;
+                        continue;
+                    }
+                }
+
+                size_t stop = std::min(begin + grain, end);
+                (*fn)(begin, stop);
+                begin = stop;
+            }
+        }
+    };
+
+    template <typename Fn>
+    bool RunRange(const RangeJob<Fn>& range)
+    {
+        static_assert(sizeof(RangeJob<Fn>) <= Job::PayloadSize);
+
+        Job* job = Allocate();
+        if (!job) return false;
+
+        job->run = [](JobSystem& system, const void* payload) { static_cast<const RangeJob<Fn>*>(payload)->Execute(system); };
+        job->counter = range.counter;
+        new (job->payload) RangeJob<Fn>(range);
+        Submit(job);
+        return true;
+    }
+
+    // Index of the calling thread's queue, NoThread for outside threads
+    unsigned Self() const noexcept;
+
+    // A free job from the calling thread's pool, nullptr when it has none
+    Job* Allocate() noexcept;
+    // Counts, queues and wakes a sleeper; runs the job right away when the deque is full
+    void Submit(Job*) noexcept;
+    Job* Find(unsigned self) noexcept;
+    void Execute(Job&) noexcept;
+
+    void WorkerLoop(unsigned self) noexcept;
+    void WakeOne() noexcept;
+    // Wakes threads blocked in Wait after some counter reached zero
+    void WakeBlocked() noexcept;
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<bool> m_stop{false};
+    // Sleepers wait for the epoch to move, submitters bump it when anyone sleeps
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_sleeping{0};
+    // Threads blocked in Wait sleep on the system, never on a counter that may be
+    // gone by the time the last job notifies
+    std::atomic<uint32_t> m_finished{0};
+    std::atomic<uint32_t> m_blocked{0};
+
+    // The creating thread's previous system, restored on destruction
+    JobSystem* m_previous = nullptr;
+    unsigned m_previousIndex = NoThread;
+};
+
+// Process-wide system, created by the first call, which should come from the main
+// thread so it is the one that helps
+JobSystem& Shared();
+
+} // namespace jobs
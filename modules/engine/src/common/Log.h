@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "AsyncLogger.h"
+#include "LogChannel.h"
+#include "LogFormat.h"
+
+// Calls below this level are compiled out, e.g. -DYANG_LOG_MIN_LEVEL=2 keeps WARNING and ERROR
+#ifndef YANG_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define YANG_LOG_MIN_LEVEL 0 // DEBUG
+#else
+#define YANG_LOG_MIN_LEVEL 1 // INFO
+#endif
+#endif
+
+namespace logging
+{
+
+// Bounded writer over a claimed AsyncLogger slot; output past the end is cut off.
+class LineWriter final
+{
+public:
+    LineWriter(char* data, size_t capacity) noexcept :
+        m_data(data),
+        m_capacity(capacity)
+    {
+    }
+
+    size_t Size() const noexcept { return m_size; }
+
+    void Append(std::string_view s) noexcept
+    {
+        size_t count = std::min(s.size(), m_capacity - m_size);
+        memcpy(m_data + m_size, s.data(), count);
+        m_size += count;
+    }
+
+    void Append(const char* s) noexcept { Append(std::string_view(s ? s : "(null)")); }
+    void Append(char c) noexcept { Append(std::string_view(&c, 1)); }
+    void Append(bool b) noexcept { Append(std::string_view(b ? "true" : "false")); }
+
+    void Append(const void* p) noexcept
+    {
+        Append(std::string_view("0x"));
+        AppendChars(reinterpret_cast<uintptr_t>(p), 16);
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    void Append(T value) noexcept
+    {
+        if constexpr (std::is_enum_v<T>)
+            AppendChars(static_cast<std::underlying_type_t<T>>(value));
+        else
+            AppendChars(value);
+    }
+
+    template <typename T>
+        requires std::is_convertible_v<const T&, std::string_view> && (!std::is_pointer_v<T>)
+    void Append(const T& s) noexcept
+    {
+        Append(std::string_view(s));
+    }
+
+private:
+    template <typename T, typename... Base>
+    void AppendChars(T value, Base... base) noexcept
+    {
+        auto result = std::to_chars(m_data + m_size, m_data + m_capacity, value, base...);
+        if (result.ec == std::errc())
+            m_size = static_cast<size_t>(result.ptr - m_data);
+    }
+
+    char* m_data;
+    size_t m_capacity;
+    size_t m_size = 0;
+};
+
+// Runtime filter state of one channel
+struct ChannelState
+{
+    std::atomic<AsyncLogger::LogLevel> level{AsyncLogger::DEBUG};
+    std::atomic<uint32_t> rateLimit{0};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint64_t> window{0};
+    std::atomic<uint64_t> suppressed{0};
+};
+
+// Typed front end over AsyncLogger. Level and rate filters run before anything is
+// formatted, and the line is formatted straight into the logger's ring slot, so
+// each thread's line reaches the worker whole and without an intermediate copy.
+class Log final
+{
+public:
+    using Level = AsyncLogger::LogLevel;
+
+    static void SetLogger(AsyncLogger* logger) noexcept { s_logger.store(logger, std::memory_order_release); }
+
+    // Lines below `level` on `channel` are skipped
+    static void SetLevel(Channel channel, Level level) noexcept
+    {
+        s_channels[Index(channel)].level.store(level, std::memory_order_relaxed);
+    }
+
+    // At most `linesPerSecond` lines on `channel`, 0 = unlimited
+    static void SetRateLimit(Channel channel, uint32_t linesPerSecond) noexcept
+    {
+        s_channels[Index(channel)].rateLimit.store(linesPerSecond, std::memory_order_relaxed);
+    }
+
+    // Lines rejected by the rate limit on `channel`
+    static uint64_t Suppressed(Channel channel) noexcept
+    {
+        return s_channels[Index(channel)].suppressed.load(std::memory_order_relaxed);
+    }
+
+    static bool Enabled(Level level, Channel channel) noexcept
+    {
+        ChannelState& state = s_channels[Index(channel)];
+        if (level < state.level.load(std::memory_order_relaxed)) return false;
+
+        auto limit = state.rateLimit.load(std::memory_order_relaxed);
+        if (limit == 0) return true;
+
+        // Fixed one-second window; racing threads may let a few extra lines through
+        auto second = Now() / 1000000000;
+        if (state.window.load(std::memory_order_relaxed) != second) {
+            state.window.store(second, std::memory_order_relaxed);
+            state.count.store(0, std::memory_order_relaxed);
+        }
+
+        if (state.count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    template <typename... Args>
+    static void Write(Level level, Channel channel, const Args&... args) noexcept
+    {
+        AsyncLogger* logger = s_logger.load(std::memory_order_acquire);
+        if (!logger) return;
+
+        size_t position = 0;
+        AsyncLogger::Record* record = logger->begin(level, channel, &position);
+        if (!record) return;
+
+        LineWriter writer(record->text, AsyncLogger::Record::MaxLength);
+        (writer.Append(args), ...);
+
+        record->length = static_cast<uint16_t>(writer.Size());
+        logger->commit(record, position);
+    }
+
+private:
+    static constexpr size_t Index(Channel channel) noexcept { return static_cast<size_t>(channel); }
+
+    static inline std::atomic<AsyncLogger*> s_logger{nullptr};
+    static inline ChannelState s_channels[static_cast<size_t>(Channel::COUNT)];
+};
+
+} // namespace logging
+
+// YANG_LOG(INFO, WINDOW, "size ", width, "x", height)
+// Arguments are only evaluated when the line passes the compile-time and runtime filters.
+#define YANG_LOG(level, channel, ...)                                                                \
+    do {                                                                                             \
+        if constexpr (AsyncLogger::level >= YANG_LOG_MIN_LEVEL) {                                    \
+            if (logging::Log::Enabled(AsyncLogger::level, logging::Channel::channel))                \
+                logging::Log::Write(AsyncLogger::level, logging::Channel::channel, __VA_ARGS__);     \
+        }                                                                                            \
+    } while (0)
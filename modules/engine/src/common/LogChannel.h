@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace logging
+{
+
+// Subsystem a log line belongs to, filtered independently at runtime
+enum class Channel : uint8_t
+{
+    GENERAL,
+    WINDOW,
+    INPUT,
+    DEVICE,
+    PIPELINE,
+    COUNT
+};
+
+constexpr std::string_view ChannelName(Channel channel) noexcept
+{
+    switch (channel) {
+    case Channel::GENERAL:
+        return "general";
+    case Channel::WINDOW:
+        return "window";
+    case Channel::INPUT:
+        return "input";
+    case Channel::DEVICE:
+        return "device";
+    case Channel::PIPELINE:
+        return "pipeline";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,89 @@
+#include "LogFormat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+using namespace logging;
+
+TimestampCache::TimestampCache() noexcept :
+    m_anchorWall(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        )
+            .count()
+    ),
+    m_anchorSteady(Now())
+{
+}
+
+TimestampCache::TimestampCache(int64_t anchorWall, uint64_t anchorSteady) noexcept :
+    m_anchorWall(anchorWall),
+    m_anchorSteady(anchorSteady)
+{
+}
+
+void TimestampCache::Render(uint64_t timestamp, char* out) noexcept
+{
+    int64_t wall = m_anchorWall + (static_cast<int64_t>(timestamp) - static_cast<int64_t>(m_anchorSteady));
+    int64_t second = wall / 1000000000;
+    int64_t micros = (wall % 1000000000) / 1000;
+
+    if (second != m_cachedSecond) {
+        time_t now = static_cast<time_t>(second);
+        tm timeinfo;
+#ifdef _WIN32
+        localtime_s(&timeinfo, &now);
+#else
+        localtime_r(&now, &timeinfo);
+#endif
+        strftime(m_prefix.data(), m_prefix.size(), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        m_cachedSecond = second;
+    }
+
+    memcpy(out, m_prefix.data(), PrefixLength);
+    out[PrefixLength] = '.';
+
+    for (size_t i = Length - 1; i > PrefixLength; i--) {
+        out[i] = static_cast<char>('0' + micros % 10);
+        micros /= 10;
+    }
+}
+
+std::string_view RecordFormatter::Format(
+    uint64_t timestamp,
+    std::string_view level,
+    std::string_view channel,
+    std::string_view text
+) noexcept
+{
+    char* out = m_buffer.data();
+
+    *out++ = '[';
+    m_timestamps.Render(timestamp, out);
+    out += TimestampCache::Length;
+    *out++ = ']';
+    *out++ = ' ';
+
+    memcpy(out, level.data(), level.size());
+    out += level.size();
+
+    if (!channel.empty()) {
+        *out++ = ' ';
+        *out++ = '[';
+        memcpy(out, channel.data(), channel.size());
+        out += channel.size();
+        *out++ = ']';
+    }
+
+    *out++ = ':';
+    *out++ = ' ';
+
+    size_t room = static_cast<size_t>(m_buffer.data() + Capacity - out) - 1;
+    size_t count = std::min(text.size(), room);
+    memcpy(out, text.data(), count);
+    out += count;
+    *out++ = '\n';
+
+    return {m_buffer.data(), static_cast<size_t>(out - m_buffer.data())};
+}
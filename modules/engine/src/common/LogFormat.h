@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace logging
+{
+
+// Monotonic timestamp in nanoseconds, cheap enough to take on every log call.
+// steady_clock is QPC (TSC-backed) on Windows and CLOCK_MONOTONIC on Linux.
+inline uint64_t Now() noexcept
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+}
+
+// Turns monotonic timestamps into "YYYY-MM-DD HH:MM:SS.uuuuuu". The wall clock is
+// anchored once; the calendar prefix is recomputed only when the second changes.
+class TimestampCache final
+{
+public:
+    static constexpr size_t Length = 26;
+
+    TimestampCache() noexcept;
+    // Renders timestamps taken in another process, e.g. when decoding a binary log
+    TimestampCache(int64_t anchorWall, uint64_t anchorSteady) noexcept;
+
+    // Writes exactly `Length` characters to `out`.
+    void Render(uint64_t timestamp, char* out) noexcept;
+
+private:
+    static constexpr size_t PrefixLength = 19;
+
+    int64_t m_anchorWall;   // ns since the Unix epoch
+    uint64_t m_anchorSteady; // ns, same instant as m_anchorWall
+
+    int64_t m_cachedSecond = -1;
+    std::array<char, PrefixLength + 1> m_prefix{};
+};
+
+// Formats records as "[timestamp] LEVEL [channel]: text\n" into a reusable buffer.
+class RecordFormatter final
+{
+public:
+    static constexpr size_t Capacity = 512;
+
+    RecordFormatter() noexcept = default;
+    explicit RecordFormatter(TimestampCache timestamps) noexcept :
+        m_timestamps(timestamps)
+    {
+    }
+
+    // The returned view stays valid until the next call.
+    std::string_view Format(uint64_t timestamp, std::string_view level, std::string_view text) noexcept
+    {
+        return Format(timestamp, level, {}, text);
+    }
+    std::string_view Format(
+        uint64_t timestamp,
+        std::string_view level,
+        std::string_view channel,
+        std::string_view text
+    ) noexcept;
+
+private:
+    TimestampCache m_timestamps;
+    std::array<char, Capacity> m_buffer{};
+};
+
+} // namespace logging
@@ -0,0 +1,185 @@
+#include "LogSink.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace logging;
+
+FileSink::FileSink(const std::filesystem::path& path, DurabilityPolicy policy) :
+    m_policy(policy),
+    m_lastSync(std::chrono::steady_clock::now())
+{
+    for (auto& chunk : m_chunks) {
+        chunk.data = std::make_unique<char[]>(ChunkSize);
+    }
+
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path());
+
+#ifdef _WIN32
+    HANDLE h = CreateFileW(
+        path.c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    m_file = h == INVALID_HANDLE_VALUE ? nullptr : h;
+#else
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+
+    assert(IsOpen());
+}
+
+FileSink::~FileSink() noexcept
+{
+    if (!IsOpen()) return;
+
+    WriteBatch();
+
+#ifdef _WIN32
+    if (m_policy.mode != Durability::NONE) FlushFileBuffers(m_file);
+    CloseHandle(m_file);
+#else
+    if (m_policy.mode != Durability::NONE) fdatasync(m_fd);
+    close(m_fd);
+#endif
+}
+
+bool FileSink::IsOpen() const noexcept
+{
+#ifdef _WIN32
+    return m_file != nullptr;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+void FileSink::Append(std::string_view text, bool urgent)
+{
+    while (!text.empty()) {
+        if (m_current == MaxChunks)
+            WriteBatch(); // batch is full, write it out and keep gathering
+
+        Chunk& chunk = m_chunks[m_current];
+        size_t count = std::min(text.size(), ChunkSize - chunk.size);
+
+        memcpy(chunk.data.get() + chunk.size, text.data(), count);
+        chunk.size += count;
+        m_pending += count;
+        text.remove_prefix(count);
+
+        if (chunk.size == ChunkSize)
+            m_current++;
+    }
+
+    if (urgent && m_policy.mode == Durability::SYNC_ON_ERROR) {
+        WriteBatch();
+        Sync();
+    }
+}
+
+void FileSink::Commit()
+{
+    WriteBatch();
+
+    switch (m_policy.mode) {
+    case Durability::NONE:
+    case Durability::SYNC_ON_ERROR:
+        break;
+    case Durability::INTERVAL:
+        if (m_bytesSinceSync && std::chrono::steady_clock::now() - m_lastSync >= m_policy.interval)
+            Sync();
+        break;
+    case Durability::BYTES:
+        if (m_bytesSinceSync >= m_policy.bytes)
+            Sync();
+        break;
+    }
+}
+
+void FileSink::Sync()
+{
+    if (!IsOpen()) return;
+
+#ifdef _WIN32
+    FlushFileBuffers(m_file);
+#else
+    fdatasync(m_fd);
+#endif
+
+    m_syncCalls++;
+    m_bytesSinceSync = 0;
+    m_lastSync = std::chrono::steady_clock::now();
+}
+
+// MARK: - Private
+
+void FileSink::WriteBatch()
+{
+    if (m_pending == 0) return;
+
+    size_t count = std::min(m_current + 1, MaxChunks);
+
+    if (IsOpen()) {
+#ifdef _WIN32
+        for (size_t i = 0; i < count; i++) {
+            DWORD written = 0;
+            WriteFile(m_file, m_chunks[i].data.get(), static_cast<DWORD>(m_chunks[i].size), &written, nullptr);
+            m_writeCalls++;
+        }
+#else
+        iovec iov[MaxChunks];
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = m_chunks[i].data.get();
+            iov[i].iov_len = m_chunks[i].size;
+        }
+
+        // Retry on short writes by advancing through the iovec array
+        iovec* first = iov;
+        int remaining = static_cast<int>(count);
+        while (remaining > 0) {
+            ssize_t written = writev(m_fd, first, remaining);
+            m_writeCalls++;
+
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            while (remaining > 0 && static_cast<size_t>(written) >= first->iov_len) {
+                written -= static_cast<ssize_t>(first->iov_len);
+                first++;
+                remaining--;
+            }
+            if (remaining > 0) {
+                first->iov_base = static_cast<char*>(first->iov_base) + written;
+                first->iov_len -= static_cast<size_t>(written);
+            }
+        }
+#endif
+    }
+
+    m_bytesWritten += m_pending;
+    m_bytesSinceSync += m_pending;
+
+    for (size_t i = 0; i < count; i++) {
+        m_chunks[i].size = 0;
+    }
+    m_current = 0;
+    m_pending = 0;
+}
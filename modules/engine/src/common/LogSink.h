@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+namespace logging
+{
+
+// When the sink forces written data to stable storage
+enum class Durability
+{
+    NONE,         // leave it to the OS
+    INTERVAL,     // at most every `interval`
+    BYTES,        // after every `bytes` written
+    SYNC_ON_ERROR // right after any urgent (ERROR) record
+};
+
+struct DurabilityPolicy
+{
+    Durability mode = Durability::NONE;
+    std::chrono::milliseconds interval{1000};
+    size_t bytes = 1 << 20;
+};
+
+// Destination for formatted records, driven by a single logger worker thread
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+
+    // Copies `text` into the sink; `urgent` marks ERROR records
+    virtual void Append(std::string_view text, bool urgent = false) = 0;
+    // Called once per drained batch
+    virtual void Commit() = 0;
+    // Forces everything written so far to stable storage
+    virtual void Sync() = 0;
+};
+
+// Group-commit file sink. Records are gathered into preallocated chunks and the
+// whole batch goes out with one vectored write on Commit (writev on POSIX; on
+// Win32 one WriteFile per chunk, since WriteFileGather needs unbuffered I/O).
+class FileSink final : public Sink
+{
+public:
+    static constexpr size_t ChunkSize = 64 * 1024;
+    static constexpr size_t MaxChunks = 16;
+
+    // Disallow copy / assign
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    FileSink(const std::filesystem::path& path, DurabilityPolicy policy = {});
+    ~FileSink() noexcept override;
+
+    bool IsOpen() const noexcept;
+
+    // Copies `text` into the pending batch. An urgent append is committed and
+    // synced immediately under Durability::SYNC_ON_ERROR.
+    void Append(std::string_view text, bool urgent = false) override;
+
+    // Writes the pending batch and applies the durability policy.
+    void Commit() override;
+
+    void Sync() override;
+
+    uint64_t BytesWritten() const noexcept { return m_bytesWritten; }
+    uint64_t WriteCalls() const noexcept { return m_writeCalls; }
+    uint64_t SyncCalls() const noexcept { return m_syncCalls; }
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    void WriteBatch();
+
+    DurabilityPolicy m_policy;
+
+    std::array<Chunk, MaxChunks> m_chunks;
+    size_t m_current = 0;
+    size_t m_pending = 0;
+
+    uint64_t m_bytesWritten = 0;
+    uint64_t m_bytesSinceSync = 0;
+    uint64_t m_writeCalls = 0;
+    uint64_t m_syncCalls = 0;
+    std::chrono::steady_clock::time_point m_lastSync;
+
+#ifdef _WIN32
+    void* m_file = nullptr; // HANDLE
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace logging
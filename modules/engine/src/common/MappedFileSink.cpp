@@ -0,0 +1,221 @@
+#include "MappedFileSink.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace logging;
+
+MappedFileSink::MappedFileSink(const std::filesystem::path& path, RotationPolicy policy, DurabilityPolicy durability) :
+    m_policy(policy),
+    m_durability(durability),
+    m_directory(path.parent_path()),
+    m_stem(path.stem().string()),
+    m_extension(path.extension().string()),
+    m_lastSync(std::chrono::steady_clock::now())
+{
+    assert(m_policy.segmentBytes > 0 && m_policy.maxFiles > 0);
+
+    if (!m_directory.empty())
+        std::filesystem::create_directories(m_directory);
+
+    // Start a fresh index, like CREATE_ALWAYS for the plain sink
+    std::ofstream(m_directory / (m_stem + ".index"), std::ios::trunc);
+
+    OpenSegment();
+}
+
+MappedFileSink::~MappedFileSink() noexcept
+{
+    CloseSegment();
+}
+
+void MappedFileSink::Append(std::string_view text, bool urgent)
+{
+    m_bytesSinceSync += text.size();
+
+    while (!text.empty() && IsOpen()) {
+        size_t room = m_policy.segmentBytes - m_used;
+
+        // Keep records whole unless one is larger than a segment
+        if (room < text.size() && m_used > 0) {
+            Roll();
+            continue;
+        }
+
+        size_t count = std::min(room, text.size());
+        memcpy(m_view + m_used, text.data(), count);
+        m_used += count;
+        text.remove_prefix(count);
+
+        if (m_used == m_policy.segmentBytes)
+            Roll();
+    }
+
+    if (urgent && m_durability.mode == Durability::SYNC_ON_ERROR)
+        Sync();
+}
+
+void MappedFileSink::Commit()
+{
+    switch (m_durability.mode) {
+    case Durability::NONE:
+    case Durability::SYNC_ON_ERROR:
+        break;
+    case Durability::INTERVAL:
+        if (m_bytesSinceSync && std::chrono::steady_clock::now() - m_lastSync >= m_durability.interval)
+            Sync();
+        break;
+    case Durability::BYTES:
+        if (m_bytesSinceSync >= m_durability.bytes)
+            Sync();
+        break;
+    }
+}
+
+void MappedFileSink::Sync()
+{
+    if (!IsOpen()) return;
+
+    if (m_used > 0) {
+#ifdef _WIN32
+        FlushViewOfFile(m_view, m_used);
+        FlushFileBuffers(m_file);
+#else
+        msync(m_view, m_used, MS_SYNC);
+#endif
+    }
+
+    m_syncCalls++;
+    m_bytesSinceSync = 0;
+    m_lastSync = std::chrono::steady_clock::now();
+}
+
+// MARK: - Private
+
+std::filesystem::path MappedFileSink::SegmentPath(uint32_t segment) const
+{
+    char number[16];
+    snprintf(number, sizeof(number), ".%04u", segment);
+    return m_directory / (m_stem + number + m_extension);
+}
+
+void MappedFileSink::OpenSegment()
+{
+    auto path = SegmentPath(m_segment);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(m_policy.segmentBytes);
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return;
+    }
+
+    m_view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_policy.segmentBytes));
+    if (!m_view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+#else
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) return;
+
+    if (ftruncate(m_fd, static_cast<off_t>(m_policy.segmentBytes)) != 0) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    void* view = mmap(nullptr, m_policy.segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (view == MAP_FAILED) {
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    m_view = static_cast<char*>(view);
+#endif
+
+    // Only segments that exist are indexed; a failed one leaves the sink closed
+    std::ofstream index(m_directory / (m_stem + ".index"), std::ios::app);
+    index << m_segment << ' ' << m_segmentStart << ' ' << path.filename().string() << '\n';
+}
+
+void MappedFileSink::CloseSegment() noexcept
+{
+    if (m_durability.mode != Durability::NONE) Sync();
+
+#ifdef _WIN32
+    if (m_view) UnmapViewOfFile(m_view);
+    if (m_mapping) CloseHandle(m_mapping);
+
+    if (m_file) {
+        // Trim the preallocated tail so readers don't see zeros
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(m_used);
+        SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN);
+        SetEndOfFile(m_file);
+        CloseHandle(m_file);
+    }
+
+    m_file = nullptr;
+    m_mapping = nullptr;
+#else
+    if (m_view) munmap(m_view, m_policy.segmentBytes);
+
+    if (m_fd >= 0) {
+        // Trim the preallocated tail so readers don't see zeros
+        std::ignore = ftruncate(m_fd, static_cast<off_t>(m_used));
+        close(m_fd);
+    }
+
+    m_fd = -1;
+#endif
+
+    m_view = nullptr;
+}
+
+void MappedFileSink::Roll()
+{
+    CloseSegment();
+
+    m_segmentStart += m_used;
+    m_used = 0;
+    m_segment++;
+
+    if (m_segment >= m_policy.maxFiles) {
+        std::error_code ec;
+        std::filesystem::remove(SegmentPath(m_segment - static_cast<uint32_t>(m_policy.maxFiles)), ec);
+    }
+
+    OpenSegment();
+}
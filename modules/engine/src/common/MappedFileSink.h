@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "LogSink.h"
+
+namespace logging
+{
+
+struct RotationPolicy
+{
+    size_t segmentBytes = 64 << 20; // preallocated size of each file
+    size_t maxFiles = 8;            // older segments are deleted
+};
+
+// Appends into a memory-mapped, preallocated file segment, so a write is a memcpy
+// into the page cache. A full segment is trimmed to its used size and the sink rolls
+// over to the next numbered file ("engine.log" -> "engine.0003.log"). Every segment
+// start is recorded in "engine.index" as "<segment> <stream offset> <file name>".
+// Durability works as for FileSink, with msync (FlushViewOfFile + FlushFileBuffers
+// on Win32) standing in for fdatasync; a segment is synced before it is closed.
+class MappedFileSink final : public Sink
+{
+public:
+    // Disallow copy / assign
+    MappedFileSink(const MappedFileSink&) = delete;
+    MappedFileSink& operator=(const MappedFileSink&) = delete;
+
+    MappedFileSink(const std::filesystem::path& path, RotationPolicy policy = {}, DurabilityPolicy durability = {});
+    ~MappedFileSink() noexcept override;
+
+    bool IsOpen() const noexcept { return m_view != nullptr; }
+
+    // An urgent append is synced immediately under Durability::SYNC_ON_ERROR
+    void Append(std::string_view text, bool urgent = false) override;
+    // Applies the durability policy; the data is already in the page cache
+    void Commit() override;
+    void Sync() override;
+
+    uint64_t BytesWritten() const noexcept { return m_segmentStart + m_used; }
+    uint32_t Segment() const noexcept { return m_segment; }
+    uint64_t SyncCalls() const noexcept { return m_syncCalls; }
+
+private:
+    std::filesystem::path SegmentPath(uint32_t segment) const;
+
+    void OpenSegment();
+    void CloseSegment() noexcept;
+    void Roll();
+
+    RotationPolicy m_policy;
+    DurabilityPolicy m_durability;
+    std::filesystem::path m_directory;
+    std::string m_stem;
+    std::string m_extension;
+
+    uint32_t m_segment = 0;
+    uint64_t m_segmentStart = 0; // stream offset of the current segment
+    size_t m_used = 0;
+
+    char* m_view = nullptr;
+
+    uint64_t m_bytesSinceSync = 0;
+    uint64_t m_syncCalls = 0;
+    std::chrono::steady_clock::time_point m_lastSync;
+
+#ifdef _WIN32
+    void* m_file = nullptr;    // HANDLE
+    void* m_mapping = nullptr; // HANDLE
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace logging
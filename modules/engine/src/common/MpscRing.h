@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+// Bounded lock-free ring of preallocated slots (D. Vyukov's sequence-per-cell
+// scheme). Producers claim a slot with one CAS, fill it in place and publish it;
+// the single consumer reads slots in place and releases them. Claiming from the
+// read side is also safe from producers, which is what DiscardOldest relies on.
+template <typename T>
+class MpscRing final
+{
+public:
+    static constexpr size_t CacheLine = 64;
+
+    // Disallow copy / assign
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // capacity must be a power of two
+    explicit MpscRing(size_t capacity) :
+        m_mask(capacity - 1),
+        m_cells(std::make_unique<Cell[]>(capacity))
+    {
+        assert(capacity >= 2 && (capacity & m_mask) == 0);
+
+        for (size_t i = 0; i < capacity; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~MpscRing() noexcept = default;
+
+    size_t Capacity() const noexcept { return m_mask + 1; }
+
+    // Approximate number of claimed but not yet released slots.
+    size_t Size() const noexcept
+    {
+        auto head = m_enqueuePos.load(std::memory_order_relaxed);
+        auto tail = m_dequeuePos.load(std::memory_order_relaxed);
+        return head >= tail ? head - tail : 0;
+    }
+
+    // MARK: - Producer
+
+    // Returns a slot to fill, or nullptr when the ring is full.
+    // `position` receives the sequence number of the claimed slot.
+    T* TryClaim(size_t* position = nullptr) noexcept
+    {
+        auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            auto seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    if (position) *position = pos;
+                    return &cell.data;
+                }
+            }
+            else if (diff < 0) {
+                return nullptr; // full
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Makes a claimed slot visible to the consumer.
+    void Publish(T* slot) noexcept
+    {
+        Cell& cell = CellOf(slot);
+        auto pos = cell.sequence.load(std::memory_order_relaxed);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // Drops the oldest published slot to make room. Safe to call from producers.
+    bool DiscardOldest() noexcept
+    {
+        T* slot = TryAcquire();
+        if (!slot) return false;
+
+        Release(slot);
+        return true;
+    }
+
+    // MARK: - Consumer
+
+    // Returns the oldest published slot, or nullptr when there is none.
+    T* TryAcquire() noexcept
+    {
+        auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            auto seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return &cell.data;
+            }
+            else if (diff < 0) {
+                return nullptr; // empty, or the next slot is still being filled
+            }
+            else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Hands an acquired slot back to producers.
+    void Release(T* slot) noexcept
+    {
+        Cell& cell = CellOf(slot);
+        auto pos = cell.sequence.load(std::memory_order_relaxed);
+        cell.sequence.store(pos + m_mask, std::memory_order_release);
+    }
+
+    // Consumes up to `max` slots in place, returns the number consumed.
+    template <typename TVisit>
+    size_t Drain(const TVisit& visit, size_t max = SIZE_MAX)
+    {
+        size_t count = 0;
+        while (count < max) {
+            T* slot = TryAcquire();
+            if (!slot) break;
+
+            visit(*slot);
+            Release(slot);
+            count++;
+        }
+        return count;
+    }
+
+private:
+    struct alignas(CacheLine) Cell
+    {
+        std::atomic<size_t> sequence{0};
+        T data{};
+    };
+
+    Cell& CellOf(T* slot) noexcept
+    {
+        return *reinterpret_cast<Cell*>(reinterpret_cast<char*>(slot) - offsetof(Cell, data));
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(CacheLine) std::atomic<size_t> m_enqueuePos{0};
+    alignas(CacheLine) std::atomic<size_t> m_dequeuePos{0};
+};
@@ -6,15 +6,19 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <exception>
 
+#include "Clock.h"
+
 namespace DX
 {
 // Helper class for animation and simulation timing.
 class StepTimer
 {
 public:
-    StepTimer() noexcept(false) :
+    explicit StepTimer(timer::Clock& clock = timer::DefaultClock()) noexcept(false) :
+        m_clock(&clock),
         m_elapsedTicks(0),
         m_totalTicks(0),
         m_leftOverTicks(0),
@@ -25,16 +29,11 @@ public:
         m_isFixedTimeStep(false),
         m_targetElapsedTicks(TicksPerSecond / 60)
     {
-        if (!QueryPerformanceFrequency(&m_qpcFrequency)) {
-            throw std::exception();
-        }
-
-        if (!QueryPerformanceCounter(&m_qpcLastTime)) {
-            throw std::exception();
-        }
+        m_qpcFrequency = m_clock->Frequency();
+        m_qpcLastTime = m_clock->Now();
 
         // Initialize max delta to 1/10 of a second.
-        m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+        m_qpcMaxDelta = m_qpcFrequency / 10;
     }
 
     // Get elapsed time since the previous Update call.
@@ -47,6 +46,12 @@ public:
         return TicksToSeconds(m_elapsedTicks);
     }
 
+    // Get the unclamped wall time between the last two Tick calls.
+    uint64_t GetFrameTicks() const noexcept
+    {
+        return m_frameTicks;
+    }
+
     // Get total time since the start of the program.
     uint64_t GetTotalTicks() const noexcept
     {
@@ -84,6 +89,24 @@ public:
     {
         m_targetElapsedTicks = SecondsToTicks(targetElapsed);
     }
+    uint64_t GetTargetElapsedTicks() const noexcept
+    {
+        return m_targetElapsedTicks;
+    }
+
+    // Time accumulated towards the next fixed Update, always below the target.
+    uint64_t GetLeftOverTicks() const noexcept
+    {
+        return m_leftOverTicks;
+    }
+
+    // Limit fixed Update calls per Tick (0 = unlimited). Once a Tick hits the limit,
+    // the remaining backlog is dropped instead of carried over, so frames that are
+    // slower than the step cannot snowball into a catch-up spiral.
+    void SetMaxUpdatesPerTick(uint32_t maxUpdates) noexcept
+    {
+        m_maxUpdatesPerTick = maxUpdates;
+    }
 
     // Integer format represents time using 10,000,000 ticks per second.
     static constexpr uint64_t TicksPerSecond = 10000000;
@@ -103,9 +126,7 @@ public:
 
     void ResetElapsedTime()
     {
-        if (!QueryPerformanceCounter(&m_qpcLastTime)) {
-            throw std::exception();
-        }
+        m_qpcLastTime = m_clock->Now();
 
         m_leftOverTicks = 0;
         m_framesPerSecond = 0;
@@ -118,17 +139,16 @@ public:
     void Tick(const TUpdate& update)
     {
         // Query the current time.
-        LARGE_INTEGER currentTime;
-
-        if (!QueryPerformanceCounter(&currentTime)) {
-            throw std::exception();
-        }
-
-        uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+        uint64_t currentTime = m_clock->Now();
+        uint64_t timeDelta = currentTime - m_qpcLastTime;
 
         m_qpcLastTime = currentTime;
         m_qpcSecondCounter += timeDelta;
 
+        // Split to keep long stalls from overflowing the multiply.
+        m_frameTicks = timeDelta / m_qpcFrequency * TicksPerSecond
+            + timeDelta % m_qpcFrequency * TicksPerSecond / m_qpcFrequency;
+
         // Clamp excessively large time deltas (e.g. after paused in the debugger).
         if (timeDelta > m_qpcMaxDelta) {
             timeDelta = m_qpcMaxDelta;
@@ -137,7 +157,7 @@ public:
         // Convert QPC units into a canonical tick format. This cannot overflow due to the previous
         // clamp.
         timeDelta *= TicksPerSecond;
-        timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+        timeDelta /= m_qpcFrequency;
 
         const uint32_t lastFrameCount = m_frameCount;
 
@@ -160,7 +180,15 @@ public:
 
             m_leftOverTicks += timeDelta;
 
+            uint32_t updates = 0;
+
             while (m_leftOverTicks >= m_targetElapsedTicks) {
+                if (m_maxUpdatesPerTick && updates == m_maxUpdatesPerTick) {
+                    m_leftOverTicks %= m_targetElapsedTicks;
+                    break;
+                }
+
+                updates++;
                 m_elapsedTicks = m_targetElapsedTicks;
                 m_totalTicks += m_targetElapsedTicks;
                 m_leftOverTicks -= m_targetElapsedTicks;
@@ -184,23 +212,25 @@ public:
             m_framesThisSecond++;
         }
 
-        if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart)) {
+        if (m_qpcSecondCounter >= m_qpcFrequency) {
             m_framesPerSecond = m_framesThisSecond;
             m_framesThisSecond = 0;
-            m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+            m_qpcSecondCounter %= m_qpcFrequency;
         }
     }
 
 private:
-    // Source timing data uses QPC units.
-    LARGE_INTEGER m_qpcFrequency;
-    LARGE_INTEGER m_qpcLastTime;
+    // Source timing data uses the clock's units (QPC units by default on Windows).
+    timer::Clock* m_clock;
+    uint64_t m_qpcFrequency;
+    uint64_t m_qpcLastTime;
     uint64_t m_qpcMaxDelta;
 
     // Derived timing data uses a canonical tick format.
     uint64_t m_elapsedTicks;
     uint64_t m_totalTicks;
     uint64_t m_leftOverTicks;
+    uint64_t m_frameTicks = 0;
 
     // Members for tracking the framerate.
     uint32_t m_frameCount;
@@ -211,5 +241,6 @@ private:
     // Members for configuring fixed timestep mode.
     bool m_isFixedTimeStep;
     uint64_t m_targetElapsedTicks;
+    uint32_t m_maxUpdatesPerTick = 0;
 };
 } // namespace DX
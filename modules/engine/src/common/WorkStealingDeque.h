@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded Chase-Lev work-stealing deque (with the C11 memory orderings of Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models"). The owning thread
+// pushes and pops at the bottom, LIFO; any other thread steals from the top, FIFO,
+// which hands thieves the oldest and usually largest pieces of work. `T` is a
+// pointer type, nullptr meaning "nothing".
+template <typename T>
+class WorkStealingDeque final
+{
+public:
+    static constexpr size_t CacheLine = 64;
+
+    // Disallow copy / assign
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // capacity must be a power of two
+    explicit WorkStealingDeque(size_t capacity) :
+        m_mask(capacity - 1),
+        m_buffer(std::make_unique<std::atomic<T>[]>(capacity))
+    {
+        assert(capacity >= 2 && (capacity & m_mask) == 0);
+    }
+    ~WorkStealingDeque() noexcept = default;
+
+    size_t Capacity() const noexcept { return m_mask + 1; }
+
+    // Approximate, exact only on the owning thread with no thieves around
+    size_t Size() const noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    // MARK: - Owner
+
+    // Returns false when full
+    bool Push(T item) noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top > static_cast<int64_t>(m_mask)) return false;
+
+        m_buffer[bottom & m_mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    T Pop() noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T item = m_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // The last item, race the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // MARK: - Thieves
+
+    // nullptr when empty or when another thread got there first
+    T Steal() noexcept
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) return nullptr;
+
+        T item = m_buffer[top & m_mask].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+private:
+    // Thieves write the top, the owner the bottom; keep them on separate lines
+    alignas(CacheLine) std::atomic<int64_t> m_top{0};
+    alignas(CacheLine) std::atomic<int64_t> m_bottom{0};
+
+    alignas(CacheLine) const size_t m_mask;
+    std::unique_ptr<std::atomic<T>[]> m_buffer;
+};
@@ -3,7 +3,7 @@
 
 using namespace DX;
 
-CommandList::CommandList(ID3D12Device* device)
+CommandList::CommandList(ID3D12Device* device, LPCWSTR name)
 {
     // Create a command allocator for each back buffer that will be rendered to.
     for (UINT n = 0; n < m_bufferParams.count; n++) {
@@ -27,7 +27,7 @@ CommandList::CommandList(ID3D12Device* device)
     ));
     ThrowIfFailed(m_commandList->Close());
 
-    m_commandList->SetName(L"DeviceResources");
+    m_commandList->SetName(name);
 }
 
 CommandList::~CommandList() noexcept
@@ -12,10 +12,11 @@ public:
     CommandList(const CommandList&) = delete;
     CommandList& operator=(const CommandList&) = delete;
 
-    CommandList(ID3D12Device*);
+    CommandList(ID3D12Device*, LPCWSTR name = L"DeviceResources");
     ~CommandList() noexcept;
 
     ID3D12GraphicsCommandList* Prepare(UINT backBufferIndex);
+    ID3D12GraphicsCommandList* Get() const noexcept { return m_commandList.Get(); }
     void ResourceBarrier(D3D12_RESOURCE_BARRIER);
     ID3D12CommandList* Close();
 
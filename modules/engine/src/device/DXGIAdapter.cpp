@@ -1,4 +1,5 @@
 #include "DXGIAdapter.h"
+#include "../common/Log.h"
 #include "../pch.h"
 
 using Microsoft::WRL::ComPtr;
@@ -145,19 +146,23 @@ void DXGIAdapter::LogGPUMemoryInfo()
     // Query non-local video memory (system memory used by GPU)
     ThrowIfFailed(m_dxgiAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &nonLocalMemoryInfo));
 
-    std::ostringstream vram;
-    vram << "VRAM | " << localMemoryInfo.CurrentUsage / 1024 / 1024 << " / "
-         << localMemoryInfo.Budget / 1024 / 1024 << " MB"
-         << " | reserved: " << localMemoryInfo.CurrentReservation / 1024 / 1024 << " / "
-         << localMemoryInfo.AvailableForReservation / 1024 / 1024 << " MB";
-
-    std::ostringstream ram;
-    ram << "RAM | " << nonLocalMemoryInfo.CurrentUsage / 1024 / 1024 << " / "
-        << nonLocalMemoryInfo.Budget / 1024 / 1024 << " MB"
-        << " | reserved: " << nonLocalMemoryInfo.CurrentReservation / 1024 / 1024 << " / "
-        << nonLocalMemoryInfo.AvailableForReservation / 1024 / 1024 << " MB";
-
-    std::cout << vram.str() << ram.str();
+    YANG_LOG(
+        INFO,
+        DEVICE,
+        "VRAM | ", localMemoryInfo.CurrentUsage / 1024 / 1024, " / ",
+        localMemoryInfo.Budget / 1024 / 1024, " MB",
+        " | reserved: ", localMemoryInfo.CurrentReservation / 1024 / 1024, " / ",
+        localMemoryInfo.AvailableForReservation / 1024 / 1024, " MB"
+    );
+
+    YANG_LOG(
+        INFO,
+        DEVICE,
+        "RAM | ", nonLocalMemoryInfo.CurrentUsage / 1024 / 1024, " / ",
+        nonLocalMemoryInfo.Budget / 1024 / 1024, " MB",
+        " | reserved: ", nonLocalMemoryInfo.CurrentReservation / 1024 / 1024, " / ",
+        nonLocalMemoryInfo.AvailableForReservation / 1024 / 1024, " MB"
+    );
 }
 
 void DX::DXGIAdapter::LogOutputs()
@@ -190,10 +195,7 @@ void DXGIAdapter::LogOutputDisplayModes(IDXGIOutput* output, DXGI_FORMAT format)
         UINT n = x.RefreshRate.Numerator;
         UINT d = x.RefreshRate.Denominator;
 
-        std::ostringstream text;
-        text << x.Width << " x " << x.Height << ", " << n << "/" << d;
-
-        std::cout << text.str();
+        YANG_LOG(DEBUG, DEVICE, x.Width, " x ", x.Height, ", ", n, "/", d);
     }
 }
 
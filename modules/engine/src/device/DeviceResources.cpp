@@ -53,6 +53,7 @@ void DeviceResources::CreateDeviceResources()
     m_fence = make_unique<Fence>(m_d3dDevice.Get(), m_commandQueue.Get());
     m_swapChain = make_unique<SwapChain>(m_d3dDevice.Get(), m_dxgiFactory.get(), m_commandQueue.Get(), this);
     m_commandList = make_unique<CommandList>(m_d3dDevice.Get());
+    m_transients = make_unique<TransientResources>(m_d3dDevice.Get());
 
     // Determines whether tearing support is available for fullscreen borderless windows.
     if ((m_options & c_AllowTearing) && !m_dxgiFactory->isTearingAllowed()) {
@@ -79,7 +80,13 @@ void DeviceResources::CreateWindowSizeDependentResources()
     UINT width = std::max<UINT>(static_cast<UINT>(m_stateReducer->getWidth() * resolutionScale), 1u);
     UINT height = std::max<UINT>(static_cast<UINT>(m_stateReducer->getHeight() * resolutionScale), 1u);
 
-    m_heaps->Initialize(width, height, m_options & c_ReverseDepth);
+    m_heaps->Initialize();
+
+    m_depthDesc.width = width;
+    m_depthDesc.height = height;
+    m_depthDesc.format = m_bufferParams.depthBufferFormat;
+    m_depthDesc.usage = canvas::TextureUsage::DEPTH_STENCIL;
+    m_transients->Describe(m_depthDesc);
 
     m_swapChain->Reinitialize(
         m_window,
@@ -127,6 +134,10 @@ void DeviceResources::HandleDeviceLost()
 
     m_fence.reset();
     m_commandList.reset();
+    m_drawLists.clear();
+    m_preparedDrawLists.clear();
+    m_graph.Reset();
+    m_transients.reset();
     m_heaps.reset();
     m_swapChain.reset();
     m_dxgiFactory.reset();
@@ -152,14 +163,28 @@ ID3D12GraphicsCommandList* DeviceResources::Prepare()
     // Reset command list and allocator.
     auto commandList = m_commandList->Prepare(m_backBufferIndex);
 
-    // Transition the render target into the correct state to allow for drawing into it.
-    m_commandList->ResourceBarrier(
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_heaps->RTarget(m_backBufferIndex),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_RENDER_TARGET
-        )
-    );
+    // Declared every frame; compiling and realizing an unchanged graph only
+    // rebuilds the barrier lists
+    m_graph.Reset();
+    auto backBuffer = m_graph.Import("Back buffer", canvas::RESOURCE_STATE_COMMON, canvas::RESOURCE_STATE_COMMON);
+    auto scene = m_graph.AddPass("Scene");
+    m_graph.Write(scene, backBuffer, canvas::RESOURCE_STATE_RENDER_TARGET);
+
+    auto depth = canvas::NoGraphResource;
+    if (m_bufferParams.depthBufferFormat != DXGI_FORMAT_UNKNOWN) {
+        depth = m_graph.CreateTransient("Depth stencil", m_depthDesc);
+        m_graph.Write(scene, depth, canvas::RESOURCE_STATE_DEPTH_WRITE);
+    }
+
+    m_graph.Compile();
+    m_transients->Realize(m_graph);
+    m_transients->Import(backBuffer, m_heaps->RTarget(m_backBufferIndex));
+    if (depth != canvas::NoGraphResource) {
+        m_heaps->SetDepthBuffer(m_transients->Resource(depth));
+    }
+
+    // Into the states the scene draws in
+    m_transients->Barriers(commandList, m_graph.Barriers(m_graph.Order().front()));
 
     // Set the viewport and scissor rect.
     commandList->RSSetViewports(1, &m_screenViewport);
@@ -172,23 +197,48 @@ ID3D12GraphicsCommandList* DeviceResources::Prepare()
     return commandList;
 }
 
+std::span<ID3D12GraphicsCommandList* const> DeviceResources::PrepareDrawLists(UINT count)
+{
+    while (m_drawLists.size() < count) {
+        wchar_t name[32] = {};
+        swprintf_s(name, L"Draws %zu", m_drawLists.size());
+        m_drawLists.push_back(make_unique<CommandList>(m_d3dDevice.Get(), name));
+    }
+
+    m_preparedDrawLists.clear();
+    for (UINT i = 0; i < count; i++) {
+        auto commandList = m_drawLists[i]->Prepare(m_backBufferIndex);
+
+        // Nothing carries over between lists but the resource states
+        commandList->RSSetViewports(1, &m_screenViewport);
+        commandList->RSSetScissorRects(1, &m_scissorRect);
+        m_heaps->Bind(commandList, m_backBufferIndex);
+
+        m_preparedDrawLists.push_back(commandList);
+    }
+
+    return m_preparedDrawLists;
+}
+
 // Present the contents of the swap chain to the screen.
 void DeviceResources::Present()
 {
     PIXBeginEvent(m_commandQueue.Get(), PIX_COLOR_DEFAULT, L"Present");
 
-    // Transition the render target to the state that allows it to be presented to the display.
-    m_commandList->ResourceBarrier(
-        CD3DX12_RESOURCE_BARRIER::Transition(
-            m_heaps->RTarget(m_backBufferIndex),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PRESENT
-        )
-    );
+    // Back to presentable, at the end of whichever list executes last
+    size_t drawListCount = m_preparedDrawLists.size();
+    auto lastList = drawListCount == 0 ? m_commandList->Get() : m_preparedDrawLists.back();
+    m_transients->Barriers(lastList, m_graph.FinalBarriers());
 
-    auto commandList = m_commandList->Close();
+    // All of the frame's lists in one submission
+    m_submission.clear();
+    m_submission.push_back(m_commandList->Close());
+    for (size_t i = 0; i < drawListCount; i++) {
+        m_submission.push_back(m_drawLists[i]->Close());
+    }
+    m_preparedDrawLists.clear();
 
-    m_commandQueue->ExecuteCommandLists(1, CommandListCast(&commandList));
+    m_commandQueue->ExecuteCommandLists(static_cast<UINT>(m_submission.size()), m_submission.data());
 
     m_swapChain->Present(m_options & c_AllowTearing);
 
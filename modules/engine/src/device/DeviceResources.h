@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "../canvas/RenderGraph.h"
 #include "../pipeline/Store.h"
 #include "../window/WindowStateReducer.h"
 #include "BufferParams.h"
@@ -12,6 +13,10 @@
 #include "Fence.h"
 #include "Heaps.h"
 #include "SwapChain.h"
+#include "TransientResources.h"
+
+#include <span>
+#include <vector>
 
 namespace DX
 {
@@ -46,11 +51,22 @@ public:
     void Initialize(HWND window, IDeviceNotify* deviceNotify) noexcept;
 
     ID3D12GraphicsCommandList* Prepare();
+    // `count` more lists for this frame's draws, reset and bound to the back buffer
+    // without clearing it. Present executes them after the Prepare one, in order,
+    // so they can be recorded on any threads in between.
+    std::span<ID3D12GraphicsCommandList* const> PrepareDrawLists(UINT count);
     void Present();
     void Flush() noexcept;
     void UpdateColorSpace();
     void HandleDeviceLost(); // SwapChainFallback
 
+    // Presenting without vsync; cleared at device creation when tearing is unsupported
+    bool IsTearingAllowed() const noexcept { return (m_options & c_AllowTearing) != 0; }
+
+    // Fence value the current frame signals, and the last one the GPU reached
+    UINT64 GetFenceValue() const noexcept { return m_fenceValues[m_backBufferIndex]; }
+    UINT64 GetCompletedFenceValue() const noexcept { return m_fence ? m_fence->GetCompletedValue() : 0; }
+
 private:
     void CreateDeviceResources();
     void WaitUntilNextFrame();
@@ -69,8 +85,18 @@ private:
     std::unique_ptr<Heaps> m_heaps;
     std::unique_ptr<SwapChain> m_swapChain;
     std::unique_ptr<CommandList> m_commandList;
+    // Grown on demand, one per recording thread; this frame's are in m_preparedDrawLists
+    std::vector<std::unique_ptr<CommandList>> m_drawLists;
+    std::vector<ID3D12GraphicsCommandList*> m_preparedDrawLists;
+    std::vector<ID3D12CommandList*> m_submission;
     std::unique_ptr<Fence> m_fence;
 
+    // The frame as a graph: the back buffer is imported, the depth buffer is a
+    // transient, and the barriers between them and presenting come from Compile
+    canvas::RenderGraph m_graph;
+    std::unique_ptr<TransientResources> m_transients;
+    canvas::TransientDesc m_depthDesc{};
+
     UINT64 m_fenceValues[BufferParams::MAX_BACK_BUFFER_COUNT]{};
     UINT m_backBufferIndex = 0;
     D3D12_VIEWPORT m_screenViewport{};
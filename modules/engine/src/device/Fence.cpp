@@ -27,6 +27,11 @@ void Fence::Signal(UINT fenceValue)
     DX::ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), fenceValue));
 }
 
+UINT64 Fence::GetCompletedValue() const
+{
+    return m_fence->GetCompletedValue();
+}
+
 void Fence::WaitForFenceValue(UINT fenceValue)
 {
     assert(m_commandQueue && m_fence && m_fenceEvent.IsValid());
@@ -15,6 +15,8 @@ public:
     void Signal(UINT);
     void WaitForFenceValue(UINT);
 
+    UINT64 GetCompletedValue() const;
+
 private:
     ID3D12CommandQueue* m_commandQueue;
 
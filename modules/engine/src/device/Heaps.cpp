@@ -3,15 +3,14 @@
 using namespace DX;
 
 Heaps::Heaps(ID3D12Device* device) :
-    m_device(device),
-    m_resourceFactory(std::make_unique<device::ResourceFactory>(device))
+    m_device(device)
 {
 }
 
-void Heaps::Initialize(UINT width, UINT height, bool reverseDepth)
+void Heaps::Initialize()
 {
     CreateDescriptorHeaps();
-    InitializeDSV(width, height, reverseDepth);
+    m_depthBuffer.Reset();
 
     // Reset render targets in case of repeated initialization
     for (UINT n = 0; n < m_bufferParams.count; n++) {
@@ -44,36 +43,19 @@ void Heaps::CreateDescriptorHeaps()
     }
 }
 
-void Heaps::InitializeDSV(UINT width, UINT height, bool reverseDepth)
+void Heaps::SetDepthBuffer(ID3D12Resource* depthBuffer)
 {
-    if (m_bufferParams.depthBufferFormat != DXGI_FORMAT_UNKNOWN) {
-        D3D12_RESOURCE_DESC depthStencilDesc = CD3DX12_RESOURCE_DESC::Tex2D(
-            m_bufferParams.depthBufferFormat,
-            width,
-            height,
-            1, // Use a single array entry.
-            1  // Use a single mipmap level.
-        );
-        depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-        // Allocate a 2-D surface as the depth/stencil buffer and create a depth/stencil view
-        // on this surface.
-        m_depthBuffer = m_resourceFactory->CreateDepthStencilTexture(
-            width,
-            height,
-            m_bufferParams.depthBufferFormat
-        );
-
-        m_depthBuffer->SetName(L"Depth stencil");
+    if (m_dsvDescriptorHeap == nullptr || depthBuffer == m_depthBuffer.Get()) {
+        return;
+    }
+    m_depthBuffer = depthBuffer;
 
-        D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
-        dsvDesc.Format = m_bufferParams.depthBufferFormat;
-        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-        dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+    D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+    dsvDesc.Format = m_bufferParams.depthBufferFormat;
+    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+    dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
 
-        const auto cpuHandle = m_dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-        m_device->CreateDepthStencilView(m_depthBuffer.Get(), &dsvDesc, cpuHandle);
-    }
+    m_device->CreateDepthStencilView(m_depthBuffer.Get(), &dsvDesc, DSVHandle());
 }
 
 void Heaps::CreateRTargets(IDXGISwapChain* swapChain)
@@ -100,20 +82,25 @@ void Heaps::CreateRTargets(IDXGISwapChain* swapChain)
 }
 
 void Heaps::Prepare(ID3D12GraphicsCommandList* commandList, UINT backBufferIndex)
+{
+    Bind(commandList, backBufferIndex);
+
+    commandList->ClearRenderTargetView(RTVHandle(backBufferIndex), DirectX::Colors::CornflowerBlue, 0, nullptr);
+
+    if (m_dsvDescriptorHeap != nullptr) {
+        commandList->ClearDepthStencilView(DSVHandle(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    }
+}
+
+void Heaps::Bind(ID3D12GraphicsCommandList* commandList, UINT backBufferIndex)
 {
     const auto rtvDescriptor = RTVHandle(backBufferIndex);
 
     if (m_dsvDescriptorHeap == nullptr) {
         commandList->OMSetRenderTargets(1, &rtvDescriptor, FALSE, nullptr);
-        commandList->ClearRenderTargetView(rtvDescriptor, DirectX::Colors::CornflowerBlue, 0, nullptr);
         return;
     }
 
-    auto dsvDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(
-        m_dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart()
-    );
-
+    const auto dsvDescriptor = DSVHandle();
     commandList->OMSetRenderTargets(1, &rtvDescriptor, FALSE, &dsvDescriptor);
-    commandList->ClearRenderTargetView(rtvDescriptor, DirectX::Colors::CornflowerBlue, 0, nullptr);
-    commandList->ClearDepthStencilView(dsvDescriptor, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-}
\ No newline at end of file
+}
@@ -2,7 +2,6 @@
 
 #include "../pch.h"
 #include "BufferParams.h"
-#include "ResourceFactory.h"
 
 namespace DX
 {
@@ -25,16 +24,20 @@ public:
     };
 
     // - init
-    void Initialize(UINT width, UINT height, bool reverseDepth);
+    void Initialize();
     void CreateRTargets(IDXGISwapChain*);
+    // The depth buffer is a frame graph transient; the view follows it when it is recreated
+    void SetDepthBuffer(ID3D12Resource*);
 
     // - prepare / present
+    // Binds and clears the targets of `backBufferIndex`
     void Prepare(ID3D12GraphicsCommandList*, UINT backBufferIndex);
+    // Binds them only, for lists recorded after the clearing one
+    void Bind(ID3D12GraphicsCommandList*, UINT backBufferIndex);
 
 private:
     // - init
     void CreateDescriptorHeaps();
-    void InitializeDSV(UINT width, UINT height, bool reverseDepth);
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE RTVHandle(INT index) const
     {
@@ -45,15 +48,20 @@ private:
         );
     }
 
+    CD3DX12_CPU_DESCRIPTOR_HANDLE DSVHandle() const
+    {
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+    }
+
     BufferParams m_bufferParams{};
     ID3D12Device* m_device;
-    std::unique_ptr<device::ResourceFactory> m_resourceFactory;
 
     UINT m_rtvDescriptorSize = 0;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_rtvDescriptorHeap;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_dsvDescriptorHeap;
     Microsoft::WRL::ComPtr<ID3D12Resource> m_renderTargets[BufferParams::MAX_BACK_BUFFER_COUNT];
+    // Held so a recreated buffer never reuses the address the view was made for
     Microsoft::WRL::ComPtr<ID3D12Resource> m_depthBuffer;
 };
 
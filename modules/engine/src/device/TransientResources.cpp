@@ -0,0 +1,144 @@
+#include "TransientResources.h"
+
+using namespace canvas;
+using namespace DX;
+
+namespace
+{
+D3D12_RESOURCE_STATES ToD3D12(uint32_t state) noexcept
+{
+    D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
+    if (state & RESOURCE_STATE_RENDER_TARGET) states |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+    if (state & RESOURCE_STATE_DEPTH_WRITE) states |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    if (state & RESOURCE_STATE_UNORDERED_ACCESS) states |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    if (state & RESOURCE_STATE_COPY_DEST) states |= D3D12_RESOURCE_STATE_COPY_DEST;
+    if (state & RESOURCE_STATE_DEPTH_READ) states |= D3D12_RESOURCE_STATE_DEPTH_READ;
+    if (state & RESOURCE_STATE_SHADER_READ) states |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    if (state & RESOURCE_STATE_COPY_SOURCE) states |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+    return states;
+}
+
+D3D12_RESOURCE_DESC ToD3D12(const TransientDesc& desc) noexcept
+{
+    D3D12_RESOURCE_FLAGS flags = desc.usage == TextureUsage::DEPTH_STENCIL
+                                     ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
+                                     : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    if (desc.allowUnorderedAccess) flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    return CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.format), desc.width, desc.height, 1, 1, 1, 0, flags);
+}
+
+bool SameTexture(const TransientDesc& a, const TransientDesc& b) noexcept
+{
+    return a.width == b.width && a.height == b.height && a.format == b.format && a.usage == b.usage &&
+           a.allowUnorderedAccess == b.allowUnorderedAccess;
+}
+} // namespace
+
+TransientResources::TransientResources(ID3D12Device* device) :
+    m_device(device)
+{
+}
+
+void TransientResources::Describe(TransientDesc& desc) const
+{
+    D3D12_RESOURCE_DESC resourceDesc = ToD3D12(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO info = m_device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+    desc.size = info.SizeInBytes;
+    desc.alignment = info.Alignment;
+}
+
+void TransientResources::Realize(const RenderGraph& graph)
+{
+    const UINT64 heapSize = graph.Stats().heapSize;
+
+    // Grow only; everything placed in the old heap goes with it
+    if (heapSize > m_heapSize) {
+        m_placed.clear();
+
+        CD3DX12_HEAP_DESC heapDesc(heapSize, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+        ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(m_heap.ReleaseAndGetAddressOf())));
+        m_heap->SetName(L"Transient heap");
+        m_heapSize = heapSize;
+    }
+
+    m_placed.resize(graph.ResourceCount());
+    m_resources.resize(graph.ResourceCount(), nullptr);
+
+    for (GraphResource r = 0; r < graph.ResourceCount(); r++) {
+        if (!graph.IsTransient(r)) continue;
+
+        Placed& placed = m_placed[r];
+        if (graph.FirstUse(r) > graph.LastUse(r)) {
+            placed.resource.Reset();
+            m_resources[r] = nullptr;
+            continue;
+        }
+
+        const TransientDesc& desc = graph.Desc(r);
+        if (placed.resource && placed.offset == graph.HeapOffset(r) && placed.home == graph.HomeState(r) && SameTexture(placed.desc, desc)) {
+            m_resources[r] = placed.resource.Get();
+            continue;
+        }
+
+        D3D12_RESOURCE_DESC resourceDesc = ToD3D12(desc);
+
+        D3D12_CLEAR_VALUE clearValue = {};
+        clearValue.Format = resourceDesc.Format;
+        if (desc.usage == TextureUsage::DEPTH_STENCIL) {
+            clearValue.DepthStencil = {1.0f, 0};
+        }
+
+        ThrowIfFailed(m_device->CreatePlacedResource(
+            m_heap.Get(),
+            graph.HeapOffset(r),
+            &resourceDesc,
+            ToD3D12(graph.HomeState(r)),
+            &clearValue,
+            IID_PPV_ARGS(placed.resource.ReleaseAndGetAddressOf())
+        ));
+
+        wchar_t name[64] = {};
+        swprintf_s(name, L"%hs", graph.ResourceName(r));
+        placed.resource->SetName(name);
+
+        placed.desc = desc;
+        placed.offset = graph.HeapOffset(r);
+        placed.home = graph.HomeState(r);
+        m_resources[r] = placed.resource.Get();
+    }
+}
+
+void TransientResources::Import(GraphResource r, ID3D12Resource* resource)
+{
+    if (m_resources.size() <= r) m_resources.resize(r + 1, nullptr);
+    m_resources[r] = resource;
+}
+
+void TransientResources::Barriers(ID3D12GraphicsCommandList* commandList, std::span<const GraphBarrier> barriers)
+{
+    m_batch.clear();
+    for (const GraphBarrier& barrier : barriers) {
+        ID3D12Resource* resource = m_resources[barrier.resource];
+
+        switch (barrier.type) {
+        case BarrierType::TRANSITION:
+            m_batch.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, ToD3D12(barrier.before), ToD3D12(barrier.after)));
+            break;
+        case BarrierType::ALIASING:
+            m_batch.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(
+                barrier.aliasBefore == NoGraphResource ? nullptr : m_resources[barrier.aliasBefore],
+                resource
+            ));
+            break;
+        case BarrierType::UAV:
+            m_batch.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+            break;
+        }
+    }
+
+    if (!m_batch.empty()) {
+        commandList->ResourceBarrier(static_cast<UINT>(m_batch.size()), m_batch.data());
+    }
+}
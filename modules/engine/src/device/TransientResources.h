@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../canvas/RenderGraph.h"
+#include "../pch.h"
+
+#include <span>
+#include <vector>
+
+namespace DX
+{
+
+// Device side of a canvas::RenderGraph: one heap the compiled transients are placed
+// in, and the graph's barriers recorded as D3D12 ones. Placed resources live across
+// frames and are only recreated when their offset, description or home state
+// changes, which the graph keeps stable as long as the frame is declared the same.
+class TransientResources final
+{
+public:
+    // Disallow copy / assign
+    TransientResources(const TransientResources&) = delete;
+    TransientResources& operator=(const TransientResources&) = delete;
+
+    TransientResources(ID3D12Device*);
+    ~TransientResources() noexcept = default;
+
+    // Fills in size and alignment for the graph to place the texture with
+    void Describe(canvas::TransientDesc&) const;
+
+    // Creates what the compiled graph places, growing the heap if it has to. The GPU
+    // must be done with the previous frame.
+    void Realize(const canvas::RenderGraph&);
+    void Import(canvas::GraphResource, ID3D12Resource*);
+
+    ID3D12Resource* Resource(canvas::GraphResource r) const noexcept { return m_resources[r]; }
+
+    // One batch in a single ResourceBarrier call
+    void Barriers(ID3D12GraphicsCommandList*, std::span<const canvas::GraphBarrier>);
+
+private:
+    struct Placed
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        canvas::TransientDesc desc;
+        UINT64 offset = 0;
+        uint32_t home = 0;
+    };
+
+    ID3D12Device* m_device;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_heap;
+    UINT64 m_heapSize = 0;
+
+    std::vector<Placed> m_placed;            // by graph resource, transients only
+    std::vector<ID3D12Resource*> m_resources; // by graph resource
+    std::vector<D3D12_RESOURCE_BARRIER> m_batch;
+};
+
+} // namespace DX
@@ -1,4 +1,5 @@
 #include "InputController.h"
+#include "../common/Log.h"
 #include "../window/WindowStateReducer.h"
 
 #include <windowsx.h>
@@ -68,12 +69,12 @@ void InputController::OnWindowMessage(HWND hwnd, Message message, WPARAM wParam,
     case Message::LBUTTONUP: {
         int xPos = GET_X_LPARAM(lParam);
         int yPos = GET_Y_LPARAM(lParam);
-        std::cout << "LBUTTON";
+        YANG_LOG(DEBUG, INPUT, "LBUTTON ", xPos, " ", yPos);
     } break;
 
     case Message::RBUTTONDOWN:
     case Message::RBUTTONUP: {
-        std::cout << "RBUTTON";
+        YANG_LOG(DEBUG, INPUT, "RBUTTON");
     } break;
 
     case Message::INPUT: {
@@ -109,7 +110,7 @@ void InputController::OnWindowMessage(HWND hwnd, Message message, WPARAM wParam,
 
     case Message::MOUSEWHEEL: {
         int zDelta = GET_WHEEL_DELTA_WPARAM(wParam);
-        std::cout << "MOUSEWHEEL ";
+        YANG_LOG(DEBUG, INPUT, "MOUSEWHEEL ", zDelta);
     } break;
 
     default:
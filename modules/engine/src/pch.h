@@ -46,6 +46,8 @@
 #include <dxgidebug.h>
 #endif
 
+#include "common/Log.h"
+
 // WinPixEvent Runtime
 #include <pix3.h>
 
@@ -89,15 +91,15 @@ inline void ThrowIfFailed(HRESULT hr, std::string description = "")
 {
     if (FAILED(hr)) {
         _com_error err(hr);
-        std::cout << std::string(_bstr_t(err.ErrorMessage())) << std::endl;
-        std::cout << description << std::endl;
+        YANG_LOG(ERROR, GENERAL, std::string(_bstr_t(err.ErrorMessage())));
+        YANG_LOG(ERROR, GENERAL, description);
         throw com_exception(hr);
     }
 }
 // Helper utility converts D3D API failures into exceptions.
 inline void Throw(std::string description = "")
 {
-    std::cout << description << std::endl;
+    YANG_LOG(ERROR, GENERAL, description);
     throw std::exception();
 }
 
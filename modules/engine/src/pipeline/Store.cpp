@@ -46,16 +46,16 @@ void Store::Deinitialize()
     m_factory.reset();
 }
 
-void Store::Prepare(canvas::PSOType pso, ID3D12GraphicsCommandList* commandList)
+void Store::Prepare(canvas::PSOType pso, canvas::D3D12Recorder& recorder)
 {
-    commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+    recorder.SetGraphicsRootSignature(m_rootSignature.Get());
 
     switch (pso) {
     case canvas::PSOType::GRAPHICS:
-        commandList->SetPipelineState(m_graphicsPSO.Get());
+        recorder.SetPipelineState(m_graphicsPSO.Get());
         break;
     case canvas::PSOType::UI:
-        commandList->SetPipelineState(m_uiPSO.Get());
+        recorder.SetPipelineState(m_uiPSO.Get());
         break;
     }
 }
@@ -64,8 +64,10 @@ void Store::Prepare(canvas::PSOType pso, ID3D12GraphicsCommandList* commandList)
 
 void Store::CreateSignature(ID3D12Device* device)
 {
-    CD3DX12_ROOT_PARAMETER1 params[1];
+    CD3DX12_ROOT_PARAMETER1 params[2];
     params[0].InitAsConstantBufferView(0 /*b0*/, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+    // Per-instance data, offset to each draw's first instance
+    params[1].InitAsShaderResourceView(0 /*t0*/, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rsDesc;
     rsDesc.Init_1_1(
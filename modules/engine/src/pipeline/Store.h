@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "../canvas/D3D12Recorder.h"
 #include "../canvas/DrawItem.h"
 #include "../pch.h"
 #include "Factory.h"
@@ -28,7 +29,7 @@ public:
     void Deinitialize();
 
     // - frame
-    void Prepare(canvas::PSOType, ID3D12GraphicsCommandList*);
+    void Prepare(canvas::PSOType, canvas::D3D12Recorder&);
 
 private:
     // - init
@@ -1,4 +1,5 @@
 #include "WindowStateReducer.h"
+#include "../common/Log.h"
 
 using namespace window;
 
@@ -58,7 +59,7 @@ bool WindowStateReducer::Reduce(Action action)
         break;
 
     case Action::SET_MINIMIZED:
-        std::cout << "WM_SIZE SIZE_MINIMIZED";
+        YANG_LOG(DEBUG, WINDOW, "WM_SIZE SIZE_MINIMIZED");
 
         if (m_windowState.minimized && m_windowState.in_suspend)
             break;
@@ -69,7 +70,7 @@ bool WindowStateReducer::Reduce(Action action)
         break;
 
     case Action::SET_UNMINIMIZED:
-        std::cout << "WM_SIZE UNMINIMIZED";
+        YANG_LOG(DEBUG, WINDOW, "WM_SIZE UNMINIMIZED");
         m_windowState.minimized = false;
 
         if (!m_windowState.in_suspend)
@@ -86,25 +87,25 @@ bool WindowStateReducer::Reduce(Action action)
         return !EqualRect(&current, &m_windowState.bounds);
 
     case Action::ENTER_SIZEMOVE:
-        std::cout << "WM_ENTERSIZEMOVE";
+        YANG_LOG(DEBUG, WINDOW, "WM_ENTERSIZEMOVE");
         m_windowState.in_sizemove = true;
         break;
 
     case Action::EXIT_SIZEMOVE:
-        std::cout << "WM_EXITSIZEMOVE";
+        YANG_LOG(DEBUG, WINDOW, "WM_EXITSIZEMOVE");
         m_windowState.in_sizemove = false;
         GetClientRect(m_hwnd, &m_windowState.bounds);
         PrintWindowState();
         break;
 
     case Action::SET_SUSPEND:
-        std::cout << "SET_SUSPEND";
+        YANG_LOG(DEBUG, WINDOW, "SET_SUSPEND");
 
         m_windowState.in_suspend = true;
         break;
 
     case Action::SET_RESUME:
-        std::cout << "SET_RESUME";
+        YANG_LOG(DEBUG, WINDOW, "SET_RESUME");
 
         m_windowState.in_suspend = false;
         break;
@@ -113,6 +114,22 @@ bool WindowStateReducer::Reduce(Action action)
     return true;
 }
 
+double WindowStateReducer::getRefreshRate()
+{
+    auto monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTOPRIMARY);
+
+    MONITORINFOEX monitorInfo = {};
+    monitorInfo.cbSize = sizeof(MONITORINFOEX);
+    if (!GetMonitorInfo(monitor, &monitorInfo)) return 0.0;
+
+    DEVMODE mode = {};
+    mode.dmSize = sizeof(DEVMODE);
+    if (!EnumDisplaySettings(monitorInfo.szDevice, ENUM_CURRENT_SETTINGS, &mode)) return 0.0;
+
+    // 0 and 1 both mean "hardware default"
+    return mode.dmDisplayFrequency > 1 ? static_cast<double>(mode.dmDisplayFrequency) : 0.0;
+}
+
 void WindowStateReducer::PrintMonitorInfo()
 {
     auto monitor = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTOPRIMARY);
@@ -122,25 +139,29 @@ void WindowStateReducer::PrintMonitorInfo()
     monitorInfo.cbSize = sizeof(MONITORINFOEX); // Set the size of the structure
     GetMonitorInfo(monitor, &monitorInfo);
 
-    std::ostringstream message;
-    message << "MonitorInfo"
-            << " | work: " << monitorInfo.rcWork.right << "x" << monitorInfo.rcWork.bottom
-            << " | full: " << monitorInfo.rcMonitor.right << "x" << monitorInfo.rcMonitor.bottom
-            << " | primary: " << (monitorInfo.dwFlags & MONITORINFOF_PRIMARY);
-    std::cout << message.str();
+    YANG_LOG(
+        INFO,
+        WINDOW,
+        "MonitorInfo",
+        " | work: ", monitorInfo.rcWork.right, "x", monitorInfo.rcWork.bottom,
+        " | full: ", monitorInfo.rcMonitor.right, "x", monitorInfo.rcMonitor.bottom,
+        " | primary: ", (monitorInfo.dwFlags & MONITORINFOF_PRIMARY)
+    );
 }
 
 void WindowStateReducer::PrintWindowState()
 {
     auto ws = m_windowState;
 
-    std::ostringstream message;
-    message << "WindowState"
-            << " | size: " << ws.bounds.right << "x" << ws.bounds.bottom
-            << " | max_size: " << ws.monitorBounds.right << "x" << ws.monitorBounds.bottom
-            << " | fullscreen: " << ws.fullscreen
-            << " | sizemove: " << ws.in_sizemove
-            << " | suspend: " << ws.in_suspend
-            << " | minimized: " << ws.minimized;
-    std::cout << message.str();
+    YANG_LOG(
+        INFO,
+        WINDOW,
+        "WindowState",
+        " | size: ", ws.bounds.right, "x", ws.bounds.bottom,
+        " | max_size: ", ws.monitorBounds.right, "x", ws.monitorBounds.bottom,
+        " | fullscreen: ", ws.fullscreen,
+        " | sizemove: ", ws.in_sizemove,
+        " | suspend: ", ws.in_suspend,
+        " | minimized: ", ws.minimized
+    );
 }
\ No newline at end of file
@@ -44,6 +44,9 @@ public:
     bool suspended() { return m_windowState.in_suspend; }
     bool moving() { return m_windowState.in_sizemove; }
 
+    // Refresh rate of the monitor showing the window in Hz, 0 when unknown
+    double getRefreshRate();
+
     void Initialize(HWND hwnd, int nCmdShow);
 
     bool Reduce(Action action);
@@ -52,7 +55,7 @@ private:
     void PrintMonitorInfo();
     void PrintWindowState();
 
-    HWND m_hwnd;
+    HWND m_hwnd = nullptr;
     WindowState m_windowState;
 };
 } // namespace window
@@ -0,0 +1,237 @@
+//
+// main.cpp - Renders a binary engine log (logs/engine.blog) back into text
+//
+// usage: logdecode <engine.blog> [output.log]
+//
+
+#include "AsyncLogger.h"
+#include "BinaryLog.h"
+#include "LogFormat.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace logging;
+
+namespace
+{
+
+struct Descriptor
+{
+    uint8_t level = 0;
+    std::vector<ArgType> types;
+    std::string format;
+};
+
+class Reader
+{
+public:
+    explicit Reader(const std::vector<char>& bytes) :
+        m_data(bytes.data()),
+        m_end(bytes.data() + bytes.size())
+    {
+    }
+
+    bool AtEnd() const { return m_data == m_end; }
+
+    template <typename T>
+    bool Read(T& value)
+    {
+        if (static_cast<size_t>(m_end - m_data) < sizeof(T)) return false;
+        memcpy(&value, m_data, sizeof(T));
+        m_data += sizeof(T);
+        return true;
+    }
+
+    bool ReadVarint(uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && m_data != m_end; shift += 7) {
+            auto byte = static_cast<uint8_t>(*m_data++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool Read(std::string_view& bytes, size_t count)
+    {
+        if (static_cast<size_t>(m_end - m_data) < count) return false;
+        bytes = {m_data, count};
+        m_data += count;
+        return true;
+    }
+
+private:
+    const char* m_data;
+    const char* m_end;
+};
+
+// Appends one decoded argument to `text`
+bool DecodeArg(Reader& payload, ArgType type, std::string& text)
+{
+    char number[32];
+    uint64_t varint;
+
+    switch (type) {
+    case ArgType::I32:
+    case ArgType::I64:
+        if (!payload.ReadVarint(varint)) return false;
+        snprintf(number, sizeof(number), "%lld", static_cast<long long>(UnZigZag(varint)));
+        break;
+    case ArgType::U32:
+    case ArgType::U64:
+        if (!payload.ReadVarint(varint)) return false;
+        snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(varint));
+        break;
+    case ArgType::F32: {
+        float v;
+        if (!payload.Read(v)) return false;
+        snprintf(number, sizeof(number), "%g", v);
+        break;
+    }
+    case ArgType::F64: {
+        double v;
+        if (!payload.Read(v)) return false;
+        snprintf(number, sizeof(number), "%g", v);
+        break;
+    }
+    case ArgType::BOOL: {
+        bool v;
+        if (!payload.Read(v)) return false;
+        snprintf(number, sizeof(number), "%s", v ? "true" : "false");
+        break;
+    }
+    case ArgType::STR: {
+        uint8_t length;
+        std::string_view s;
+        if (!payload.Read(length) || !payload.Read(s, length)) return false;
+        text.append(s);
+        return true;
+    }
+    default:
+        return false;
+    }
+
+    text.append(number);
+    return true;
+}
+
+// Substitutes "{}" placeholders in order
+void Render(const Descriptor& descriptor, const std::vector<char>& bytes, std::string& text)
+{
+    Reader payload(bytes);
+    size_t arg = 0;
+
+    const std::string& format = descriptor.format;
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && arg < descriptor.types.size()) {
+            if (!DecodeArg(payload, descriptor.types[arg++], text))
+                text.append("<?>");
+            i++;
+        }
+        else {
+            text.push_back(format[i]);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: logdecode <engine.blog> [output.log]\n");
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        fprintf(stderr, "logdecode: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<char> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    FILE* out = argc > 2 ? fopen(argv[2], "wb") : stdout;
+    if (!out) {
+        fprintf(stderr, "logdecode: cannot create %s\n", argv[2]);
+        return 1;
+    }
+
+    Reader reader(bytes);
+
+    BinaryFileHeader header{};
+    if (!reader.Read(header) || memcmp(header.magic, BinaryFileHeader::Magic, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "logdecode: %s is not a binary engine log\n", argv[1]);
+        return 1;
+    }
+    if (header.version != BinaryFileHeader::CurrentVersion) {
+        fprintf(stderr, "logdecode: unsupported version %u\n", header.version);
+        return 1;
+    }
+
+    RecordFormatter formatter(TimestampCache(header.anchorWall, header.anchorSteady));
+    std::unordered_map<uint16_t, Descriptor> descriptors;
+
+    std::string text;
+    std::vector<char> payload;
+    size_t records = 0;
+    uint64_t timestamp = header.anchorSteady;
+
+    while (!reader.AtEnd()) {
+        BinaryEntry entry;
+        if (!reader.Read(entry)) break;
+
+        if (entry == BinaryEntry::DESCRIPTOR) {
+            Descriptor descriptor;
+            uint16_t id;
+            uint8_t argc;
+            uint16_t length;
+            std::string_view types, format;
+
+            if (!reader.Read(id) || !reader.Read(descriptor.level) || !reader.Read(argc) || !reader.Read(types, argc)
+                || !reader.Read(length) || !reader.Read(format, length))
+                break;
+
+            for (char type : types) {
+                descriptor.types.push_back(static_cast<ArgType>(type));
+            }
+            descriptor.format = format;
+            descriptors[id] = std::move(descriptor);
+        }
+        else if (entry == BinaryEntry::RECORD) {
+            uint64_t id, delta, size;
+            std::string_view bytes;
+
+            if (!reader.ReadVarint(id) || !reader.ReadVarint(delta) || !reader.ReadVarint(size)
+                || !reader.Read(bytes, size))
+                break;
+
+            timestamp += static_cast<uint64_t>(UnZigZag(delta));
+
+            auto it = descriptors.find(static_cast<uint16_t>(id));
+            if (it == descriptors.end()) continue;
+
+            payload.assign(bytes.begin(), bytes.end());
+            text.clear();
+            Render(it->second, payload, text);
+
+            auto level = static_cast<AsyncLogger::LogLevel>(it->second.level);
+            auto line = formatter.Format(timestamp, AsyncLogger::levelToString(level), text);
+            fwrite(line.data(), 1, line.size(), out);
+            records++;
+        }
+        else {
+            fprintf(stderr, "logdecode: corrupt entry, stopping\n");
+            break;
+        }
+    }
+
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "logdecode: %zu records\n", records);
+    return 0;
+}